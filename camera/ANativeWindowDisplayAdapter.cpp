@@ -96,6 +96,9 @@ ANativeWindowDisplayAdapter::ANativeWindowDisplayAdapter():mDisplayThread(NULL),
     mPixelFormat = NULL;
     mBuffers = NULL;
     mOffsetsMap = NULL;
+    mSlots = NULL;
+    mHeldSlot = -1;
+    mDequeueAhead = false;
     mFrameProvider = NULL;
     mANativeWindow = NULL;
 
@@ -398,7 +401,7 @@ int ANativeWindowDisplayAdapter::disableDisplay(bool cancel_buffer)
 
        if(cancel_buffer)
         {
-        // Return the buffers to ANativeWindow here, the mFramesWithCameraAdapterMap is also cleared inside
+        // Return the buffers to ANativeWindow here, the per-slot camera ownership is also cleared inside
         returnBuffersToWindow();
         }
        else
@@ -406,8 +409,6 @@ int ANativeWindowDisplayAdapter::disableDisplay(bool cancel_buffer)
         CAMHAL_LOGEA("disableDisplay: resetting mANativeWindow to NULL");
         returnBuffersToWindow();
         mANativeWindow = NULL;
-        // Clear the frames with camera adapter map
-        mFramesWithCameraAdapterMap.clear();
         }
 
 
@@ -464,8 +465,6 @@ CameraBuffer* ANativeWindowDisplayAdapter::allocateBufferList(int width, int hei
     mBuffers = new CameraBuffer [lnumBufs];
     memset (mBuffers, 0, sizeof(CameraBuffer) * lnumBufs);
 
-    mFramesType.clear();
-
     if ( NULL == mANativeWindow ) {
         return NULL;
     }
@@ -501,6 +500,18 @@ CameraBuffer* ANativeWindowDisplayAdapter::allocateBufferList(int width, int hei
     CAMHAL_LOGDB("Configuring %d buffers for ANativeWindow", numBufs);
     mBufferCount = numBufs;
 
+    if ( NULL != mSlots ) {
+        delete [] mSlots;
+    }
+    mSlotTable.clear();
+    mSlots = new BufferSlot[mBufferCount];
+    for ( i = 0; i < mBufferCount; i++ ) {
+        mSlots[i].mFrameType = -1;
+        mSlots[i].mWithCamera = false;
+    }
+    mHeldSlot = -1;
+    mDequeueAhead = false;
+
 
     // Set window geometry
     err = mANativeWindow->set_buffers_geometry(
@@ -558,18 +569,19 @@ CameraBuffer* ANativeWindowDisplayAdapter::allocateBufferList(int width, int hei
         mBuffers[i].opaque = (void *)handle;
         mBuffers[i].type = CAMERA_BUFFER_ANW;
         mBuffers[i].format = mPixelFormat;
-        mFramesWithCameraAdapterMap.add(handle, i);
+        mSlots[i].mWithCamera = true;
 
         // Tag remaining preview buffers as preview frames
         if ( i >= ( mBufferCount - undequeued ) ) {
-            mFramesType.add( (int) mBuffers[i].opaque,
-                            CameraFrame::PREVIEW_FRAME_SYNC);
+            mSlots[i].mFrameType = CameraFrame::PREVIEW_FRAME_SYNC;
         }
 
         bytes = CameraHal::calculateBufferSize(format, width, height);
 
     }
 
+    mSlotTable.build(mBuffers, mBufferCount);
+
     // lock the initial queueable buffers
     bounds.left = 0;
     bounds.top = 0;
@@ -607,7 +619,7 @@ CameraBuffer* ANativeWindowDisplayAdapter::allocateBufferList(int width, int hei
 
             goto fail;
         }
-        mFramesWithCameraAdapterMap.removeItem((buffer_handle_t *) mBuffers[i].opaque);
+        mSlots[i].mWithCamera = false;
         //LOCK UNLOCK TO GET YUV POINTERS
         void *y_uv[2];
         mapper.lock(*(buffer_handle_t *) mBuffers[i].opaque, CAMHAL_GRALLOC_USAGE, bounds, y_uv);
@@ -616,6 +628,14 @@ CameraBuffer* ANativeWindowDisplayAdapter::allocateBufferList(int width, int hei
         mapper.unlock(*(buffer_handle_t *) mBuffers[i].opaque);
     }
 
+    // Keep the last queueable buffer back from the frame provider, it becomes
+    // the first buffer held by the display thread's dequeue-ahead stage
+    if ( ( mBufferCount - undequeued ) > 1 ) {
+        mHeldSlot = mBufferCount - undequeued - 1;
+        mSlots[mHeldSlot].mFrameType = CameraFrame::PREVIEW_FRAME_SYNC;
+        mDequeueAhead = true;
+    }
+
     mFirstInit = true;
     mFrameWidth = width;
     mFrameHeight = height;
@@ -631,7 +651,7 @@ CameraBuffer* ANativeWindowDisplayAdapter::allocateBufferList(int width, int hei
           CAMHAL_LOGE("Surface::cancelBuffer failed w/ error 0x%08x", err);
           break;
         }
-        mFramesWithCameraAdapterMap.removeItem((buffer_handle_t *) mBuffers[start].opaque);
+        mSlots[start].mWithCamera = false;
     }
 
     freeBufferList(mBuffers);
@@ -751,6 +771,11 @@ status_t ANativeWindowDisplayAdapter::maxQueueableBuffers(unsigned int& queueabl
 
     queueable = mBufferCount - undequeued;
 
+    // The buffer held by the dequeue-ahead stage is handed out on the first frame return
+    if ( mDequeueAhead ) {
+        queueable--;
+    }
+
  end:
     return ret;
     LOG_FUNCTION_NAME_EXIT;
@@ -782,17 +807,14 @@ status_t ANativeWindowDisplayAdapter::returnBuffersToWindow()
 
      android::GraphicBufferMapper &mapper = android::GraphicBufferMapper::get();
     //Give the buffers back to display here -  sort of free it
-     if (mANativeWindow)
-         for(unsigned int i = 0; i < mFramesWithCameraAdapterMap.size(); i++) {
-             int value = mFramesWithCameraAdapterMap.valueAt(i);
-             buffer_handle_t *handle = (buffer_handle_t *) mBuffers[value].opaque;
-
-             // if buffer index is out of bounds skip
-             if ((value < 0) || (value >= mBufferCount)) {
-                 CAMHAL_LOGEA("Potential out bounds access to handle...skipping");
+     if ( mANativeWindow && mBuffers && mSlots )
+         for(int i = 0; i < mBufferCount; i++) {
+             if (!mSlots[i].mWithCamera) {
                  continue;
              }
 
+             buffer_handle_t *handle = (buffer_handle_t *) mBuffers[i].opaque;
+
              if (!mUseExternalBufferLocking) {
                  // unlock buffer before giving it up
                  mapper.unlock(*handle);
@@ -801,21 +823,27 @@ status_t ANativeWindowDisplayAdapter::returnBuffersToWindow()
              ret = mANativeWindow->cancel_buffer(mANativeWindow, handle);
              if ( NO_INIT == ret ) {
                  CAMHAL_LOGEA("Preview surface abandoned!");
-                 returnBuffersToWindow();
                  mANativeWindow = NULL;
-                 return ret;
+                 break;
              } else if ( NO_ERROR != ret ) {
                  CAMHAL_LOGE("Surface::cancelBuffer() failed: %s (%d)",
                               strerror(-ret),
                               -ret);
                 return ret;
              }
+
+             mSlots[i].mWithCamera = false;
          }
-     else
+     else if ( !mANativeWindow )
          CAMHAL_LOGE("mANativeWindow is NULL");
 
-     ///Clear the frames with camera adapter map
-     mFramesWithCameraAdapterMap.clear();
+     ///Nothing is left with the camera adapter, including the dequeued-ahead buffer
+     if ( NULL != mSlots ) {
+         for ( int i = 0; i < mBufferCount; i++ ) {
+             mSlots[i].mWithCamera = false;
+         }
+     }
+     mHeldSlot = -1;
 
      return ret;
 
@@ -864,7 +892,15 @@ int ANativeWindowDisplayAdapter::freeBufferList(CameraBuffer * buflist)
         mFD = -1;
     }
 
-    mFramesType.clear();
+    if ( NULL != mSlots )
+    {
+        delete [] mSlots;
+        mSlots = NULL;
+    }
+
+    mSlotTable.clear();
+
+    mDequeueAhead = false;
 
     return NO_ERROR;
 }
@@ -1027,17 +1063,17 @@ status_t ANativeWindowDisplayAdapter::PostFrame(ANativeWindowDisplayAdapter::Dis
         return NO_INIT;
     }
 
-    if (!mBuffers || !dispFrame.mBuffer) {
+    if (!mBuffers || !mSlots || !dispFrame.mBuffer) {
         CAMHAL_LOGEA("NULL sent to PostFrame");
         return BAD_VALUE;
     }
 
-    for ( i = 0; i < mBufferCount; i++ )
-    {
-        if ( dispFrame.mBuffer == &mBuffers[i] )
-        {
-            break;
-        }
+    CAMHAL_TRACE_FRAME(dispFrame.mBuffer, STAGE_DISPLAY_POST);
+
+    i = dispFrame.mBuffer - mBuffers;
+    if ( ( i < 0 ) || ( i >= mBufferCount ) ) {
+        CAMHAL_LOGEB("Buffer %p is not a display buffer", dispFrame.mBuffer);
+        return BAD_VALUE;
     }
 
 #if PPM_INSTRUMENTATION || PPM_INSTRUMENTATION_ABS
@@ -1057,7 +1093,7 @@ status_t ANativeWindowDisplayAdapter::PostFrame(ANativeWindowDisplayAdapter::Dis
 
     android::AutoMutex lock(mLock);
 
-    mFramesType.add( (int)mBuffers[i].opaque, dispFrame.mType);
+    mSlots[i].mFrameType = dispFrame.mType;
 
     if ( mDisplayState == ANativeWindowDisplayAdapter::DISPLAY_STARTED &&
                 (!mPaused ||  CameraFrame::CameraFrame::SNAPSHOT_FRAME == dispFrame.mType) &&
@@ -1090,12 +1126,13 @@ status_t ANativeWindowDisplayAdapter::PostFrame(ANativeWindowDisplayAdapter::Dis
                 mapper.unlock(*handle);
             }
             ret = mANativeWindow->enqueue_buffer(mANativeWindow, handle);
+            CAMHAL_TRACE_FRAME(dispFrame.mBuffer, STAGE_DISPLAY_ENQUEUE);
         }
         if ( NO_ERROR != ret ) {
             CAMHAL_LOGE("Surface::queueBuffer returned error %d", ret);
         }
 
-        mFramesWithCameraAdapterMap.removeItem((buffer_handle_t *) dispFrame.mBuffer->opaque);
+        mSlots[i].mWithCamera = false;
 
 
         // HWComposer has not minimum buffer requirement. We should be able to dequeue
@@ -1118,7 +1155,7 @@ status_t ANativeWindowDisplayAdapter::PostFrame(ANativeWindowDisplayAdapter::Dis
             CAMHAL_LOGE("Surface::cancelBuffer returned error %d", ret);
         }
 
-        mFramesWithCameraAdapterMap.removeItem((buffer_handle_t *) dispFrame.mBuffer->opaque);
+        mSlots[i].mWithCamera = false;
 
         Utils::Message msg;
         mDisplayQ.put(&msg);
@@ -1134,11 +1171,12 @@ bool ANativeWindowDisplayAdapter::handleFrameReturn()
     status_t err;
     buffer_handle_t *buf;
     int i = 0;
-    unsigned int k;
+    int held = -1;
     int stride;  // dummy variable to get stride
     android::GraphicBufferMapper &mapper = android::GraphicBufferMapper::get();
     android::Rect bounds;
     CameraFrame::FrameType frameType = CameraFrame::PREVIEW_FRAME_SYNC;
+    CameraFrame::FrameType heldType = CameraFrame::PREVIEW_FRAME_SYNC;
 
     void *y_uv[2];
 
@@ -1148,6 +1186,24 @@ bool ANativeWindowDisplayAdapter::handleFrameReturn()
         return false;
     }
 
+    // Hand the buffer dequeued ahead back right away, so the camera adapter
+    // does not wait for the compositor to release the next one
+    {
+        android::AutoMutex lock(mLock);
+        if ( mHeldSlot >= 0 ) {
+            held = mHeldSlot;
+            heldType = (CameraFrame::FrameType) mSlots[held].mFrameType;
+            mSlots[held].mFrameType = -1;
+            mHeldSlot = -1;
+        }
+    }
+
+    if ( held >= 0 ) {
+        CAMHAL_LOGVB("handleFrameReturn: returning held graphic buffer %d of %d", held, mBufferCount-1);
+        CAMHAL_TRACE_FRAME(&mBuffers[held], STAGE_RETURN);
+        mFrameProvider->returnFrame(&mBuffers[held], heldType);
+    }
+
     err = mANativeWindow->dequeue_buffer(mANativeWindow, &buf, &stride);
     if (err != 0) {
         CAMHAL_LOGE("Surface::dequeueBuffer failed: %s (%d)", strerror(-err), -err);
@@ -1174,14 +1230,12 @@ bool ANativeWindowDisplayAdapter::handleFrameReturn()
         return false;
     }
 
-    for(i = 0; i < mBufferCount; i++)
-    {
-        if (mBuffers[i].opaque == buf)
-            break;
-    }
-    if (i == mBufferCount) {
+    i = mSlotTable.find(buf);
+    if ( i < 0 ) {
         CAMHAL_LOGEB("Failed to find handle %p", buf);
+        return false;
     }
+
     if (!mUseExternalBufferLocking) {
         // lock buffer before sending to FrameProvider for filling
         bounds.left = 0;
@@ -1204,23 +1258,25 @@ bool ANativeWindowDisplayAdapter::handleFrameReturn()
 
     {
         android::AutoMutex lock(mLock);
-        mFramesWithCameraAdapterMap.add((buffer_handle_t *) mBuffers[i].opaque, i);
+        mSlots[i].mWithCamera = true;
 
-        for( k = 0; k < mFramesType.size() ; k++) {
-            if(mFramesType.keyAt(k) == (int)mBuffers[i].opaque)
-                break;
-        }
-
-        if ( k == mFramesType.size() ) {
+        if ( mSlots[i].mFrameType < 0 ) {
             CAMHAL_LOGE("Frame type for preview buffer 0%x not found!!", mBuffers[i].opaque);
             return false;
         }
 
-        frameType = (CameraFrame::FrameType) mFramesType.valueAt(k);
-        mFramesType.removeItem((int) mBuffers[i].opaque);
+        // Keep this one dequeued and locked until the next frame return
+        if ( mDequeueAhead ) {
+            mHeldSlot = i;
+            return true;
+        }
+
+        frameType = (CameraFrame::FrameType) mSlots[i].mFrameType;
+        mSlots[i].mFrameType = -1;
     }
 
     CAMHAL_LOGVB("handleFrameReturn: found graphic buffer %d of %d", i, mBufferCount-1);
+    CAMHAL_TRACE_FRAME(&mBuffers[i], STAGE_RETURN);
     mFrameProvider->returnFrame(&mBuffers[i], frameType);
 
     return true;
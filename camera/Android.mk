@@ -41,6 +41,11 @@ ifdef TI_CAMERAHAL_PROFILING
     TI_CAMERAHAL_COMMON_CFLAGS += -DCAMERAHAL_OMX_PROFILING
 endif
 
+ifdef TI_CAMERAHAL_FRAME_TRACE
+    # Enable per-frame preview latency tracing, reported through dump()
+    TI_CAMERAHAL_COMMON_CFLAGS += -DCAMERAHAL_FRAME_TRACE
+endif
+
 ifdef TI_CAMERAHAL_MAX_CAMERAS_SUPPORTED
     TI_CAMERAHAL_COMMON_CFLAGS += -DMAX_CAMERAS_SUPPORTED=$(TI_CAMERAHAL_MAX_CAMERAS_SUPPORTED)
 endif
@@ -118,6 +123,8 @@ TI_CAMERAHAL_COMMON_SRC := \
     Decoder_libjpeg.cpp \
     SensorListener.cpp  \
     NV12_resize.cpp \
+    YuvConverter.cpp \
+    FrameTracer.cpp \
     CameraParameters.cpp \
     TICameraParameters.cpp \
     CameraHalCommon.cpp \
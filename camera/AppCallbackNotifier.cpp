@@ -990,6 +990,8 @@ void AppCallbackNotifier::notifyFrame()
                     break;
                     }
 
+                CAMHAL_TRACE_FRAME(frame->mBuffer, STAGE_APP_CALLBACK);
+
                 if ( (CameraFrame::RAW_FRAME == frame->mFrameType )&&
                     ( NULL != mCameraHal ) &&
                     ( NULL != mDataCb) &&
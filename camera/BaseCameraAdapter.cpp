@@ -59,6 +59,196 @@ const LUTtypeHAL CamCommandsLUT = {
     cameraCommandsUserToHAL
 };
 
+/*--------------------Adapter state transitions-----------------------------*/
+
+struct AdapterTransition {
+    CameraAdapter::AdapterState from;
+    CameraAdapter::CameraCommands operation;
+    CameraAdapter::AdapterState to;
+};
+
+#define ADAPTER_TRANSITION(from, operation, to) \
+    { CameraAdapter::from, CameraAdapter::operation, CameraAdapter::to }
+
+// Every command accepted in each adapter state and the state it leads to,
+// anything not listed here is rejected with INVALID_OPERATION
+static const AdapterTransition sAdapterTransitions[] = {
+    ADAPTER_TRANSITION(INTIALIZED_STATE,            CAMERA_USE_BUFFERS_PREVIEW,             LOADED_PREVIEW_STATE),
+    ADAPTER_TRANSITION(INTIALIZED_STATE,            CAMERA_QUERY_RESOLUTION_PREVIEW,        INTIALIZED_STATE),
+    ADAPTER_TRANSITION(INTIALIZED_STATE,            CAMERA_QUERY_BUFFER_SIZE_PREVIEW_DATA,  INTIALIZED_STATE),
+
+    ADAPTER_TRANSITION(LOADED_PREVIEW_STATE,        CAMERA_START_PREVIEW,                   PREVIEW_STATE),
+    ADAPTER_TRANSITION(LOADED_PREVIEW_STATE,        CAMERA_STOP_PREVIEW,                    INTIALIZED_STATE),
+    ADAPTER_TRANSITION(LOADED_PREVIEW_STATE,        CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE, LOADED_PREVIEW_STATE),
+    ADAPTER_TRANSITION(LOADED_PREVIEW_STATE,        CAMERA_QUERY_BUFFER_SIZE_PREVIEW_DATA,  LOADED_PREVIEW_STATE),
+    ADAPTER_TRANSITION(LOADED_PREVIEW_STATE,        CAMERA_USE_BUFFERS_PREVIEW_DATA,        LOADED_PREVIEW_STATE),
+
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_STOP_PREVIEW,                    INTIALIZED_STATE),
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_PERFORM_AUTOFOCUS,               AF_STATE),
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_START_SMOOTH_ZOOM,               ZOOM_STATE),
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_USE_BUFFERS_IMAGE_CAPTURE,       LOADED_CAPTURE_STATE),
+#ifdef OMAP_ENHANCEMENT_CPCAM
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_USE_BUFFERS_REPROCESS,           LOADED_REPROCESS_STATE),
+#endif
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_START_VIDEO,                     VIDEO_STATE),
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_CANCEL_AUTOFOCUS,                PREVIEW_STATE),
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE, PREVIEW_STATE),
+    ADAPTER_TRANSITION(PREVIEW_STATE,               CAMERA_STOP_SMOOTH_ZOOM,                PREVIEW_STATE),
+
+#ifdef OMAP_ENHANCEMENT_CPCAM
+    ADAPTER_TRANSITION(LOADED_REPROCESS_STATE,      CAMERA_USE_BUFFERS_IMAGE_CAPTURE,       LOADED_REPROCESS_CAPTURE_STATE),
+    ADAPTER_TRANSITION(LOADED_REPROCESS_STATE,      CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE, LOADED_REPROCESS_STATE),
+
+    ADAPTER_TRANSITION(LOADED_REPROCESS_CAPTURE_STATE, CAMERA_START_IMAGE_CAPTURE,          REPROCESS_STATE),
+#endif
+
+    ADAPTER_TRANSITION(LOADED_CAPTURE_STATE,        CAMERA_START_IMAGE_CAPTURE,             CAPTURE_STATE),
+    ADAPTER_TRANSITION(LOADED_CAPTURE_STATE,        CAMERA_START_BRACKET_CAPTURE,           BRACKETING_STATE),
+    //Raw capture path, the following CAMERA_START_IMAGE_CAPTURE moves the state on
+    ADAPTER_TRANSITION(LOADED_CAPTURE_STATE,        CAMERA_USE_BUFFERS_VIDEO_CAPTURE,       LOADED_CAPTURE_STATE),
+
+    ADAPTER_TRANSITION(CAPTURE_STATE,               CAMERA_STOP_IMAGE_CAPTURE,              PREVIEW_STATE),
+    ADAPTER_TRANSITION(CAPTURE_STATE,               CAMERA_STOP_BRACKET_CAPTURE,            PREVIEW_STATE),
+    ADAPTER_TRANSITION(CAPTURE_STATE,               CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE, CAPTURE_STATE),
+    ADAPTER_TRANSITION(CAPTURE_STATE,               CAMERA_START_IMAGE_CAPTURE,             CAPTURE_STATE),
+#ifdef OMAP_ENHANCEMENT_CPCAM
+    ADAPTER_TRANSITION(CAPTURE_STATE,               CAMERA_USE_BUFFERS_REPROCESS,           LOADED_REPROCESS_STATE),
+#endif
+
+    ADAPTER_TRANSITION(BRACKETING_STATE,            CAMERA_STOP_IMAGE_CAPTURE,              PREVIEW_STATE),
+    ADAPTER_TRANSITION(BRACKETING_STATE,            CAMERA_STOP_BRACKET_CAPTURE,            PREVIEW_STATE),
+    ADAPTER_TRANSITION(BRACKETING_STATE,            CAMERA_START_IMAGE_CAPTURE,             CAPTURE_STATE),
+
+    ADAPTER_TRANSITION(AF_STATE,                    CAMERA_CANCEL_AUTOFOCUS,                PREVIEW_STATE),
+    ADAPTER_TRANSITION(AF_STATE,                    CAMERA_START_IMAGE_CAPTURE,             CAPTURE_STATE),
+    ADAPTER_TRANSITION(AF_STATE,                    CAMERA_START_SMOOTH_ZOOM,               AF_ZOOM_STATE),
+    ADAPTER_TRANSITION(AF_STATE,                    CAMERA_START_VIDEO,                     VIDEO_STATE),
+
+    ADAPTER_TRANSITION(ZOOM_STATE,                  CAMERA_CANCEL_AUTOFOCUS,                ZOOM_STATE),
+    ADAPTER_TRANSITION(ZOOM_STATE,                  CAMERA_STOP_SMOOTH_ZOOM,                PREVIEW_STATE),
+    ADAPTER_TRANSITION(ZOOM_STATE,                  CAMERA_PERFORM_AUTOFOCUS,               AF_ZOOM_STATE),
+    ADAPTER_TRANSITION(ZOOM_STATE,                  CAMERA_START_VIDEO,                     VIDEO_ZOOM_STATE),
+
+    ADAPTER_TRANSITION(VIDEO_STATE,                 CAMERA_STOP_VIDEO,                      PREVIEW_STATE),
+    ADAPTER_TRANSITION(VIDEO_STATE,                 CAMERA_PERFORM_AUTOFOCUS,               VIDEO_AF_STATE),
+    ADAPTER_TRANSITION(VIDEO_STATE,                 CAMERA_START_SMOOTH_ZOOM,               VIDEO_ZOOM_STATE),
+    ADAPTER_TRANSITION(VIDEO_STATE,                 CAMERA_USE_BUFFERS_IMAGE_CAPTURE,       VIDEO_LOADED_CAPTURE_STATE),
+    ADAPTER_TRANSITION(VIDEO_STATE,                 CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE, VIDEO_STATE),
+
+    ADAPTER_TRANSITION(VIDEO_AF_STATE,              CAMERA_CANCEL_AUTOFOCUS,                VIDEO_STATE),
+    ADAPTER_TRANSITION(VIDEO_AF_STATE,              CAMERA_USE_BUFFERS_IMAGE_CAPTURE,       VIDEO_LOADED_CAPTURE_STATE),
+    ADAPTER_TRANSITION(VIDEO_AF_STATE,              CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE, VIDEO_AF_STATE),
+
+    ADAPTER_TRANSITION(VIDEO_LOADED_CAPTURE_STATE,  CAMERA_START_IMAGE_CAPTURE,             VIDEO_CAPTURE_STATE),
+
+    ADAPTER_TRANSITION(VIDEO_CAPTURE_STATE,         CAMERA_STOP_IMAGE_CAPTURE,              VIDEO_STATE),
+
+    ADAPTER_TRANSITION(AF_ZOOM_STATE,               CAMERA_STOP_SMOOTH_ZOOM,                AF_STATE),
+    ADAPTER_TRANSITION(AF_ZOOM_STATE,               CAMERA_CANCEL_AUTOFOCUS,                ZOOM_STATE),
+
+    ADAPTER_TRANSITION(VIDEO_ZOOM_STATE,            CAMERA_STOP_SMOOTH_ZOOM,                VIDEO_STATE),
+    ADAPTER_TRANSITION(VIDEO_ZOOM_STATE,            CAMERA_STOP_VIDEO,                      ZOOM_STATE),
+
+    ADAPTER_TRANSITION(BRACKETING_ZOOM_STATE,       CAMERA_STOP_SMOOTH_ZOOM,                BRACKETING_STATE),
+
+#ifdef OMAP_ENHANCEMENT_CPCAM
+    ADAPTER_TRANSITION(REPROCESS_STATE,             CAMERA_STOP_IMAGE_CAPTURE,              PREVIEW_STATE),
+    ADAPTER_TRANSITION(REPROCESS_STATE,             CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE, REPROCESS_STATE),
+    ADAPTER_TRANSITION(REPROCESS_STATE,             CAMERA_START_IMAGE_CAPTURE,             REPROCESS_STATE),
+    ADAPTER_TRANSITION(REPROCESS_STATE,             CAMERA_USE_BUFFERS_REPROCESS,           LOADED_REPROCESS_STATE),
+    ADAPTER_TRANSITION(REPROCESS_STATE,             CAMERA_USE_BUFFERS_IMAGE_CAPTURE,       LOADED_CAPTURE_STATE),
+#endif
+};
+
+#undef ADAPTER_TRANSITION
+
+struct AdapterStateName {
+    CameraAdapter::AdapterState state;
+    const char *name;
+};
+
+#define ADAPTER_STATE(state) { CameraAdapter::state, #state }
+
+static const AdapterStateName sAdapterStates[] = {
+    ADAPTER_STATE(INTIALIZED_STATE),
+    ADAPTER_STATE(LOADED_PREVIEW_STATE),
+    ADAPTER_STATE(PREVIEW_STATE),
+    ADAPTER_STATE(LOADED_CAPTURE_STATE),
+    ADAPTER_STATE(CAPTURE_STATE),
+    ADAPTER_STATE(BRACKETING_STATE),
+    ADAPTER_STATE(AF_STATE),
+    ADAPTER_STATE(ZOOM_STATE),
+    ADAPTER_STATE(VIDEO_STATE),
+    ADAPTER_STATE(VIDEO_AF_STATE),
+    ADAPTER_STATE(VIDEO_ZOOM_STATE),
+    ADAPTER_STATE(VIDEO_LOADED_CAPTURE_STATE),
+    ADAPTER_STATE(VIDEO_CAPTURE_STATE),
+    ADAPTER_STATE(AF_ZOOM_STATE),
+    ADAPTER_STATE(BRACKETING_ZOOM_STATE),
+    ADAPTER_STATE(LOADED_REPROCESS_STATE),
+    ADAPTER_STATE(LOADED_REPROCESS_CAPTURE_STATE),
+    ADAPTER_STATE(REPROCESS_STATE),
+};
+
+#undef ADAPTER_STATE
+
+/**
+ * Dense [state][command] form of sAdapterTransitions, built once at load
+ * time so that a state switch is a single table lookup.
+ */
+class AdapterTransitionMatrix
+{
+public:
+    AdapterTransitionMatrix()
+    {
+        memset(mNext, -1, sizeof(mNext));
+
+        for ( size_t i = 0 ; i < sizeof(sAdapterTransitions) / sizeof(sAdapterTransitions[0]) ; i++ ) {
+            const AdapterTransition &transition = sAdapterTransitions[i];
+            mNext[indexOf(transition.from)][transition.operation] = indexOf(transition.to);
+        }
+    }
+
+    bool lookup(CameraAdapter::AdapterState from, CameraAdapter::CameraCommands operation,
+                CameraAdapter::AdapterState &to) const
+    {
+        const int state = indexOf(from);
+
+        if ( ( state < 0 ) || ( operation < 0 ) || ( operation >= COMMAND_COUNT ) ||
+             ( mNext[state][operation] < 0 ) ) {
+            return false;
+        }
+
+        to = sAdapterStates[mNext[state][operation]].state;
+        return true;
+    }
+
+    static const char *nameOf(CameraAdapter::AdapterState state)
+    {
+        const int index = indexOf(state);
+        return ( index < 0 ) ? "UNKNOWN_STATE" : sAdapterStates[index].name;
+    }
+
+private:
+    static const int STATE_COUNT = sizeof(sAdapterStates) / sizeof(sAdapterStates[0]);
+    static const int COMMAND_COUNT = CameraAdapter::CAMERA_PREVIEW_INITIALIZATION + 1;
+
+    static int indexOf(CameraAdapter::AdapterState state)
+    {
+        for ( int i = 0 ; i < STATE_COUNT ; i++ ) {
+            if ( sAdapterStates[i].state == state ) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    int8_t mNext[STATE_COUNT][COMMAND_COUNT];
+};
+
+static const AdapterTransitionMatrix sAdapterTransitionMatrix;
+
 /*--------------------Camera Adapter Class STARTS here-----------------------------*/
 
 BaseCameraAdapter::BaseCameraAdapter()
@@ -87,9 +277,13 @@ BaseCameraAdapter::BaseCameraAdapter()
     mPreviewDataBuffersLength = 0;
 
     mAdapterState = INTIALIZED_STATE;
+    mNextState = INTIALIZED_STATE;
 
     mSharedAllocator = NULL;
 
+    mSubscribers = new SubscriberSet();
+    mDispatchers = 0;
+
 #if PPM_INSTRUMENTATION || PPM_INSTRUMENTATION_ABS
     mStartFocus.tv_sec = 0;
     mStartFocus.tv_usec = 0;
@@ -105,16 +299,8 @@ BaseCameraAdapter::~BaseCameraAdapter()
 
      android::AutoMutex lock(mSubscriberLock);
 
-     mFrameSubscribers.clear();
-     mImageSubscribers.clear();
-     mRawSubscribers.clear();
-     mVideoSubscribers.clear();
-     mVideoInSubscribers.clear();
-     mFocusSubscribers.clear();
-     mShutterSubscribers.clear();
-     mZoomSubscribers.clear();
-     mSnapshotSubscribers.clear();
-     mMetadataSubscribers.clear();
+     delete mSubscribers;
+     mSubscribers = NULL;
 
      LOG_FUNCTION_NAME_EXIT;
 }
@@ -178,35 +364,20 @@ void BaseCameraAdapter::enableMsgType(int32_t msgs, frame_callback callback, eve
     int32_t frameMsg = ((msgs >> MessageNotifier::FRAME_BIT_FIELD_POSITION) & EVENT_MASK);
     int32_t eventMsg = ((msgs >> MessageNotifier::EVENT_BIT_FIELD_POSITION) & EVENT_MASK);
 
+    SubscriberSet *subscribers = new SubscriberSet(*mSubscribers);
+
     if ( frameMsg != 0 )
         {
         CAMHAL_LOGVB("Frame message type id=0x%x subscription request", frameMsg);
-        switch ( frameMsg )
+        android::KeyedVector<int, frame_callback> *frameSubscribers =
+                subscribers->framesFor(static_cast<CameraFrame::FrameType>(frameMsg));
+        if ( NULL != frameSubscribers )
             {
-            case CameraFrame::PREVIEW_FRAME_SYNC:
-                mFrameSubscribers.add((int) cookie, callback);
-                break;
-            case CameraFrame::FRAME_DATA_SYNC:
-                mFrameDataSubscribers.add((int) cookie, callback);
-                break;
-            case CameraFrame::SNAPSHOT_FRAME:
-                mSnapshotSubscribers.add((int) cookie, callback);
-                break;
-            case CameraFrame::IMAGE_FRAME:
-                mImageSubscribers.add((int) cookie, callback);
-                break;
-            case CameraFrame::RAW_FRAME:
-                mRawSubscribers.add((int) cookie, callback);
-                break;
-            case CameraFrame::VIDEO_FRAME_SYNC:
-                mVideoSubscribers.add((int) cookie, callback);
-                break;
-            case CameraFrame::REPROCESS_INPUT_FRAME:
-                mVideoInSubscribers.add((int) cookie, callback);
-                break;
-            default:
-                CAMHAL_LOGEA("Frame message type id=0x%x subscription no supported yet!", frameMsg);
-                break;
+            frameSubscribers->add((int) cookie, callback);
+            }
+        else
+            {
+            CAMHAL_LOGEA("Frame message type id=0x%x subscription no supported yet!", frameMsg);
             }
         }
 
@@ -215,10 +386,10 @@ void BaseCameraAdapter::enableMsgType(int32_t msgs, frame_callback callback, eve
         CAMHAL_LOGVB("Event message type id=0x%x subscription request", eventMsg);
         if ( CameraHalEvent::ALL_EVENTS == eventMsg )
             {
-            mFocusSubscribers.add((int) cookie, eventCb);
-            mShutterSubscribers.add((int) cookie, eventCb);
-            mZoomSubscribers.add((int) cookie, eventCb);
-            mMetadataSubscribers.add((int) cookie, eventCb);
+            subscribers->mFocus.add((int) cookie, eventCb);
+            subscribers->mShutter.add((int) cookie, eventCb);
+            subscribers->mZoom.add((int) cookie, eventCb);
+            subscribers->mMetadata.add((int) cookie, eventCb);
             }
         else
             {
@@ -226,6 +397,8 @@ void BaseCameraAdapter::enableMsgType(int32_t msgs, frame_callback callback, eve
             }
         }
 
+    publishSubscribers(subscribers);
+
     LOG_FUNCTION_NAME_EXIT;
 }
 
@@ -238,44 +411,33 @@ void BaseCameraAdapter::disableMsgType(int32_t msgs, void* cookie)
     int32_t frameMsg = ((msgs >> MessageNotifier::FRAME_BIT_FIELD_POSITION) & EVENT_MASK);
     int32_t eventMsg = ((msgs >> MessageNotifier::EVENT_BIT_FIELD_POSITION) & EVENT_MASK);
 
+    SubscriberSet *subscribers = new SubscriberSet(*mSubscribers);
+
     if ( frameMsg != 0 )
         {
         CAMHAL_LOGVB("Frame message type id=0x%x remove subscription request", frameMsg);
-        switch ( frameMsg )
+        if ( CameraFrame::ALL_FRAMES == frameMsg )
             {
-            case CameraFrame::PREVIEW_FRAME_SYNC:
-                mFrameSubscribers.removeItem((int) cookie);
-                break;
-            case CameraFrame::FRAME_DATA_SYNC:
-                mFrameDataSubscribers.removeItem((int) cookie);
-                break;
-            case CameraFrame::SNAPSHOT_FRAME:
-                mSnapshotSubscribers.removeItem((int) cookie);
-                break;
-            case CameraFrame::IMAGE_FRAME:
-                mImageSubscribers.removeItem((int) cookie);
-                break;
-            case CameraFrame::RAW_FRAME:
-                mRawSubscribers.removeItem((int) cookie);
-                break;
-            case CameraFrame::VIDEO_FRAME_SYNC:
-                mVideoSubscribers.removeItem((int) cookie);
-                break;
-            case CameraFrame::REPROCESS_INPUT_FRAME:
-                mVideoInSubscribers.removeItem((int) cookie);
-                break;
-            case CameraFrame::ALL_FRAMES:
-                mFrameSubscribers.removeItem((int) cookie);
-                mFrameDataSubscribers.removeItem((int) cookie);
-                mSnapshotSubscribers.removeItem((int) cookie);
-                mImageSubscribers.removeItem((int) cookie);
-                mRawSubscribers.removeItem((int) cookie);
-                mVideoSubscribers.removeItem((int) cookie);
-                mVideoInSubscribers.removeItem((int) cookie);
-                break;
-            default:
+            subscribers->mFrame.removeItem((int) cookie);
+            subscribers->mFrameData.removeItem((int) cookie);
+            subscribers->mSnapshot.removeItem((int) cookie);
+            subscribers->mImage.removeItem((int) cookie);
+            subscribers->mRaw.removeItem((int) cookie);
+            subscribers->mVideo.removeItem((int) cookie);
+            subscribers->mVideoIn.removeItem((int) cookie);
+            }
+        else
+            {
+            android::KeyedVector<int, frame_callback> *frameSubscribers =
+                    subscribers->framesFor(static_cast<CameraFrame::FrameType>(frameMsg));
+            if ( NULL != frameSubscribers )
+                {
+                frameSubscribers->removeItem((int) cookie);
+                }
+            else
+                {
                 CAMHAL_LOGEA("Frame message type id=0x%x subscription remove not supported yet!", frameMsg);
-                break;
+                }
             }
         }
 
@@ -285,10 +447,10 @@ void BaseCameraAdapter::disableMsgType(int32_t msgs, void* cookie)
         if ( CameraHalEvent::ALL_EVENTS == eventMsg)
             {
             //TODO: Process case by case
-            mFocusSubscribers.removeItem((int) cookie);
-            mShutterSubscribers.removeItem((int) cookie);
-            mZoomSubscribers.removeItem((int) cookie);
-            mMetadataSubscribers.removeItem((int) cookie);
+            subscribers->mFocus.removeItem((int) cookie);
+            subscribers->mShutter.removeItem((int) cookie);
+            subscribers->mZoom.removeItem((int) cookie);
+            subscribers->mMetadata.removeItem((int) cookie);
             }
         else
             {
@@ -296,13 +458,163 @@ void BaseCameraAdapter::disableMsgType(int32_t msgs, void* cookie)
             }
         }
 
+    publishSubscribers(subscribers);
+
     LOG_FUNCTION_NAME_EXIT;
 }
 
+void BaseCameraAdapter::publishSubscribers(SubscriberSet *subscribers)
+{
+    // Called with mSubscriberLock held. Once this returns no dispatch can
+    // still reach a callback that was removed, so its owner may go away.
+    SubscriberSet *retired = mSubscribers;
+
+    __atomic_store_n(&mSubscribers, subscribers, __ATOMIC_RELEASE);
+
+    // A dispatcher either announced itself in mDispatchers before the swap
+    // or will pick up the new set, android_atomic_inc is a full barrier
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    {
+        android::AutoMutex lock(mDispatchLock);
+        while ( 0 != android_atomic_acquire_load(&mDispatchers) )
+            {
+            mDispatchDone.wait(mDispatchLock);
+            }
+    }
+
+    delete retired;
+}
+
+BaseCameraAdapter::SubscriberRef::SubscriberRef(const BaseCameraAdapter *adapter)
+    : mAdapter(adapter)
+{
+    android_atomic_inc(&mAdapter->mDispatchers);
+    mSet = __atomic_load_n(&mAdapter->mSubscribers, __ATOMIC_ACQUIRE);
+}
+
+BaseCameraAdapter::SubscriberRef::~SubscriberRef()
+{
+    if ( 1 == android_atomic_dec(&mAdapter->mDispatchers) )
+        {
+        android::AutoMutex lock(mAdapter->mDispatchLock);
+        mAdapter->mDispatchDone.broadcast();
+        }
+}
+
+android::KeyedVector<int, frame_callback> *
+BaseCameraAdapter::SubscriberSet::framesFor(CameraFrame::FrameType frameType)
+{
+    switch ( frameType )
+        {
+        case CameraFrame::PREVIEW_FRAME_SYNC:
+            return &mFrame;
+        case CameraFrame::FRAME_DATA_SYNC:
+            return &mFrameData;
+        case CameraFrame::SNAPSHOT_FRAME:
+            return &mSnapshot;
+        case CameraFrame::IMAGE_FRAME:
+            return &mImage;
+        case CameraFrame::RAW_FRAME:
+            return &mRaw;
+        case CameraFrame::VIDEO_FRAME_SYNC:
+            return &mVideo;
+        case CameraFrame::REPROCESS_INPUT_FRAME:
+            return &mVideoIn;
+        default:
+            return NULL;
+        }
+}
+
+const android::KeyedVector<int, frame_callback> *
+BaseCameraAdapter::SubscriberSet::framesFor(CameraFrame::FrameType frameType) const
+{
+    return const_cast<SubscriberSet *>(this)->framesFor(frameType);
+}
+
+size_t BaseCameraAdapter::getSubscriberCount(CameraFrame::FrameType frameType) const
+{
+    SubscriberRef subscribers(this);
+    const android::KeyedVector<int, frame_callback> *frameSubscribers = subscribers->framesFor(frameType);
+
+    return ( NULL != frameSubscribers ) ? frameSubscribers->size() : 0;
+}
+
+status_t BaseCameraAdapter::FrameRefCounts::add(CameraBuffer *buffer, int refCount)
+{
+    if ( NULL == buffer )
+        {
+        return -EINVAL;
+        }
+
+    ssize_t slot = slotOf(buffer);
+    if ( NAME_NOT_FOUND == slot )
+        {
+        if ( MAX_SLOTS <= mCount )
+            {
+            CAMHAL_LOGEB("No free ref count slot for buffer 0x%x", buffer);
+            return NO_MEMORY;
+            }
+        slot = mCount;
+        mBuffers[slot] = buffer;
+        mCount++;
+        }
+
+    android_atomic_release_store(refCount, &mRefCounts[slot]);
+
+    return NO_ERROR;
+}
+
+int BaseCameraAdapter::FrameRefCounts::get(const CameraBuffer *buffer) const
+{
+    ssize_t slot = slotOf(buffer);
+    if ( NAME_NOT_FOUND == slot )
+        {
+        return -1;
+        }
+
+    return android_atomic_acquire_load(&mRefCounts[slot]);
+}
+
+void BaseCameraAdapter::FrameRefCounts::set(const CameraBuffer *buffer, int refCount)
+{
+    ssize_t slot = slotOf(buffer);
+    if ( NAME_NOT_FOUND != slot )
+        {
+        android_atomic_release_store(refCount, &mRefCounts[slot]);
+        }
+}
+
+ssize_t BaseCameraAdapter::FrameRefCounts::slotOf(const CameraBuffer *buffer) const
+{
+    if ( NULL == buffer )
+        {
+        return NAME_NOT_FOUND;
+        }
+
+    // Buffers are registered in index order, so this is normally a direct hit
+    if ( ( 0 <= buffer->index ) &&
+         ( (size_t) buffer->index < mCount ) &&
+         ( mBuffers[buffer->index] == buffer ) )
+        {
+        return buffer->index;
+        }
+
+    for ( size_t i = 0 ; i < mCount ; i++ )
+        {
+        if ( mBuffers[i] == buffer )
+            {
+            return i;
+            }
+        }
+
+    return NAME_NOT_FOUND;
+}
+
 void BaseCameraAdapter::addFramePointers(CameraBuffer *frameBuf, void *buf)
 {
   unsigned int *pBuf = (unsigned int *)buf;
-  android::AutoMutex lock(mSubscriberLock);
+  android::AutoMutex lock(mFrameQueueLock);
 
   if ((frameBuf != NULL) && ( pBuf != NULL) )
     {
@@ -318,7 +630,7 @@ void BaseCameraAdapter::addFramePointers(CameraBuffer *frameBuf, void *buf)
 
 void BaseCameraAdapter::removeFramePointers()
 {
-  android::AutoMutex lock(mSubscriberLock);
+  android::AutoMutex lock(mFrameQueueLock);
 
   int size = mFrameQueue.size();
   CAMHAL_LOGVB("Removing %d Frames = ", size);
@@ -1134,7 +1446,9 @@ status_t BaseCameraAdapter::notifyFocusSubscribers(CameraHalEvent::FocusStatus s
 
     LOG_FUNCTION_NAME;
 
-    if ( mFocusSubscribers.size() == 0 ) {
+    SubscriberRef subscribers(this);
+
+    if ( subscribers->mFocus.size() == 0 ) {
         CAMHAL_LOGDA("No Focus Subscribers!");
         return NO_INIT;
     }
@@ -1156,10 +1470,10 @@ status_t BaseCameraAdapter::notifyFocusSubscribers(CameraHalEvent::FocusStatus s
     focusEvent.mEventType = CameraHalEvent::EVENT_FOCUS_LOCKED;
     focusEvent.mEventData->focusEvent.focusStatus = status;
 
-    for (unsigned int i = 0 ; i < mFocusSubscribers.size(); i++ )
+    for (unsigned int i = 0 ; i < subscribers->mFocus.size(); i++ )
         {
-        focusEvent.mCookie = (void *) mFocusSubscribers.keyAt(i);
-        eventCb = (event_callback) mFocusSubscribers.valueAt(i);
+        focusEvent.mCookie = (void *) subscribers->mFocus.keyAt(i);
+        eventCb = (event_callback) subscribers->mFocus.valueAt(i);
         eventCb ( &focusEvent );
         }
 
@@ -1178,7 +1492,9 @@ status_t BaseCameraAdapter::notifyShutterSubscribers()
 
     LOG_FUNCTION_NAME;
 
-    if ( mShutterSubscribers.size() == 0 )
+    SubscriberRef subscribers(this);
+
+    if ( subscribers->mShutter.size() == 0 )
         {
         CAMHAL_LOGEA("No shutter Subscribers!");
         return NO_INIT;
@@ -1192,9 +1508,9 @@ status_t BaseCameraAdapter::notifyShutterSubscribers()
     shutterEvent.mEventType = CameraHalEvent::EVENT_SHUTTER;
     shutterEvent.mEventData->shutterEvent.shutterClosed = true;
 
-    for (unsigned int i = 0 ; i < mShutterSubscribers.size() ; i++ ) {
-        shutterEvent.mCookie = ( void * ) mShutterSubscribers.keyAt(i);
-        eventCb = ( event_callback ) mShutterSubscribers.valueAt(i);
+    for (unsigned int i = 0 ; i < subscribers->mShutter.size() ; i++ ) {
+        shutterEvent.mCookie = ( void * ) subscribers->mShutter.keyAt(i);
+        eventCb = ( event_callback ) subscribers->mShutter.valueAt(i);
 
         CAMHAL_LOGD("Sending shutter callback");
 
@@ -1216,7 +1532,9 @@ status_t BaseCameraAdapter::notifyZoomSubscribers(int zoomIdx, bool targetReache
 
     LOG_FUNCTION_NAME;
 
-    if ( mZoomSubscribers.size() == 0 ) {
+    SubscriberRef subscribers(this);
+
+    if ( subscribers->mZoom.size() == 0 ) {
         CAMHAL_LOGDA("No zoom Subscribers!");
         return NO_INIT;
     }
@@ -1230,9 +1548,9 @@ status_t BaseCameraAdapter::notifyZoomSubscribers(int zoomIdx, bool targetReache
     zoomEvent.mEventData->zoomEvent.currentZoomIndex = zoomIdx;
     zoomEvent.mEventData->zoomEvent.targetZoomIndexReached = targetReached;
 
-    for (unsigned int i = 0 ; i < mZoomSubscribers.size(); i++ ) {
-        zoomEvent.mCookie = (void *) mZoomSubscribers.keyAt(i);
-        eventCb = (event_callback) mZoomSubscribers.valueAt(i);
+    for (unsigned int i = 0 ; i < subscribers->mZoom.size(); i++ ) {
+        zoomEvent.mCookie = (void *) subscribers->mZoom.keyAt(i);
+        eventCb = (event_callback) subscribers->mZoom.valueAt(i);
 
         eventCb ( &zoomEvent );
     }
@@ -1252,7 +1570,9 @@ status_t BaseCameraAdapter::notifyMetadataSubscribers(android::sp<CameraMetadata
 
     LOG_FUNCTION_NAME;
 
-    if ( mMetadataSubscribers.size() == 0 ) {
+    SubscriberRef subscribers(this);
+
+    if ( subscribers->mMetadata.size() == 0 ) {
         CAMHAL_LOGDA("No preview metadata subscribers!");
         return NO_INIT;
     }
@@ -1265,9 +1585,9 @@ status_t BaseCameraAdapter::notifyMetadataSubscribers(android::sp<CameraMetadata
     metaEvent.mEventType = CameraHalEvent::EVENT_METADATA;
     metaEvent.mEventData->metadataEvent = meta;
 
-    for (unsigned int i = 0 ; i < mMetadataSubscribers.size(); i++ ) {
-        metaEvent.mCookie = (void *) mMetadataSubscribers.keyAt(i);
-        eventCb = (event_callback) mMetadataSubscribers.valueAt(i);
+    for (unsigned int i = 0 ; i < subscribers->mMetadata.size(); i++ ) {
+        metaEvent.mCookie = (void *) subscribers->mMetadata.keyAt(i);
+        eventCb = (event_callback) subscribers->mMetadata.valueAt(i);
 
         eventCb ( &metaEvent );
     }
@@ -1290,6 +1610,10 @@ status_t BaseCameraAdapter::sendFrameToSubscribers(CameraFrame *frame)
         return -EINVAL;
         }
 
+    CAMHAL_TRACE_FRAME(frame->mBuffer, STAGE_DISPATCH);
+
+    SubscriberRef subscribers(this);
+
     for( mask = 1; mask < CameraFrame::ALL_FRAMES; mask <<= 1){
       if( mask & frame->mFrameMask ){
         switch( mask ){
@@ -1299,37 +1623,37 @@ status_t BaseCameraAdapter::sendFrameToSubscribers(CameraFrame *frame)
 #if PPM_INSTRUMENTATION || PPM_INSTRUMENTATION_ABS
             CameraHal::PPM("Shot to Jpeg: ", &mStartCapture);
 #endif
-            ret = __sendFrameToSubscribers(frame, &mImageSubscribers, CameraFrame::IMAGE_FRAME);
+            ret = __sendFrameToSubscribers(frame, &subscribers->mImage, CameraFrame::IMAGE_FRAME);
           }
           break;
         case CameraFrame::RAW_FRAME:
           {
-            ret = __sendFrameToSubscribers(frame, &mRawSubscribers, CameraFrame::RAW_FRAME);
+            ret = __sendFrameToSubscribers(frame, &subscribers->mRaw, CameraFrame::RAW_FRAME);
           }
           break;
         case CameraFrame::PREVIEW_FRAME_SYNC:
           {
-            ret = __sendFrameToSubscribers(frame, &mFrameSubscribers, CameraFrame::PREVIEW_FRAME_SYNC);
+            ret = __sendFrameToSubscribers(frame, &subscribers->mFrame, CameraFrame::PREVIEW_FRAME_SYNC);
           }
           break;
         case CameraFrame::SNAPSHOT_FRAME:
           {
-            ret = __sendFrameToSubscribers(frame, &mSnapshotSubscribers, CameraFrame::SNAPSHOT_FRAME);
+            ret = __sendFrameToSubscribers(frame, &subscribers->mSnapshot, CameraFrame::SNAPSHOT_FRAME);
           }
           break;
         case CameraFrame::VIDEO_FRAME_SYNC:
           {
-            ret = __sendFrameToSubscribers(frame, &mVideoSubscribers, CameraFrame::VIDEO_FRAME_SYNC);
+            ret = __sendFrameToSubscribers(frame, &subscribers->mVideo, CameraFrame::VIDEO_FRAME_SYNC);
           }
           break;
         case CameraFrame::FRAME_DATA_SYNC:
           {
-            ret = __sendFrameToSubscribers(frame, &mFrameDataSubscribers, CameraFrame::FRAME_DATA_SYNC);
+            ret = __sendFrameToSubscribers(frame, &subscribers->mFrameData, CameraFrame::FRAME_DATA_SYNC);
           }
           break;
         case CameraFrame::REPROCESS_INPUT_FRAME:
           {
-            ret = __sendFrameToSubscribers(frame, &mVideoInSubscribers, CameraFrame::REPROCESS_INPUT_FRAME);
+            ret = __sendFrameToSubscribers(frame, &subscribers->mVideoIn, CameraFrame::REPROCESS_INPUT_FRAME);
           }
           break;
         default:
@@ -1349,7 +1673,7 @@ status_t BaseCameraAdapter::sendFrameToSubscribers(CameraFrame *frame)
 }
 
 status_t BaseCameraAdapter::__sendFrameToSubscribers(CameraFrame* frame,
-                                                     android::KeyedVector<int, frame_callback> *subscribers,
+                                                     const android::KeyedVector<int, frame_callback> *subscribers,
                                                      CameraFrame::FrameType frameType)
 {
     size_t refCount = 0;
@@ -1361,6 +1685,7 @@ status_t BaseCameraAdapter::__sendFrameToSubscribers(CameraFrame* frame,
     if ( (frameType == CameraFrame::PREVIEW_FRAME_SYNC) ||
          (frameType == CameraFrame::VIDEO_FRAME_SYNC) ||
          (frameType == CameraFrame::SNAPSHOT_FRAME) ){
+        android::AutoMutex lock(mFrameQueueLock);
         if (mFrameQueue.size() > 0){
           CameraFrame *lframe = (CameraFrame *)mFrameQueue.valueFor(frame->mBuffer);
           frame->mYuv[0] = lframe->mYuv[0];
@@ -1373,16 +1698,26 @@ status_t BaseCameraAdapter::__sendFrameToSubscribers(CameraFrame* frame,
       }
 
     if (NULL != subscribers) {
-        refCount = getFrameRefCountByType(frame->mBuffer, frameType);
+        int initialRefCount = getFrameRefCountByType(frame->mBuffer, frameType);
 
-        if (refCount == 0) {
-            CAMHAL_LOGDA("Invalid ref count of 0");
+        if (initialRefCount <= 0) {
+            CAMHAL_LOGDB("Invalid ref count of %d", initialRefCount);
             return -EINVAL;
         }
 
-        if (refCount > subscribers->size()) {
-            CAMHAL_LOGEB("Invalid ref count for frame type: 0x%x", frameType);
-            return -EINVAL;
+        refCount = initialRefCount;
+
+        // The ref count was taken from the subscriber set that was current
+        // in setInitFrameRefCount(). Anyone who unsubscribed since then
+        // still owns a reference, which is released here.
+        while (refCount > subscribers->size()) {
+            CAMHAL_LOGDB("Subscriber for frame type 0x%x went away", frameType);
+            returnFrame(frame->mBuffer, frameType);
+            refCount--;
+        }
+
+        if (refCount == 0) {
+            return NO_ERROR;
         }
 
         CAMHAL_LOGVB("Type of Frame: 0x%x address: 0x%x refCount start %d",
@@ -1421,49 +1756,18 @@ int BaseCameraAdapter::setInitFrameRefCount(CameraBuffer * buf, unsigned int mas
       return -EINVAL;
     }
 
+  SubscriberRef subscribers(this);
+
   for( lmask = 1; lmask < CameraFrame::ALL_FRAMES; lmask <<= 1){
     if( lmask & mask ){
-      switch( lmask ){
+      CameraFrame::FrameType frameType = static_cast<CameraFrame::FrameType>(lmask);
+      const android::KeyedVector<int, frame_callback> *frameSubscribers = subscribers->framesFor(frameType);
 
-      case CameraFrame::IMAGE_FRAME:
-        {
-            setFrameRefCountByType(buf, CameraFrame::IMAGE_FRAME, (int) mImageSubscribers.size());
-        }
-        break;
-      case CameraFrame::RAW_FRAME:
-        {
-            setFrameRefCountByType(buf, CameraFrame::RAW_FRAME, mRawSubscribers.size());
-        }
-        break;
-      case CameraFrame::PREVIEW_FRAME_SYNC:
-        {
-            setFrameRefCountByType(buf, CameraFrame::PREVIEW_FRAME_SYNC, mFrameSubscribers.size());
-        }
-        break;
-      case CameraFrame::SNAPSHOT_FRAME:
-        {
-            setFrameRefCountByType(buf, CameraFrame::SNAPSHOT_FRAME, mSnapshotSubscribers.size());
-        }
-        break;
-      case CameraFrame::VIDEO_FRAME_SYNC:
-        {
-            setFrameRefCountByType(buf,CameraFrame::VIDEO_FRAME_SYNC, mVideoSubscribers.size());
-        }
-        break;
-      case CameraFrame::FRAME_DATA_SYNC:
-        {
-            setFrameRefCountByType(buf, CameraFrame::FRAME_DATA_SYNC, mFrameDataSubscribers.size());
-        }
-        break;
-      case CameraFrame::REPROCESS_INPUT_FRAME:
-        {
-            setFrameRefCountByType(buf,CameraFrame::REPROCESS_INPUT_FRAME, mVideoInSubscribers.size());
-        }
-        break;
-      default:
-        CAMHAL_LOGEB("FRAMETYPE NOT SUPPORTED 0x%x", lmask);
-        break;
-      }//SWITCH
+      if ( NULL != frameSubscribers ) {
+          setFrameRefCountByType(buf, frameType, frameSubscribers->size());
+      } else {
+          CAMHAL_LOGEB("FRAMETYPE NOT SUPPORTED 0x%x", lmask);
+      }
       mask &= ~lmask;
     }//IF
   }//FOR
@@ -1485,66 +1789,29 @@ int BaseCameraAdapter::getFrameRefCount(CameraBuffer * frameBuf)
 int BaseCameraAdapter::getFrameRefCountByType(CameraBuffer * frameBuf, CameraFrame::FrameType frameType)
 {
     int res = -1;
-    ssize_t index = NAME_NOT_FOUND;
 
     LOG_FUNCTION_NAME;
 
     switch (frameType) {
         case CameraFrame::IMAGE_FRAME:
         case CameraFrame::RAW_FRAME:
-        {
-            android::AutoMutex lock(mCaptureBufferLock);
-            index = mCaptureBuffersAvailable.indexOfKey(frameBuf);
-            if (index != NAME_NOT_FOUND) {
-                res = mCaptureBuffersAvailable[index];
-            }
+            res = mCaptureBuffersAvailable.get(frameBuf);
             break;
-        }
         case CameraFrame::SNAPSHOT_FRAME:
-        {
-            android::AutoMutex lock(mSnapshotBufferLock);
-            index = mSnapshotBuffersAvailable.indexOfKey(frameBuf);
-            if (index != NAME_NOT_FOUND) {
-                res = mSnapshotBuffersAvailable[index];
-            }
+            res = mSnapshotBuffersAvailable.get(frameBuf);
             break;
-        }
         case CameraFrame::PREVIEW_FRAME_SYNC:
-        {
-            android::AutoMutex lock(mPreviewBufferLock);
-            index = mPreviewBuffersAvailable.indexOfKey(frameBuf);
-            if (index != NAME_NOT_FOUND) {
-                res = mPreviewBuffersAvailable[index];
-            }
+            res = mPreviewBuffersAvailable.get(frameBuf);
             break;
-        }
         case CameraFrame::FRAME_DATA_SYNC:
-        {
-            android::AutoMutex lock(mPreviewDataBufferLock);
-            index = mPreviewDataBuffersAvailable.indexOfKey(frameBuf);
-            if (index != NAME_NOT_FOUND) {
-                res = mPreviewDataBuffersAvailable[index];
-            }
+            res = mPreviewDataBuffersAvailable.get(frameBuf);
             break;
-        }
         case CameraFrame::VIDEO_FRAME_SYNC:
-        {
-            android::AutoMutex lock(mVideoBufferLock);
-            index = mVideoBuffersAvailable.indexOfKey(frameBuf);
-            if (index != NAME_NOT_FOUND) {
-                res = mVideoBuffersAvailable[index];
-            }
+            res = mVideoBuffersAvailable.get(frameBuf);
             break;
-        }
         case CameraFrame::REPROCESS_INPUT_FRAME:
-        {
-            android::AutoMutex lock(mVideoInBufferLock);
-            index = mVideoInBuffersAvailable.indexOfKey(frameBuf);
-            if (index != NAME_NOT_FOUND) {
-                res = mVideoInBuffersAvailable[index];
-            }
+            res = mVideoInBuffersAvailable.get(frameBuf);
             break;
-        }
         default:
             break;
     }
@@ -1563,39 +1830,22 @@ void BaseCameraAdapter::setFrameRefCountByType(CameraBuffer * frameBuf, CameraFr
         {
         case CameraFrame::IMAGE_FRAME:
         case CameraFrame::RAW_FRAME:
-                {
-                android::AutoMutex lock(mCaptureBufferLock);
-                mCaptureBuffersAvailable.replaceValueFor(frameBuf, refCount);
-                }
+            mCaptureBuffersAvailable.set(frameBuf, refCount);
             break;
         case CameraFrame::SNAPSHOT_FRAME:
-                {
-                android::AutoMutex lock(mSnapshotBufferLock);
-                mSnapshotBuffersAvailable.replaceValueFor(frameBuf, refCount);
-                }
+            mSnapshotBuffersAvailable.set(frameBuf, refCount);
             break;
         case CameraFrame::PREVIEW_FRAME_SYNC:
-                {
-                android::AutoMutex lock(mPreviewBufferLock);
-                mPreviewBuffersAvailable.replaceValueFor(frameBuf, refCount);
-                }
+            mPreviewBuffersAvailable.set(frameBuf, refCount);
             break;
         case CameraFrame::FRAME_DATA_SYNC:
-                {
-                android::AutoMutex lock(mPreviewDataBufferLock);
-                mPreviewDataBuffersAvailable.replaceValueFor(frameBuf, refCount);
-                }
+            mPreviewDataBuffersAvailable.set(frameBuf, refCount);
             break;
         case CameraFrame::VIDEO_FRAME_SYNC:
-                {
-                android::AutoMutex lock(mVideoBufferLock);
-                mVideoBuffersAvailable.replaceValueFor(frameBuf, refCount);
-                }
+            mVideoBuffersAvailable.set(frameBuf, refCount);
             break;
-        case CameraFrame::REPROCESS_INPUT_FRAME: {
-            android::AutoMutex lock(mVideoInBufferLock);
-            mVideoInBuffersAvailable.replaceValueFor(frameBuf, refCount);
-        }
+        case CameraFrame::REPROCESS_INPUT_FRAME:
+            mVideoInBuffersAvailable.set(frameBuf, refCount);
             break;
         default:
             break;
@@ -1900,6 +2150,7 @@ status_t BaseCameraAdapter::cameraPreviewInitialization() {
 status_t BaseCameraAdapter::setState(CameraCommands operation)
 {
     status_t ret = NO_ERROR;
+    AdapterState nextState;
 
     LOG_FUNCTION_NAME;
 
@@ -1907,611 +2158,29 @@ status_t BaseCameraAdapter::setState(CameraCommands operation)
 
     mLock.lock();
 
-    switch ( mAdapterState )
-        {
+    const AdapterState currentState = getState();
 
-        case INTIALIZED_STATE:
+    if ( sAdapterTransitionMatrix.lookup(currentState, operation, nextState) ) {
+        CAMHAL_LOGDB("Adapter state switch %s->%s event = %s",
+                     AdapterTransitionMatrix::nameOf(currentState),
+                     AdapterTransitionMatrix::nameOf(nextState), printState);
+        android_atomic_release_store(nextState, &mNextState);
+    } else {
+        CAMHAL_LOGEB("Adapter state switch %s Invalid Op! event = %s",
+                     AdapterTransitionMatrix::nameOf(currentState), printState);
+        ret = INVALID_OPERATION;
+    }
 
-            switch ( operation )
-                {
+    LOG_FUNCTION_NAME_EXIT;
 
-                case CAMERA_USE_BUFFERS_PREVIEW:
-                    CAMHAL_LOGDB("Adapter state switch INTIALIZED_STATE->LOADED_PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = LOADED_PREVIEW_STATE;
-                    break;
+    return ret;
+}
 
-                //These events don't change the current state
-                case CAMERA_QUERY_RESOLUTION_PREVIEW:
-                case CAMERA_QUERY_BUFFER_SIZE_PREVIEW_DATA:
-                    CAMHAL_LOGDB("Adapter state switch INTIALIZED_STATE->INTIALIZED_STATE event  = %s",
-                            printState);
-                    mNextState = INTIALIZED_STATE;
-                    break;
-                case CAMERA_STOP_BRACKET_CAPTURE:
-                case CAMERA_STOP_IMAGE_CAPTURE:
-                    ret = INVALID_OPERATION;
-                    break;
-                case CAMERA_CANCEL_AUTOFOCUS:
-                    ret = INVALID_OPERATION;
-                    break;
+status_t BaseCameraAdapter::rollbackToInitializedState()
+{
+    status_t ret = NO_ERROR;
 
-                default:
-                    CAMHAL_LOGEB("Adapter state switch INTIALIZED_STATE Invalid Op! event  = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case LOADED_PREVIEW_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_START_PREVIEW:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_PREVIEW_STATE->PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = PREVIEW_STATE;
-                    break;
-
-                case CAMERA_STOP_PREVIEW:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_PREVIEW_STATE->INTIALIZED_STATE event = 0x%x",
-                                 operation);
-                    mNextState = INTIALIZED_STATE;
-                    break;
-
-                //These events don't change the current state
-                case CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE:
-                case CAMERA_QUERY_BUFFER_SIZE_PREVIEW_DATA:
-                case CAMERA_USE_BUFFERS_PREVIEW_DATA:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_PREVIEW_STATE->LOADED_PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = LOADED_PREVIEW_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_PREVIEW Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case PREVIEW_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_STOP_PREVIEW:
-                    CAMHAL_LOGDB("Adapter state switch PREVIEW_STATE->INTIALIZED_STATE event = %s",
-                            printState);
-                    mNextState = INTIALIZED_STATE;
-                    break;
-
-                case CAMERA_PERFORM_AUTOFOCUS:
-                    CAMHAL_LOGDB("Adapter state switch PREVIEW_STATE->AF_STATE event = %s",
-                            printState);
-                    mNextState = AF_STATE;
-                    break;
-
-                case CAMERA_START_SMOOTH_ZOOM:
-                    CAMHAL_LOGDB("Adapter state switch PREVIEW_STATE->ZOOM_STATE event = %s",
-                            printState);
-                    mNextState = ZOOM_STATE;
-                    break;
-
-                case CAMERA_USE_BUFFERS_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch PREVIEW_STATE->LOADED_CAPTURE_STATE event = %s",
-                            printState);
-                    mNextState = LOADED_CAPTURE_STATE;
-                    break;
-
-#ifdef OMAP_ENHANCEMENT_CPCAM
-                case CAMERA_USE_BUFFERS_REPROCESS:
-                    CAMHAL_LOGDB("Adapter state switch PREVIEW_STATE->LOADED_REPROCESS_STATE event = %s",
-                                 printState);
-                    mNextState = LOADED_REPROCESS_STATE;
-                    break;
-#endif
-
-                case CAMERA_START_VIDEO:
-                    CAMHAL_LOGDB("Adapter state switch PREVIEW_STATE->VIDEO_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_STATE;
-                    break;
-
-                case CAMERA_CANCEL_AUTOFOCUS:
-                case CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE:
-                case CAMERA_STOP_SMOOTH_ZOOM:
-                    CAMHAL_LOGDB("Adapter state switch PREVIEW_ACTIVE->PREVIEW_ACTIVE event = %s",
-                            printState);
-                    mNextState = PREVIEW_STATE;
-                    break;
-
-                case CAMERA_STOP_IMAGE_CAPTURE:
-                case CAMERA_STOP_BRACKET_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch PREVIEW_ACTIVE->PREVIEW_ACTIVE event = %s",
-                                 printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch PREVIEW_ACTIVE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-#ifdef OMAP_ENHANCEMENT_CPCAM
-        case LOADED_REPROCESS_STATE:
-            switch (operation) {
-                case CAMERA_USE_BUFFERS_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_REPROCESS_STATE->LOADED_REPROCESS_CAPTURE_STATE event = %s",
-                                 printState);
-                    mNextState = LOADED_REPROCESS_CAPTURE_STATE;
-                    break;
-                case CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_REPROCESS_STATE->LOADED_REPROCESS_STATE event = %s",
-                                 printState);
-                    mNextState = LOADED_REPROCESS_STATE;
-                    break;
-                default:
-                    CAMHAL_LOGEB("Adapter state switch LOADED_REPROCESS_STATE Invalid Op! event = %s",
-                                 printState);
-                    ret = INVALID_OPERATION;
-                    break;
-                }
-
-            break;
-
-        case LOADED_REPROCESS_CAPTURE_STATE:
-            switch (operation) {
-                case CAMERA_START_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_REPROCESS_CAPTURE_STATE->REPROCESS_STATE event = %s",
-                                 printState);
-                    mNextState = REPROCESS_STATE;
-                    break;
-                default:
-                    CAMHAL_LOGEB("Adapter state switch LOADED_REPROCESS_CAPTURE_STATE Invalid Op! event = %s",
-                                 printState);
-                    ret = INVALID_OPERATION;
-                    break;
-            }
-            break;
-#endif
-
-        case LOADED_CAPTURE_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_START_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_CAPTURE_STATE->CAPTURE_STATE event = %s",
-                            printState);
-                    mNextState = CAPTURE_STATE;
-                    break;
-
-                case CAMERA_START_BRACKET_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_CAPTURE_STATE->BRACKETING_STATE event = %s",
-                            printState);
-                    mNextState = BRACKETING_STATE;
-                    break;
-
-                case CAMERA_USE_BUFFERS_VIDEO_CAPTURE:
-                    //Hadnle this state for raw capture path.
-                    //Just need to keep the same state.
-                    //The next CAMERA_START_IMAGE_CAPTURE command will assign the mNextState.
-                    CAMHAL_LOGDB("Adapter state switch LOADED_CAPTURE_STATE->LOADED_CAPTURE_STATE event = %s",
-                            printState);
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch LOADED_CAPTURE_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case CAPTURE_STATE:
-
-            switch ( operation )
-                {
-                case CAMERA_STOP_IMAGE_CAPTURE:
-                case CAMERA_STOP_BRACKET_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch CAPTURE_STATE->PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = PREVIEW_STATE;
-                    break;
-
-                case CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE:
-                case CAMERA_START_IMAGE_CAPTURE:
-                     CAMHAL_LOGDB("Adapter state switch CAPTURE_STATE->CAPTURE_STATE event = %s",
-                                 printState);
-                    mNextState = CAPTURE_STATE;
-                    break;
-
-#ifdef OMAP_ENHANCEMENT_CPCAM
-                case CAMERA_USE_BUFFERS_REPROCESS:
-                    CAMHAL_LOGDB("Adapter state switch CAPTURE_STATE->->LOADED_REPROCESS_STATE event = %s",
-                                 printState);
-                    mNextState = LOADED_REPROCESS_STATE;
-                    break;
-#endif
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch CAPTURE_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case BRACKETING_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_STOP_IMAGE_CAPTURE:
-                case CAMERA_STOP_BRACKET_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch BRACKETING_STATE->PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = PREVIEW_STATE;
-                    break;
-
-                case CAMERA_START_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch BRACKETING_STATE->CAPTURE_STATE event = %s",
-                            printState);
-                    mNextState = CAPTURE_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch BRACKETING_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case AF_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_CANCEL_AUTOFOCUS:
-                    CAMHAL_LOGDB("Adapter state switch AF_STATE->PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = PREVIEW_STATE;
-                    break;
-
-                case CAMERA_START_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch AF_STATE->CAPTURE_STATE event = 0x%x",
-                                 operation);
-                    mNextState = CAPTURE_STATE;
-                    break;
-
-                case CAMERA_START_SMOOTH_ZOOM:
-                    CAMHAL_LOGDB("Adapter state switch AF_STATE->AF_ZOOM_STATE event = %s",
-                            printState);
-                    mNextState = AF_ZOOM_STATE;
-                    break;
-
-                case CAMERA_START_VIDEO:
-                    CAMHAL_LOGDB("Adapter state switch AF_STATE->VIDEO_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch AF_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case ZOOM_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_CANCEL_AUTOFOCUS:
-                    CAMHAL_LOGDB("Adapter state switch AF_STATE->PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = ZOOM_STATE;
-                    break;
-
-                case CAMERA_STOP_SMOOTH_ZOOM:
-                    CAMHAL_LOGDB("Adapter state switch ZOOM_STATE->PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = PREVIEW_STATE;
-                    break;
-
-                case CAMERA_PERFORM_AUTOFOCUS:
-                    CAMHAL_LOGDB("Adapter state switch ZOOM_STATE->AF_ZOOM_STATE event = %s",
-                            printState);
-                    mNextState = AF_ZOOM_STATE;
-                    break;
-
-                case CAMERA_START_VIDEO:
-                    CAMHAL_LOGDB("Adapter state switch ZOOM_STATE->VIDEO_ZOOM_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_ZOOM_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch ZOOM_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case VIDEO_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_STOP_VIDEO:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_STATE->PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = PREVIEW_STATE;
-                    break;
-
-                case CAMERA_PERFORM_AUTOFOCUS:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_STATE->VIDEO_AF_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_AF_STATE;
-                    break;
-
-                case CAMERA_START_SMOOTH_ZOOM:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_STATE->VIDEO_ZOOM_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_ZOOM_STATE;
-                    break;
-
-                case CAMERA_USE_BUFFERS_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_STATE->VIDEO_LOADED_CAPTURE_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_LOADED_CAPTURE_STATE;
-                    break;
-
-                case CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_STATE->VIDEO_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch VIDEO_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case VIDEO_AF_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_CANCEL_AUTOFOCUS:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_AF_STATE->VIDEO_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_STATE;
-                    break;
-
-                case CAMERA_USE_BUFFERS_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_AF_STATE->VIDEO_LOADED_CAPTURE_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_LOADED_CAPTURE_STATE;
-                    break;
-
-                //This event doesn't change the current state
-                case CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_AF_STATE->VIDEO_AF_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_AF_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch VIDEO_AF_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case VIDEO_LOADED_CAPTURE_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_START_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch LOADED_CAPTURE_STATE->CAPTURE_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_CAPTURE_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch LOADED_CAPTURE_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case VIDEO_CAPTURE_STATE:
-
-            switch ( operation )
-                {
-                case CAMERA_STOP_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch CAPTURE_STATE->PREVIEW_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch CAPTURE_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case AF_ZOOM_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_STOP_SMOOTH_ZOOM:
-                    CAMHAL_LOGDB("Adapter state switch AF_ZOOM_STATE->AF_STATE event = %s",
-                            printState);
-                    mNextState = AF_STATE;
-                    break;
-
-                case CAMERA_CANCEL_AUTOFOCUS:
-                    CAMHAL_LOGDB("Adapter state switch AF_ZOOM_STATE->ZOOM_STATE event = %s",
-                            printState);
-                    mNextState = ZOOM_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch AF_ZOOM_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case VIDEO_ZOOM_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_STOP_SMOOTH_ZOOM:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_ZOOM_STATE->VIDEO_STATE event = %s",
-                            printState);
-                    mNextState = VIDEO_STATE;
-                    break;
-
-                case CAMERA_STOP_VIDEO:
-                    CAMHAL_LOGDB("Adapter state switch VIDEO_ZOOM_STATE->ZOOM_STATE event = %s",
-                            printState);
-                    mNextState = ZOOM_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch VIDEO_ZOOM_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-        case BRACKETING_ZOOM_STATE:
-
-            switch ( operation )
-                {
-
-                case CAMERA_STOP_SMOOTH_ZOOM:
-                    CAMHAL_LOGDB("Adapter state switch BRACKETING_ZOOM_STATE->BRACKETING_STATE event = %s",
-                            printState);
-                    mNextState = BRACKETING_STATE;
-                    break;
-
-                default:
-                    CAMHAL_LOGEB("Adapter state switch BRACKETING_ZOOM_STATE Invalid Op! event = %s",
-                            printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-
-#ifdef OMAP_ENHANCEMENT_CPCAM
-        case REPROCESS_STATE:
-            switch (operation) {
-                case CAMERA_STOP_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch REPROCESS_STATE->PREVIEW_STATE event = %s",
-                                 printState);
-                    mNextState = PREVIEW_STATE;
-                    break;
-                case CAMERA_QUERY_BUFFER_SIZE_IMAGE_CAPTURE:
-                case CAMERA_START_IMAGE_CAPTURE:
-                     CAMHAL_LOGDB("Adapter state switch REPROCESS_STATE->REPROCESS_STATE event = %s",
-                                 printState);
-                    mNextState = REPROCESS_STATE;
-                    break;
-                case CAMERA_USE_BUFFERS_REPROCESS:
-                     CAMHAL_LOGDB("Adapter state switch REPROCESS_STATE->REPROCESS_STATE event = %s",
-                                 printState);
-                    mNextState = LOADED_REPROCESS_STATE;
-                    break;
-
-                case CAMERA_USE_BUFFERS_IMAGE_CAPTURE:
-                    CAMHAL_LOGDB("Adapter state switch REPROCESS_STATE->LOADED_CAPTURE_STATE event = %s",
-                            printState);
-                    mNextState = LOADED_CAPTURE_STATE;
-                    break;
-                default:
-                    CAMHAL_LOGEB("Adapter state switch REPROCESS_STATE Invalid Op! event = %s",
-                                 printState);
-                    ret = INVALID_OPERATION;
-                    break;
-
-                }
-
-            break;
-#endif
-
-
-        default:
-            CAMHAL_LOGEA("Invalid Adapter state!");
-            ret = INVALID_OPERATION;
-        }
-
-    LOG_FUNCTION_NAME_EXIT;
-
-    return ret;
-}
-
-status_t BaseCameraAdapter::rollbackToInitializedState()
-{
-    status_t ret = NO_ERROR;
-
-    LOG_FUNCTION_NAME;
+    LOG_FUNCTION_NAME;
 
     while ((getState() != INTIALIZED_STATE) && (ret == NO_ERROR)) {
         ret = rollbackToPreviousState();
@@ -2599,7 +2268,7 @@ status_t BaseCameraAdapter::commitState()
 
     LOG_FUNCTION_NAME;
 
-    mAdapterState = mNextState;
+    android_atomic_release_store(android_atomic_acquire_load(&mNextState), &mAdapterState);
 
     mLock.unlock();
 
@@ -2614,7 +2283,7 @@ status_t BaseCameraAdapter::rollbackState()
 
     LOG_FUNCTION_NAME;
 
-    mNextState = mAdapterState;
+    android_atomic_release_store(android_atomic_acquire_load(&mAdapterState), &mNextState);
 
     mLock.unlock();
 
@@ -2625,45 +2294,28 @@ status_t BaseCameraAdapter::rollbackState()
 
 // getNextState() and getState()
 // publicly exposed functions to retrieve the adapter states
-// please notice that these functions are locked
+// the states are atomics, so these never wait for a command
+// holding mLock in the middle of a transition
 CameraAdapter::AdapterState BaseCameraAdapter::getState()
 {
-    status_t ret = NO_ERROR;
-
-    LOG_FUNCTION_NAME;
-
-    android::AutoMutex lock(mLock);
-
-    LOG_FUNCTION_NAME_EXIT;
-
-    return mAdapterState;
+    return static_cast<AdapterState>(android_atomic_acquire_load(&mAdapterState));
 }
 
 CameraAdapter::AdapterState BaseCameraAdapter::getNextState()
 {
-    status_t ret = NO_ERROR;
-
-    LOG_FUNCTION_NAME;
-
-    android::AutoMutex lock(mLock);
-
-    LOG_FUNCTION_NAME_EXIT;
-
-    return mNextState;
+    return static_cast<AdapterState>(android_atomic_acquire_load(&mNextState));
 }
 
 // getNextState() and getState()
-// internal protected functions to retrieve the adapter states
-// please notice that these functions are NOT locked to help
-// internal functions query state in the middle of state
-// transition
+// internal protected variants of the above, kept for the
+// adapters querying state in the middle of a transition
 status_t BaseCameraAdapter::getState(AdapterState &state)
 {
     status_t ret = NO_ERROR;
 
     LOG_FUNCTION_NAME;
 
-    state = mAdapterState;
+    state = getState();
 
     LOG_FUNCTION_NAME_EXIT;
 
@@ -2676,7 +2328,7 @@ status_t BaseCameraAdapter::getNextState(AdapterState &state)
 
     LOG_FUNCTION_NAME;
 
-    state = mNextState;
+    state = getNextState();
 
     LOG_FUNCTION_NAME_EXIT;
 
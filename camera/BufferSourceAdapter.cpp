@@ -130,6 +130,7 @@ BufferSourceAdapter::BufferSourceAdapter() : mBufferCount(0)
 
     mPixelFormat = NULL;
     mBuffers = NULL;
+    mBuffersWithCamera = NULL;
     mFrameProvider = NULL;
     mBufferSource = NULL;
 
@@ -397,6 +398,13 @@ CameraBuffer* BufferSourceAdapter::allocateBufferList(int width, int dummyHeight
     CAMHAL_LOGDB("Configuring %d buffers for ANativeWindow", numBufs);
     mBufferCount = numBufs;
 
+    if ( NULL != mBuffersWithCamera ) {
+        delete [] mBuffersWithCamera;
+    }
+    mBuffersWithCamera = new bool [lnumBufs];
+    memset(mBuffersWithCamera, 0, sizeof(bool) * lnumBufs);
+    mSlotTable.clear();
+
     // re-calculate height depending on stride and size
     int height = getHeightFromFormat(format, width, bytes);
 
@@ -442,11 +450,13 @@ CameraBuffer* BufferSourceAdapter::allocateBufferList(int width, int dummyHeight
         mBuffers[i].opaque = (void *)handle;
         mBuffers[i].type = CAMERA_BUFFER_ANW;
         mBuffers[i].format = mPixelFormat;
-        mFramesWithCameraAdapterMap.add(handle, i);
+        mBuffersWithCamera[i] = true;
 
         bytes = CameraHal::calculateBufferSize(format, width, height);
     }
 
+    mSlotTable.build(mBuffers, mBufferCount);
+
     for( i = 0;  i < mBufferCount-undequeued; i++ ) {
         void *y_uv[2];
         android::Rect bounds(width, height);
@@ -476,7 +486,7 @@ CameraBuffer* BufferSourceAdapter::allocateBufferList(int width, int dummyHeight
             }
             goto fail;
         }
-        mFramesWithCameraAdapterMap.removeItem((buffer_handle_t *) mBuffers[i].opaque);
+        mBuffersWithCamera[i] = false;
     }
 
     mFrameWidth = width;
@@ -494,7 +504,7 @@ CameraBuffer* BufferSourceAdapter::allocateBufferList(int width, int dummyHeight
           CAMHAL_LOGEB("cancelBuffer failed w/ error 0x%08x", err);
           break;
         }
-        mFramesWithCameraAdapterMap.removeItem((buffer_handle_t *) mBuffers[start].opaque);
+        mBuffersWithCamera[start] = false;
     }
 
     freeBufferList(mBuffers);
@@ -532,32 +542,37 @@ CameraBuffer *BufferSourceAdapter::getBuffers(bool reset) {
         android::Rect bounds(mFrameWidth, mFrameHeight);
         void *y_uv[2];
         CameraBuffer * newBuffers = NULL;
-        unsigned int index = 0;
-        android::KeyedVector<void*, int> missingIndices;
+        bool *newWithCamera = NULL;
+        bool *placed = NULL;
+        int index = 0;
 
         newBuffers = new CameraBuffer [lnumBufs];
         memset (newBuffers, 0, sizeof(CameraBuffer) * lnumBufs);
+        newWithCamera = new bool [lnumBufs];
+        memset (newWithCamera, 0, sizeof(bool) * lnumBufs);
 
-        // Use this vector to figure out missing indices
-        for (int i = 0; i < mBufferCount; i++) {
-            missingIndices.add(mBuffers[i].opaque, i);
-        }
+        // Marks the entries of mBuffers already carried over to newBuffers
+        placed = new bool [lnumBufs];
+        memset (placed, 0, sizeof(bool) * lnumBufs);
 
         // assign buffers that we have already dequeued
-        for (index = 0; index < mFramesWithCameraAdapterMap.size(); index++) {
-            int value = mFramesWithCameraAdapterMap.valueAt(index);
-            newBuffers[index].opaque = mBuffers[value].opaque;
-            newBuffers[index].type = mBuffers[value].type;
-            newBuffers[index].format = mBuffers[value].format;
-            newBuffers[index].mapped = mBuffers[value].mapped;
-            mFramesWithCameraAdapterMap.replaceValueAt(index, index);
-            missingIndices.removeItem(newBuffers[index].opaque);
+        for (int i = 0; i < mBufferCount; i++) {
+            if (!mBuffersWithCamera[i]) {
+                continue;
+            }
+            newBuffers[index].opaque = mBuffers[i].opaque;
+            newBuffers[index].type = mBuffers[i].type;
+            newBuffers[index].format = mBuffers[i].format;
+            newBuffers[index].mapped = mBuffers[i].mapped;
+            newWithCamera[index] = true;
+            placed[i] = true;
+            index++;
         }
 
         mBufferSource->get_min_undequeued_buffer_count(mBufferSource, &undequeued);
 
         // dequeue the rest of the buffers
-        for (index; index < (unsigned int)(mBufferCount-undequeued); index++) {
+        for (; index < (mBufferCount-undequeued); index++) {
             buffer_handle_t *handle;
             int stride;  // dummy variable to get stride
 
@@ -568,39 +583,53 @@ CameraBuffer *BufferSourceAdapter::getBuffers(bool reset) {
                     CAMHAL_LOGEA("Preview surface abandoned!");
                     mBufferSource = NULL;
                 }
+                delete [] newBuffers;
+                delete [] newWithCamera;
+                delete [] placed;
                 goto fail;
             }
             newBuffers[index].opaque = (void *)handle;
             newBuffers[index].type = CAMERA_BUFFER_ANW;
             newBuffers[index].format = mPixelFormat;
-            mFramesWithCameraAdapterMap.add(handle, index);
+            newWithCamera[index] = true;
 
             mBufferSource->lock_buffer(mBufferSource, handle);
             mapper.lock(*handle, CAMHAL_GRALLOC_USAGE, bounds, y_uv);
             newBuffers[index].mapped = y_uv[0];
             CAMHAL_LOGDB("got handle %p", handle);
 
-            missingIndices.removeItem(newBuffers[index].opaque);
+            const int slot = mSlotTable.find(handle);
+            if (0 <= slot) {
+                placed[slot] = true;
+            }
         }
 
         // now we need to figure out which buffers aren't dequeued
         // which are in mBuffers but not newBuffers yet
-        if ((mBufferCount - index) != missingIndices.size()) {
+        for (int i = 0; (i < mBufferCount) && (index < mBufferCount); i++) {
+            if (placed[i]) {
+                continue;
+            }
+
+            CAMHAL_LOGD("Filling at %d", index);
+            newBuffers[index].opaque = mBuffers[i].opaque;
+            newBuffers[index].type = mBuffers[i].type;
+            newBuffers[index].format = mBuffers[i].format;
+            newBuffers[index].mapped = mBuffers[i].mapped;
+            index++;
+        }
+
+        if (index != mBufferCount) {
             CAMHAL_LOGD("Hrmm somethings gone awry. We are missing a different number"
                         " of buffers than we can fill");
         }
-        for (unsigned int i = 0; i < missingIndices.size(); i++) {
-            int j = missingIndices.valueAt(i);
-
-            CAMHAL_LOGD("Filling at %d", j);
-            newBuffers[index].opaque = mBuffers[j].opaque;
-            newBuffers[index].type = mBuffers[j].type;
-            newBuffers[index].format = mBuffers[j].format;
-            newBuffers[index].mapped = mBuffers[j].mapped;
-        }
 
+        delete [] placed;
         delete [] mBuffers;
+        delete [] mBuffersWithCamera;
         mBuffers = newBuffers;
+        mBuffersWithCamera = newWithCamera;
+        mSlotTable.build(mBuffers, mBufferCount);
     }
 
     return mBuffers;
@@ -636,6 +665,13 @@ CameraBuffer* BufferSourceAdapter::getBufferList(int *num) {
     mBuffers = new CameraBuffer [lnumBufs];
     memset (mBuffers, 0, sizeof(CameraBuffer) * lnumBufs);
 
+    if ( NULL != mBuffersWithCamera ) {
+        delete [] mBuffersWithCamera;
+    }
+    mBuffersWithCamera = new bool [lnumBufs];
+    memset(mBuffersWithCamera, 0, sizeof(bool) * lnumBufs);
+    mSlotTable.clear();
+
     if ( NULL == mBufferSource ) {
         return NULL;
     }
@@ -656,7 +692,8 @@ CameraBuffer* BufferSourceAdapter::getBufferList(int *num) {
     CAMHAL_LOGD("got handle %p", handle);
     mBuffers[0].opaque = (void *)handle;
     mBuffers[0].type = CAMERA_BUFFER_ANW;
-    mFramesWithCameraAdapterMap.add(handle, 0);
+    mBuffersWithCamera[0] = true;
+    mSlotTable.build(mBuffers, mBufferCount);
 
     err = extendedOps()->get_buffer_dimension(mBufferSource, &mBuffers[0].width, &mBuffers[0].height);
     err = extendedOps()->get_buffer_format(mBufferSource, &formatSource);
@@ -771,16 +808,13 @@ status_t BufferSourceAdapter::returnBuffersToWindow()
 
     //Give the buffers back to display here -  sort of free it
     if (mBufferSource) {
-        for(unsigned int i = 0; i < mFramesWithCameraAdapterMap.size(); i++) {
-            int value = mFramesWithCameraAdapterMap.valueAt(i);
-            buffer_handle_t *handle = (buffer_handle_t *) mBuffers[value].opaque;
-
-            // if buffer index is out of bounds skip
-            if ((value < 0) || (value >= mBufferCount)) {
-                CAMHAL_LOGEA("Potential out bounds access to handle...skipping");
+        for (int i = 0; (NULL != mBuffers) && (NULL != mBuffersWithCamera) && (i < mBufferCount); i++) {
+            if (!mBuffersWithCamera[i]) {
                 continue;
             }
 
+            buffer_handle_t *handle = (buffer_handle_t *) mBuffers[i].opaque;
+
             // unlock buffer before giving it up
             mapper.unlock(*handle);
 
@@ -800,8 +834,10 @@ status_t BufferSourceAdapter::returnBuffersToWindow()
          CAMHAL_LOGE("mBufferSource is NULL");
     }
 
-     ///Clear the frames with camera adapter map
-     mFramesWithCameraAdapterMap.clear();
+     ///Nothing is left dequeued for the camera adapter
+     if (NULL != mBuffersWithCamera) {
+         memset(mBuffersWithCamera, 0, sizeof(bool) * mBufferCount);
+     }
 
      return ret;
 
@@ -827,6 +863,14 @@ int BufferSourceAdapter::freeBufferList(CameraBuffer * buflist)
         mBuffers = NULL;
     }
 
+    if ( NULL != mBuffersWithCamera )
+    {
+        delete [] mBuffersWithCamera;
+        mBuffersWithCamera = NULL;
+    }
+
+    mSlotTable.clear();
+
     return NO_ERROR;
 }
 
@@ -858,13 +902,9 @@ void BufferSourceAdapter::handleFrameCallback(CameraFrame* frame)
         return;
     }
 
-    for ( i = 0; i < mBufferCount; i++ ) {
-        if (frame->mBuffer == &mBuffers[i]) {
-            break;
-        }
-    }
+    i = frame->mBuffer - mBuffers;
 
-    if (i >= mBufferCount) {
+    if ((i < 0) || (i >= mBufferCount)) {
         CAMHAL_LOGD("Can't find frame in buffer list");
         if (frame->mFrameType != CameraFrame::REPROCESS_INPUT_FRAME) {
             mFrameProvider->returnFrame(frame->mBuffer,
@@ -916,12 +956,12 @@ void BufferSourceAdapter::handleFrameCallback(CameraFrame* frame)
         goto fail;
     }
 
-    mFramesWithCameraAdapterMap.removeItem((buffer_handle_t *) frame->mBuffer->opaque);
+    mBuffersWithCamera[i] = false;
 
     return;
 
 fail:
-    mFramesWithCameraAdapterMap.clear();
+    memset(mBuffersWithCamera, 0, sizeof(bool) * mBufferCount);
     mBufferSource = NULL;
     mReturnFrame->requestExit();
     mQueueFrame->requestExit();
@@ -969,18 +1009,15 @@ bool BufferSourceAdapter::handleFrameReturn()
         return false;
     }
 
-    mapper.lock(*buf, CAMHAL_GRALLOC_USAGE, bounds, y_uv);
-
-    for(i = 0; i < mBufferCount; i++) {
-        if (mBuffers[i].opaque == buf)
-            break;
-    }
-
-    if (i >= mBufferCount) {
+    i = mSlotTable.find(buf);
+    if (i < 0) {
         CAMHAL_LOGEB("Failed to find handle %p", buf);
+        return false;
     }
 
-    mFramesWithCameraAdapterMap.add((buffer_handle_t *) mBuffers[i].opaque, i);
+    mapper.lock(*buf, CAMHAL_GRALLOC_USAGE, bounds, y_uv);
+
+    mBuffersWithCamera[i] = true;
 
     CAMHAL_LOGVB("handleFrameReturn: found graphic buffer %d of %d", i, mBufferCount - 1);
 
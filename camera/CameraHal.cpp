@@ -27,8 +27,10 @@
 #include "TICameraParameters.h"
 #include "CameraProperties.h"
 #include <cutils/properties.h>
+#include <cutils/atomic.h>
 
 #include <poll.h>
+#include <stddef.h>
 #include <math.h>
 
 namespace Ti {
@@ -357,17 +359,11 @@ int CameraHal::msgTypeEnabled(int32_t msgType)
  */
 int CameraHal::setParameters(const char* parameters)
 {
-
-    LOG_FUNCTION_NAME;
-
     android::CameraParameters params;
-
     android::String8 str_params(parameters);
-    params.unflatten(str_params);
 
-    LOG_FUNCTION_NAME_EXIT;
-
-    return setParameters(params);
+    // Unflattened by applyParameters() only if this is not a repeat
+    return applyParameters(params, &str_params);
 }
 
 /**
@@ -379,6 +375,23 @@ int CameraHal::setParameters(const char* parameters)
 
  */
 int CameraHal::setParameters(const android::CameraParameters& params)
+{
+    android::CameraParameters copy = params;
+
+    return applyParameters(copy, NULL);
+}
+
+/**
+   @brief Applies the camera parameters.
+
+   @param[in,out] params Camera parameters to configure the camera, filled
+                  from flattened when that is given
+   @param[in] flattened Client string the parameters come from, or NULL
+   @return NO_ERROR
+   @todo Define error codes
+
+ */
+int CameraHal::applyParameters(android::CameraParameters& params, const android::String8 *flattened)
 {
 
     LOG_FUNCTION_NAME;
@@ -405,11 +418,28 @@ int CameraHal::setParameters(const android::CameraParameters& params)
     {
         android::AutoMutex lock(mLock);
 
+        if ( NULL != flattened ) {
+            // Apps often re-send the set they already applied. When neither the
+            // string nor anything it depends on moved since, there is nothing to do.
+            if ( ( mAppliedParameters.mParams == *flattened ) &&
+                 ( mAppliedParameters.mGeneration == mParameters.generation() ) &&
+                 ( mAppliedParameters.mPreviewEnabled == mPreviewEnabled ) &&
+                 ( mAppliedParameters.mMsgEnabled == mMsgEnabled ) ) {
+                CAMHAL_LOGVA("Parameters unchanged, skipping");
+                LOG_FUNCTION_NAME_EXIT;
+                return NO_ERROR;
+            }
+
+            params.unflatten(*flattened);
+        }
+
+        const CapabilitySets &caps = mCapabilitySets[mCameraProperties->getMode()];
+
         ///Ensure that preview is not enabled when the below parameters are changed.
         if(!previewEnabled())
             {
             if ((valstr = params.getPreviewFormat()) != NULL) {
-                if ( isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_FORMATS))) {
+                if ( caps.previewFormats.contains(valstr)) {
                     mParameters.setPreviewFormat(valstr);
                     CAMHAL_LOGDB("PreviewFormat set %s", valstr);
                 } else {
@@ -493,7 +523,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
         }
 
         if ((valstr = params.get(TICameraParameters::KEY_IPP)) != NULL) {
-            if (isParameterValid(valstr,mCameraProperties->get(CameraProperties::SUPPORTED_IPP_MODES))) {
+            if (caps.ippModes.contains(valstr)) {
                 if ((mParameters.get(TICameraParameters::KEY_IPP) == NULL) ||
                         (strcmp(valstr, mParameters.get(TICameraParameters::KEY_IPP)))) {
                     CAMHAL_LOGDB("IPP mode set %s", params.get(TICameraParameters::KEY_IPP));
@@ -577,10 +607,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
             restartPreviewRequired |= resetVideoModeParameters();
             }
 
-        if ( (!isResolutionValid(w, h, mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_SIZES)))
-                && (!isResolutionValid(w, h, mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_SUBSAMPLED_SIZES)))
-                && (!isResolutionValid(w, h, mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_SIDEBYSIDE_SIZES)))
-                && (!isResolutionValid(w, h, mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_TOPBOTTOM_SIZES))) ) {
+        if ( !caps.previewSizes.contains(w, h) ) {
             CAMHAL_LOGEB("Invalid preview resolution %d x %d", w, h);
             return BAD_VALUE;
         }
@@ -596,7 +623,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
         CAMHAL_LOGDB("Preview Resolution: %d x %d", w, h);
 
         if ((valstr = params.get(android::CameraParameters::KEY_FOCUS_MODE)) != NULL) {
-            if (isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_FOCUS_MODES))) {
+            if (caps.focusModes.contains(valstr)) {
                 CAMHAL_LOGDB("Focus mode set %s", valstr);
 
                 // we need to take a decision on the capture mode based on whether CAF picture or
@@ -631,10 +658,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
             }
 
         params.getPictureSize(&w, &h);
-        if ( (isResolutionValid(w, h, mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_SIZES)))
-                || (isResolutionValid(w, h, mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_SUBSAMPLED_SIZES)))
-                || (isResolutionValid(w, h, mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_TOPBOTTOM_SIZES)))
-                || (isResolutionValid(w, h, mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_SIDEBYSIDE_SIZES))) ) {
+        if ( caps.pictureSizes.contains(w, h) ) {
             mParameters.setPictureSize(w, h);
         } else {
             CAMHAL_LOGEB("ERROR: Invalid picture resolution %d x %d", w, h);
@@ -644,7 +668,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
         CAMHAL_LOGDB("Picture Size by App %d x %d", w, h);
 
         if ( (valstr = params.getPictureFormat()) != NULL ) {
-            if (isParameterValid(valstr,mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_FORMATS))) {
+            if (caps.pictureFormats.contains(valstr)) {
                 if ((strcmp(valstr, android::CameraParameters::PIXEL_FORMAT_BAYER_RGGB) == 0) &&
                     mCameraProperties->get(CameraProperties::MAX_PICTURE_WIDTH) &&
                     mCameraProperties->get(CameraProperties::MAX_PICTURE_HEIGHT)) {
@@ -697,8 +721,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
                 ((curMaxFPS != maxFPS) || (curMinFPS != minFPS))) {
             CAMHAL_LOGDB("## current minFPS = %d; maxFPS=%d", curMinFPS, curMaxFPS);
             CAMHAL_LOGDB("## requested minFPS = %d; maxFPS=%d", minFPS, maxFPS);
-            if (!isFpsRangeValid(minFPS, maxFPS, params.get(android::CameraParameters::KEY_SUPPORTED_PREVIEW_FPS_RANGE)) &&
-                !isFpsRangeValid(minFPS, maxFPS, params.get(TICameraParameters::KEY_FRAMERATE_RANGES_EXT_SUPPORTED))) {
+            if (!caps.fpsRanges.contains(minFPS, maxFPS)) {
                 CAMHAL_LOGEA("Trying to set invalid FPS Range (%d,%d)", minFPS, maxFPS);
                 return BAD_VALUE;
             }
@@ -714,8 +737,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
         valstr = params.get(android::CameraParameters::KEY_PREVIEW_FRAME_RATE);
         if (valstr != NULL && strlen(valstr) && (framerate != curFramerate)) {
             CAMHAL_LOGD("current framerate = %d reqested framerate = %d", curFramerate, framerate);
-            if (!isParameterValid(framerate, params.get(android::CameraParameters::KEY_SUPPORTED_PREVIEW_FRAME_RATES)) &&
-                !isParameterValid(framerate, params.get(TICameraParameters::KEY_FRAMERATES_EXT_SUPPORTED))) {
+            if (!caps.frameRates.contains(framerate)) {
                 CAMHAL_LOGEA("Trying to set invalid frame rate %d", framerate);
                 return BAD_VALUE;
             }
@@ -794,7 +816,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
         }
 
         if ((valstr = params.get(TICameraParameters::KEY_EXPOSURE_MODE)) != NULL) {
-            if (isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_EXPOSURE_MODES))) {
+            if (caps.exposureModes.contains(valstr)) {
                 CAMHAL_LOGDB("Exposure mode set = %s", valstr);
                 mParameters.set(TICameraParameters::KEY_EXPOSURE_MODE, valstr);
                 if (!strcmp(valstr, TICameraParameters::EXPOSURE_MODE_MANUAL)) {
@@ -852,7 +874,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
 #endif
 
         if ((valstr = params.get(android::CameraParameters::KEY_WHITE_BALANCE)) != NULL) {
-           if ( isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_WHITE_BALANCE))) {
+           if ( caps.whiteBalance.contains(valstr)) {
                CAMHAL_LOGDB("White balance set %s", valstr);
                mParameters.set(android::CameraParameters::KEY_WHITE_BALANCE, valstr);
             } else {
@@ -904,7 +926,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
 #endif
 
         if ((valstr = params.get(android::CameraParameters::KEY_ANTIBANDING)) != NULL) {
-            if (isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_ANTIBANDING))) {
+            if (caps.antibanding.contains(valstr)) {
                 CAMHAL_LOGDB("Antibanding set %s", valstr);
                 mParameters.set(android::CameraParameters::KEY_ANTIBANDING, valstr);
              } else {
@@ -915,7 +937,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
 
 #ifdef OMAP_ENHANCEMENT
         if ((valstr = params.get(TICameraParameters::KEY_ISO)) != NULL) {
-            if (isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_ISO_VALUES))) {
+            if (caps.isoModes.contains(valstr)) {
                 CAMHAL_LOGDB("ISO set %s", valstr);
                 mParameters.set(TICameraParameters::KEY_ISO, valstr);
             } else {
@@ -960,7 +982,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
             }
 
         if ((valstr = params.get(android::CameraParameters::KEY_SCENE_MODE)) != NULL) {
-            if (isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_SCENE_MODES))) {
+            if (caps.sceneModes.contains(valstr)) {
                 CAMHAL_LOGDB("Scene mode set %s", valstr);
                 doesSetParameterNeedUpdate(valstr,
                                            mParameters.get(android::CameraParameters::KEY_SCENE_MODE),
@@ -973,7 +995,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
         }
 
         if ((valstr = params.get(android::CameraParameters::KEY_FLASH_MODE)) != NULL) {
-            if (isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_FLASH_MODES))) {
+            if (caps.flashModes.contains(valstr)) {
                 CAMHAL_LOGDB("Flash mode set %s", valstr);
                 mParameters.set(android::CameraParameters::KEY_FLASH_MODE, valstr);
             } else {
@@ -983,7 +1005,7 @@ int CameraHal::setParameters(const android::CameraParameters& params)
         }
 
         if ((valstr = params.get(android::CameraParameters::KEY_EFFECT)) != NULL) {
-            if (isParameterValid(valstr, mCameraProperties->get(CameraProperties::SUPPORTED_EFFECTS))) {
+            if (caps.effects.contains(valstr)) {
                 CAMHAL_LOGDB("Effect set %s", valstr);
                 mParameters.set(android::CameraParameters::KEY_EFFECT, valstr);
              } else {
@@ -1343,6 +1365,15 @@ int CameraHal::setParameters(const android::CameraParameters& params)
             mParameters.set(TICameraParameters::KEY_SHUTTER_ENABLE, valstr);
             }
 #endif
+
+        if ( ( NULL != flattened ) && ( NO_ERROR == ret ) ) {
+            mAppliedParameters.mParams = *flattened;
+            mAppliedParameters.mGeneration = mParameters.generation();
+            mAppliedParameters.mPreviewEnabled = mPreviewEnabled;
+            mAppliedParameters.mMsgEnabled = mMsgEnabled;
+        } else {
+            mAppliedParameters.mParams = android::String8();
+        }
     }
 
     //On fail restore old parameters
@@ -1377,6 +1408,8 @@ int CameraHal::setParameters(const android::CameraParameters& params)
     if (ret != NO_ERROR)
         {
         CAMHAL_LOGEA("Failed to restart Preview");
+        android::AutoMutex lock(mLock);
+        mAppliedParameters.mParams = android::String8();
         return ret;
         }
 
@@ -3673,6 +3706,83 @@ status_t CameraHal::cancelPicture( )
    @return Currently configured camera parameters
 
  */
+// getParameters() hands out references to one cached string, so a poll
+// that finds nothing changed neither serializes for the client nor allocates
+struct SharedParameters
+{
+    volatile int32_t refs;
+    char data[1];
+};
+
+static char *allocSharedParameters(const android::String8 &params)
+{
+    SharedParameters *shared = (SharedParameters *)
+            malloc(offsetof(SharedParameters, data) + params.length() + 1);
+
+    if ( NULL == shared ) {
+        return NULL;
+    }
+
+    shared->refs = 1;
+    memcpy(shared->data, params.string(), params.length() + 1);
+
+    return shared->data;
+}
+
+static SharedParameters *toSharedParameters(char *params)
+{
+    return (SharedParameters *) ( params - offsetof(SharedParameters, data) );
+}
+
+static void releaseSharedParameters(char *params)
+{
+    SharedParameters *shared = toSharedParameters(params);
+
+    if ( 1 == android_atomic_dec(&shared->refs) ) {
+        free(shared);
+    }
+}
+
+// Drops the internal-only keys from a flattened "key=value;key=value" string
+static android::String8 stripInternalParameters(const android::String8 &flattened)
+{
+    static const char * const internalKeys[] = {
+        TICameraParameters::KEY_RECORDING_HINT,
+        TICameraParameters::KEY_AUTO_FOCUS_LOCK,
+    };
+    android::String8 result;
+    const char *pair = flattened.string();
+
+    while ( '\0' != *pair ) {
+        const char *next = strchr(pair, ';');
+        const size_t length = next ? (size_t) ( next - pair ) : strlen(pair);
+        bool internal = false;
+
+        for ( size_t i = 0 ; i < sizeof(internalKeys) / sizeof(internalKeys[0]) ; i++ ) {
+            const size_t keyLength = strlen(internalKeys[i]);
+            if ( ( length > keyLength ) && ( '=' == pair[keyLength] ) &&
+                 ( 0 == strncmp(pair, internalKeys[i], keyLength) ) ) {
+                internal = true;
+                break;
+            }
+        }
+
+        if ( !internal ) {
+            if ( !result.isEmpty() ) {
+                result.append(";");
+            }
+            result.append(pair, length);
+        }
+
+        if ( NULL == next ) {
+            break;
+        }
+        pair = next + 1;
+    }
+
+    return result;
+}
+
 char* CameraHal::getParameters()
 {
     android::String8 params_str8;
@@ -3708,34 +3818,53 @@ char* CameraHal::getParameters()
         }
     }
 
-    android::CameraParameters mParams = mParameters;
+    android::AutoMutex lock(mParametersCacheLock);
+
+    // Only values the adapter or the setters actually changed move the generation
+    if ( ( NULL == mParametersCache ) ||
+         ( mParametersCacheVideoWidth != mVideoWidth ) ||
+         ( mParametersCacheVideoHeight != mVideoHeight ) ||
+         ( mParametersCacheGeneration != mParameters.generation() ) ) {
+        android::String8 client_str8;
+
+        // Handle RECORDING_HINT to Set/Reset Video Mode Parameters
+        valstr = mParameters.get(android::CameraParameters::KEY_RECORDING_HINT);
+        if ( ( valstr != NULL ) && ( strcmp(valstr, android::CameraParameters::TRUE) == 0 ) ) {
+            android::CameraParameters mParams = mParameters;
 
-    // Handle RECORDING_HINT to Set/Reset Video Mode Parameters
-    valstr = mParameters.get(android::CameraParameters::KEY_RECORDING_HINT);
-    if(valstr != NULL)
-      {
-        if(strcmp(valstr, android::CameraParameters::TRUE) == 0)
-          {
             //HACK FOR MMS MODE
             resetPreviewRes(&mParams);
-          }
-      }
+            client_str8 = stripInternalParameters(mParams.flatten());
+        } else {
+            // do not send internal parameters to upper layers
+            params_str8 = mParameters.flatten();
+            client_str8 = stripInternalParameters(params_str8);
+        }
 
-    // do not send internal parameters to upper layers
-    mParams.remove(TICameraParameters::KEY_RECORDING_HINT);
-    mParams.remove(TICameraParameters::KEY_AUTO_FOCUS_LOCK);
+        params_string = allocSharedParameters(client_str8);
+        if ( NULL == params_string ) {
+            CAMHAL_LOGEA("Couldn't allocate parameters string");
+            LOG_FUNCTION_NAME_EXIT;
+            return NULL;
+        }
 
-    params_str8 = mParams.flatten();
+        if ( NULL != mParametersCache ) {
+            releaseSharedParameters(mParametersCache);
+        }
+        mParametersCache = params_string;
+        mParametersCacheGeneration = mParameters.generation();
+        mParametersCacheVideoWidth = mVideoWidth;
+        mParametersCacheVideoHeight = mVideoHeight;
+    }
 
-    // camera service frees this string...
-    params_string = (char*) malloc(sizeof(char) * (params_str8.length()+1));
-    strcpy(params_string, params_str8.string());
+    // camera service hands this back through putParameters()...
+    android_atomic_inc(&toSharedParameters(mParametersCache)->refs);
 
     LOG_FUNCTION_NAME_EXIT;
 
     ///Return the current set of parameters
 
-    return params_string;
+    return mParametersCache;
 }
 
 
@@ -3874,7 +4003,9 @@ status_t CameraHal::cancel_reprocess( )
 
 void CameraHal::putParameters(char *parms)
 {
-    free(parms);
+    if ( NULL != parms ) {
+        releaseSharedParameters(parms);
+    }
 }
 
 /**
@@ -4019,6 +4150,11 @@ void CameraHal::release()
 status_t  CameraHal::dump(int fd) const
 {
     LOG_FUNCTION_NAME;
+
+#ifdef CAMERAHAL_FRAME_TRACE
+    FrameTracer::instance().dump(fd);
+#endif
+
     ///Implement this method when the h/w dump function is supported on Ducati side
     return NO_ERROR;
 }
@@ -4091,6 +4227,13 @@ CameraHal::CameraHal(int cameraId)
     mSensorListener = NULL;
     mVideoWidth = 0;
     mVideoHeight = 0;
+    mParametersCache = NULL;
+    mParametersCacheGeneration = 0;
+    mParametersCacheVideoWidth = 0;
+    mParametersCacheVideoHeight = 0;
+    mAppliedParameters.mGeneration = 0;
+    mAppliedParameters.mPreviewEnabled = false;
+    mAppliedParameters.mMsgEnabled = 0;
 #ifdef OMAP_ENHANCEMENT_VTC
     mVTCUseCase = false;
     mTunnelSetup = false;
@@ -4160,6 +4303,11 @@ CameraHal::~CameraHal()
     /// Free the memory manager
     mMemoryManager.clear();
 
+    if ( NULL != mParametersCache ) {
+        releaseSharedParameters(mParametersCache);
+        mParametersCache = NULL;
+    }
+
     LOG_FUNCTION_NAME_EXIT;
 }
 
@@ -4198,6 +4346,8 @@ status_t CameraHal::initialize(CameraProperties::Properties* properties)
     // will only print if DEBUG macro is defined
     mCameraProperties->dump();
 
+    initCapabilitySets();
+
     if (strcmp(CameraProperties::DEFAULT_VALUE, mCameraProperties->get(CameraProperties::CAMERA_SENSOR_INDEX)) != 0 )
         {
         sensor_index = atoi(mCameraProperties->get(CameraProperties::CAMERA_SENSOR_INDEX));
@@ -4314,132 +4464,50 @@ status_t CameraHal::initialize(CameraProperties::Properties* properties)
 
 }
 
-bool CameraHal::isResolutionValid(unsigned int width, unsigned int height, const char *supportedResolutions)
-{
-    bool ret = false;
-    status_t status = NO_ERROR;
-    char tmpBuffer[MAX_PROP_VALUE_LENGTH];
-    char *pos = NULL;
-
-    LOG_FUNCTION_NAME;
-
-    if (NULL == supportedResolutions) {
-        CAMHAL_LOGEA("Invalid supported resolutions string");
-        goto exit;
-    }
-
-    status = snprintf(tmpBuffer, MAX_PROP_VALUE_LENGTH - 1, "%dx%d", width, height);
-    if (0 > status) {
-        CAMHAL_LOGEA("Error encountered while generating validation string");
-        goto exit;
-    }
-
-    ret = isParameterValid(tmpBuffer, supportedResolutions);
-
-exit:
-    LOG_FUNCTION_NAME_EXIT;
-
-    return ret;
-}
-
-bool CameraHal::isFpsRangeValid(int fpsMin, int fpsMax, const char *supportedFpsRanges)
-{
-    bool ret = false;
-    char supported[MAX_PROP_VALUE_LENGTH];
-    char *pos;
-    int suppFpsRangeArray[2];
-    int i = 0;
-
-    LOG_FUNCTION_NAME;
-
-    if ( NULL == supportedFpsRanges ) {
-        CAMHAL_LOGEA("Invalid supported FPS ranges string");
-        return false;
-    }
-
-    if (fpsMin <= 0 || fpsMax <= 0 || fpsMin > fpsMax) {
-        return false;
-    }
-
-    strncpy(supported, supportedFpsRanges, MAX_PROP_VALUE_LENGTH);
-    pos = strtok(supported, " (,)");
-    while (pos != NULL) {
-        suppFpsRangeArray[i] = atoi(pos);
-        if (i++) {
-            if (fpsMin >= suppFpsRangeArray[0] && fpsMax <= suppFpsRangeArray[1]) {
-                ret = true;
-                break;
-            }
-            i = 0;
-        }
-        pos = strtok(NULL, " (,)");
-    }
-
-    LOG_FUNCTION_NAME_EXIT;
-
-    return ret;
-}
-
-bool CameraHal::isParameterValid(const char *param, const char *supportedParams)
+void CameraHal::initCapabilitySets()
 {
-    bool ret = false;
-    char *pos;
-    char supported[MAX_PROP_VALUE_LENGTH];
-
     LOG_FUNCTION_NAME;
 
-    if (NULL == supportedParams) {
-        CAMHAL_LOGEA("Invalid supported parameters string");
-        goto exit;
-    }
+    const OperatingMode originalMode = mCameraProperties->getMode();
 
-    if (NULL == param) {
-        CAMHAL_LOGEA("Invalid parameter string");
-        goto exit;
-    }
+    for ( int i = 0; i < MODE_MAX; i++ ) {
+        CapabilitySets &caps = mCapabilitySets[i];
+        caps = CapabilitySets();
 
-    strncpy(supported, supportedParams, MAX_PROP_VALUE_LENGTH - 1);
+        mCameraProperties->setMode(static_cast<OperatingMode>(i));
 
-    pos = strtok(supported, ",");
-    while (pos != NULL) {
-        if (!strcmp(pos, param)) {
-            ret = true;
-            break;
-        }
-        pos = strtok(NULL, ",");
-    }
+        caps.previewFormats.add(mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_FORMATS));
+        caps.ippModes.add(mCameraProperties->get(CameraProperties::SUPPORTED_IPP_MODES));
+        caps.focusModes.add(mCameraProperties->get(CameraProperties::SUPPORTED_FOCUS_MODES));
+        caps.pictureFormats.add(mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_FORMATS));
+        caps.exposureModes.add(mCameraProperties->get(CameraProperties::SUPPORTED_EXPOSURE_MODES));
+        caps.whiteBalance.add(mCameraProperties->get(CameraProperties::SUPPORTED_WHITE_BALANCE));
+        caps.antibanding.add(mCameraProperties->get(CameraProperties::SUPPORTED_ANTIBANDING));
+        caps.isoModes.add(mCameraProperties->get(CameraProperties::SUPPORTED_ISO_VALUES));
+        caps.sceneModes.add(mCameraProperties->get(CameraProperties::SUPPORTED_SCENE_MODES));
+        caps.flashModes.add(mCameraProperties->get(CameraProperties::SUPPORTED_FLASH_MODES));
+        caps.effects.add(mCameraProperties->get(CameraProperties::SUPPORTED_EFFECTS));
 
-exit:
-    LOG_FUNCTION_NAME_EXIT;
+        // Same lists the adapter reports as the supported frame rates and ranges
+        caps.frameRates.add(mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_FRAME_RATES));
+        caps.frameRates.add(mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_FRAME_RATES_EXT));
+        caps.fpsRanges.add(mCameraProperties->get(CameraProperties::FRAMERATE_RANGE_SUPPORTED));
+        caps.fpsRanges.add(mCameraProperties->get(CameraProperties::FRAMERATE_RANGE_EXT_SUPPORTED));
 
-    return ret;
-}
-
-bool CameraHal::isParameterValid(int param, const char *supportedParams)
-{
-    bool ret = false;
-    status_t status;
-    char tmpBuffer[MAX_PROP_VALUE_LENGTH];
-
-    LOG_FUNCTION_NAME;
+        caps.previewSizes.add(mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_SIZES));
+        caps.previewSizes.add(mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_SUBSAMPLED_SIZES));
+        caps.previewSizes.add(mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_SIDEBYSIDE_SIZES));
+        caps.previewSizes.add(mCameraProperties->get(CameraProperties::SUPPORTED_PREVIEW_TOPBOTTOM_SIZES));
 
-    if (NULL == supportedParams) {
-        CAMHAL_LOGEA("Invalid supported parameters string");
-        goto exit;
-    }
-
-    status = snprintf(tmpBuffer, MAX_PROP_VALUE_LENGTH - 1, "%d", param);
-    if (0 > status) {
-        CAMHAL_LOGEA("Error encountered while generating validation string");
-        goto exit;
+        caps.pictureSizes.add(mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_SIZES));
+        caps.pictureSizes.add(mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_SUBSAMPLED_SIZES));
+        caps.pictureSizes.add(mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_TOPBOTTOM_SIZES));
+        caps.pictureSizes.add(mCameraProperties->get(CameraProperties::SUPPORTED_PICTURE_SIDEBYSIDE_SIZES));
     }
 
-    ret = isParameterValid(tmpBuffer, supportedParams);
+    mCameraProperties->setMode(originalMode);
 
-exit:
     LOG_FUNCTION_NAME_EXIT;
-
-    return ret;
 }
 
 status_t CameraHal::doesSetParameterNeedUpdate(const char* new_param, const char* old_param, bool& update) {
@@ -4513,7 +4581,7 @@ void CameraHal::insertSupportedParams()
 {
     LOG_FUNCTION_NAME;
 
-    android::CameraParameters &p = mParameters;
+    CameraHalParameters &p = mParameters;
 
     ///Set the name of the camera
     p.set(TICameraParameters::KEY_CAMERA_NAME, mCameraProperties->get(CameraProperties::CAMERA_NAME));
@@ -4580,7 +4648,7 @@ void CameraHal::initDefaultParameters()
     //Purpose of this function is to initialize the default current and supported parameters for the currently
     //selected camera.
 
-    android::CameraParameters &p = mParameters;
+    CameraHalParameters &p = mParameters;
     int currentRevision, adapterRevision;
     status_t ret = NO_ERROR;
     int width, height;
@@ -4976,7 +5044,7 @@ unsigned int CameraHal::getFlashIntensity()
 
 bool CameraHal::SetFlashLedTorch( unsigned intensity )
 {
-    android::CameraParameters params;
+    CameraHalParameters params;
     mCameraAdapter->getParameters(params);
     CAMHAL_LOGE("CameraHalTI::SetFlashLedTorch %d", intensity);
     unsigned char write_data[2];
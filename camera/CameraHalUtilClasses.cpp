@@ -120,7 +120,7 @@ status_t CameraArea::transfrom(size_t width,
                                size_t &top,
                                size_t &left,
                                size_t &areaWidth,
-                               size_t &areaHeight)
+                               size_t &areaHeight) const
 {
     status_t ret = NO_ERROR;
     size_t hRange, vRange;
@@ -195,21 +195,28 @@ status_t CameraArea::checkArea(ssize_t top,
     return NO_ERROR;
 }
 
+static uint32_t hashArea(uint32_t hash, ssize_t value)
+{
+    // FNV-1a over the coordinate bytes
+    const uint8_t *bytes = (const uint8_t *) &value;
+    for ( size_t i = 0 ; i < sizeof(value) ; i++ ) {
+        hash = ( hash ^ bytes[i] ) * 16777619u;
+    }
+    return hash;
+}
+
 status_t CameraArea::parseAreas(const char *area,
                                 size_t areaLength,
-                                android::Vector<android::sp<CameraArea> > &areas)
+                                CameraAreas &areas)
 {
     status_t ret = NO_ERROR;
-    char *ctx;
-    char *pArea = NULL;
-    char *pStart = NULL;
+    const char *pArea = NULL;
     char *pEnd = NULL;
-    const char *startToken = "(";
+    const char startToken = '(';
     const char endToken = ')';
     const char sep = ',';
     ssize_t top, left, bottom, right, weight;
-    char *tmpBuffer = NULL;
-    android::sp<CameraArea> currentArea;
+    uint32_t hash = 2166136261u;
 
     LOG_FUNCTION_NAME
 
@@ -219,31 +226,30 @@ status_t CameraArea::parseAreas(const char *area,
         return -EINVAL;
         }
 
-    tmpBuffer = ( char * ) malloc(areaLength);
-    if ( NULL == tmpBuffer )
-        {
-        return -ENOMEM;
-        }
-
-    memcpy(tmpBuffer, area, areaLength);
-
-    pArea = strtok_r(tmpBuffer, startToken, &ctx);
+    areas.clear();
+    pArea = area;
 
+    // Parsed in place: every area is the text following a '(' up to its ')'
     do
         {
 
-        pStart = pArea;
-        if ( NULL == pStart )
+        while ( startToken == *pArea )
             {
-            CAMHAL_LOGEA("Parsing of the left area coordinate failed!");
-            ret = -EINVAL;
-            break;
+            pArea++;
             }
-        else
+
+        if ( '\0' == *pArea )
             {
-            left = static_cast<ssize_t>(strtol(pStart, &pEnd, 10));
+            if ( areas.isEmpty() )
+                {
+                CAMHAL_LOGEA("Parsing of the left area coordinate failed!");
+                ret = -EINVAL;
+                }
+            break;
             }
 
+        left = static_cast<ssize_t>(strtol(pArea, &pEnd, 10));
+
         if ( sep != *pEnd )
             {
             CAMHAL_LOGEA("Parsing of the top area coordinate failed!");
@@ -300,47 +306,50 @@ status_t CameraArea::parseAreas(const char *area,
             break;
         }
 
-        currentArea = new CameraArea(top, left, bottom, right, weight);
+        if ( CameraAreas::MAX_AREAS <= areas.mCount ) {
+            CAMHAL_LOGEB("More than %d areas", CameraAreas::MAX_AREAS);
+            ret = -EINVAL;
+            break;
+        }
+
+        areas.mAreas[areas.mCount++] = CameraArea(top, left, bottom, right, weight);
+        hash = hashArea(hash, top);
+        hash = hashArea(hash, left);
+        hash = hashArea(hash, bottom);
+        hash = hashArea(hash, right);
+        hash = hashArea(hash, weight);
         CAMHAL_LOGDB("Area parsed [%dx%d, %dx%d] %d",
                      ( int ) top,
                      ( int ) left,
                      ( int ) bottom,
                      ( int ) right,
                      ( int ) weight);
-        if ( NULL != currentArea.get() )
-            {
-            areas.add(currentArea);
-            }
-        else
-            {
-            ret = -ENOMEM;
-            break;
-            }
 
-        pArea = strtok_r(NULL, startToken, &ctx);
+        pArea = strchr(pEnd, startToken);
 
         }
     while ( NULL != pArea );
 
-    if ( NULL != tmpBuffer )
-        {
-        free(tmpBuffer);
-        }
+    if ( NO_ERROR == ret ) {
+        areas.mHash = hash;
+    } else {
+        areas.clear();
+    }
 
     LOG_FUNCTION_NAME_EXIT
 
     return ret;
 }
 
-bool CameraArea::areAreasDifferent(android::Vector< android::sp<CameraArea> > &area1,
-                                    android::Vector< android::sp<CameraArea> > &area2) {
-    if (area1.size() != area2.size()) {
+bool CameraArea::areAreasDifferent(const CameraAreas &area1,
+                                   const CameraAreas &area2) {
+    if ( ( area1.mCount != area2.mCount ) || ( area1.mHash != area2.mHash ) ) {
         return true;
     }
 
     // not going to care about sorting order for now
-    for (int i = 0; i < area1.size(); i++) {
-        if (!area1.itemAt(i)->compare(area2.itemAt(i))) {
+    for (size_t i = 0; i < area1.mCount; i++) {
+        if (!area1.mAreas[i].compare(area2.mAreas[i])) {
             return true;
         }
     }
@@ -348,14 +357,280 @@ bool CameraArea::areAreasDifferent(android::Vector< android::sp<CameraArea> > &a
     return false;
 }
 
-bool CameraArea::compare(const android::sp<CameraArea> &area) {
-    return ((mTop == area->mTop) && (mLeft == area->mLeft) &&
-            (mBottom == area->mBottom) && (mRight == area->mRight) &&
-            (mWeight == area->mWeight));
+bool CameraArea::compare(const CameraArea &area) const {
+    return ((mTop == area.mTop) && (mLeft == area.mLeft) &&
+            (mBottom == area.mBottom) && (mRight == area.mRight) &&
+            (mWeight == area.mWeight));
 }
 
 
 /*--------------------CameraArea Class ENDS here-----------------------------*/
 
+/*--------------------SupportedValues Class STARTS here-----------------------------*/
+
+// Calls fn(token, length) for every non-empty token of list separated by any of delims
+template <typename Fn>
+static void forEachToken(const char *list, const char *delims, Fn &fn) {
+    if ( NULL == list ) {
+        return;
+    }
+
+    while ( *list ) {
+        const size_t length = strcspn(list, delims);
+        if ( length > 0 ) {
+            fn(list, length);
+        }
+        list += length;
+        if ( *list ) {
+            list++;
+        }
+    }
+}
+
+static int compareToken(const char *value, const android::String8 &token) {
+    return strcmp(value, token.string());
+}
+
+struct SupportedValuesInserter {
+    android::Vector<android::String8> &values;
+
+    void operator()(const char *token, size_t length) {
+        const android::String8 value(token, length);
+        size_t lo = 0;
+        size_t hi = values.size();
+        while ( lo < hi ) {
+            const size_t mid = (lo + hi) / 2;
+            const int cmp = compareToken(value.string(), values[mid]);
+            if ( cmp == 0 ) {
+                return;
+            } else if ( cmp < 0 ) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        values.insertAt(value, lo);
+    }
+};
+
+void SupportedValues::add(const char *supported) {
+    SupportedValuesInserter inserter = { mValues };
+    forEachToken(supported, ",", inserter);
+}
+
+void SupportedValues::clear() {
+    mValues.clear();
+}
+
+bool SupportedValues::contains(const char *value) const {
+    if ( NULL == value ) {
+        return false;
+    }
+
+    size_t lo = 0;
+    size_t hi = mValues.size();
+    while ( lo < hi ) {
+        const size_t mid = (lo + hi) / 2;
+        const int cmp = compareToken(value, mValues[mid]);
+        if ( cmp == 0 ) {
+            return true;
+        } else if ( cmp < 0 ) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    return false;
+}
+
+bool SupportedValues::contains(int value) const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%d", value);
+    return contains(buffer);
+}
+
+struct SupportedResolutionsInserter {
+    android::SortedVector<uint32_t> &resolutions;
+
+    void operator()(const char *token, size_t length) {
+        char *end = NULL;
+        const unsigned long width = strtoul(token, &end, 10);
+        if ( end == token || *end != 'x' ) {
+            return;
+        }
+
+        const char *heightStr = end + 1;
+        const unsigned long height = strtoul(heightStr, &end, 10);
+        if ( end == heightStr || (size_t)(end - token) != length ) {
+            return;
+        }
+
+        if ( width <= 0xffff && height <= 0xffff ) {
+            resolutions.add((uint32_t)((width << 16) | height));
+        }
+    }
+};
+
+void SupportedResolutions::add(const char *supported) {
+    SupportedResolutionsInserter inserter = { mResolutions };
+    forEachToken(supported, ",", inserter);
+}
+
+void SupportedResolutions::clear() {
+    mResolutions.clear();
+}
+
+bool SupportedResolutions::contains(unsigned int width, unsigned int height) const {
+    if ( width > 0xffff || height > 0xffff ) {
+        return false;
+    }
+
+    return mResolutions.indexOf((uint32_t)((width << 16) | height)) >= 0;
+}
+
+struct SupportedFpsRangesInserter {
+    android::Vector<FpsRange> &ranges;
+    int pending;
+    bool hasPending;
+
+    void operator()(const char *token, size_t /*length*/) {
+        const int value = atoi(token);
+        if ( !hasPending ) {
+            pending = value;
+            hasPending = true;
+        } else {
+            ranges.add(FpsRange(pending, value));
+            hasPending = false;
+        }
+    }
+};
+
+void SupportedFpsRanges::add(const char *supported) {
+    SupportedFpsRangesInserter inserter = { mRanges, 0, false };
+    forEachToken(supported, " (,)", inserter);
+}
+
+void SupportedFpsRanges::clear() {
+    mRanges.clear();
+}
+
+bool SupportedFpsRanges::contains(int fpsMin, int fpsMax) const {
+    if ( fpsMin <= 0 || fpsMax <= 0 || fpsMin > fpsMax ) {
+        return false;
+    }
+
+    for ( size_t i = 0; i < mRanges.size(); i++ ) {
+        if ( fpsMin >= mRanges[i].min() && fpsMax <= mRanges[i].max() ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*--------------------SupportedValues Class ENDS here-----------------------------*/
+
+/*--------------------CameraHalParameters Class STARTS here-----------------------------*/
+
+CameraHalParameters &CameraHalParameters::operator=(const android::CameraParameters &params)
+{
+    android::CameraParameters::operator=(params);
+    mGeneration++;
+
+    return *this;
+}
+
+CameraHalParameters &CameraHalParameters::operator=(const CameraHalParameters &params)
+{
+    // The generation describes this object's history, it is not copied
+    return operator=(static_cast<const android::CameraParameters &>(params));
+}
+
+void CameraHalParameters::set(const char *key, const char *value)
+{
+    const char *current = get(key);
+
+    if ( ( NULL != current ) && ( NULL != value ) && ( 0 == strcmp(current, value) ) ) {
+        return;
+    }
+
+    android::CameraParameters::set(key, value);
+    mGeneration++;
+}
+
+void CameraHalParameters::set(const char *key, int value)
+{
+    char str[16];
+
+    snprintf(str, sizeof(str), "%d", value);
+    set(key, str);
+}
+
+void CameraHalParameters::setFloat(const char *key, float value)
+{
+    char str[16];
+
+    snprintf(str, sizeof(str), "%g", value);
+    set(key, str);
+}
+
+void CameraHalParameters::remove(const char *key)
+{
+    if ( NULL == get(key) ) {
+        return;
+    }
+
+    android::CameraParameters::remove(key);
+    mGeneration++;
+}
+
+void CameraHalParameters::unflatten(const android::String8 &params)
+{
+    android::CameraParameters::unflatten(params);
+    mGeneration++;
+}
+
+void CameraHalParameters::setPreviewSize(int width, int height)
+{
+    char str[32];
+
+    snprintf(str, sizeof(str), "%dx%d", width, height);
+    set(android::CameraParameters::KEY_PREVIEW_SIZE, str);
+}
+
+void CameraHalParameters::setPictureSize(int width, int height)
+{
+    char str[32];
+
+    snprintf(str, sizeof(str), "%dx%d", width, height);
+    set(android::CameraParameters::KEY_PICTURE_SIZE, str);
+}
+
+void CameraHalParameters::setVideoSize(int width, int height)
+{
+    char str[32];
+
+    snprintf(str, sizeof(str), "%dx%d", width, height);
+    set(android::CameraParameters::KEY_VIDEO_SIZE, str);
+}
+
+void CameraHalParameters::setPreviewFrameRate(int fps)
+{
+    set(android::CameraParameters::KEY_PREVIEW_FRAME_RATE, fps);
+}
+
+void CameraHalParameters::setPreviewFormat(const char *format)
+{
+    set(android::CameraParameters::KEY_PREVIEW_FORMAT, format);
+}
+
+void CameraHalParameters::setPictureFormat(const char *format)
+{
+    set(android::CameraParameters::KEY_PICTURE_FORMAT, format);
+}
+
+/*--------------------CameraHalParameters Class ENDS here-----------------------------*/
+
 } // namespace Camera
 } // namespace Ti
@@ -26,120 +26,10 @@
 namespace Ti {
 namespace Camera {
 
-const char CameraProperties::INVALID[]="prop-invalid-key";
-const char CameraProperties::CAMERA_NAME[]="prop-camera-name";
-const char CameraProperties::CAMERA_SENSOR_INDEX[]="prop-sensor-index";
-const char CameraProperties::CAMERA_SENSOR_ID[] = "prop-sensor-id";
-const char CameraProperties::ORIENTATION_INDEX[]="prop-orientation";
-const char CameraProperties::FACING_INDEX[]="prop-facing";
-const char CameraProperties::SUPPORTED_PREVIEW_SIZES[] = "prop-preview-size-values";
-const char CameraProperties::SUPPORTED_PREVIEW_SUBSAMPLED_SIZES[] = "prop-preview-subsampled-size-values";
-const char CameraProperties::SUPPORTED_PREVIEW_TOPBOTTOM_SIZES[] = "prop-preview-topbottom-size-values";
-const char CameraProperties::SUPPORTED_PREVIEW_SIDEBYSIDE_SIZES[] = "prop-preview-sidebyside-size-values";
-const char CameraProperties::SUPPORTED_PREVIEW_FORMATS[] = "prop-preview-format-values";
-const char CameraProperties::SUPPORTED_PREVIEW_FRAME_RATES[] = "prop-preview-frame-rate-values";
-const char CameraProperties::SUPPORTED_PREVIEW_FRAME_RATES_EXT[] = "prop-preview-frame-rate-ext-values";
-const char CameraProperties::SUPPORTED_PICTURE_SIZES[] = "prop-picture-size-values";
-const char CameraProperties::SUPPORTED_PICTURE_SUBSAMPLED_SIZES[] = "prop-picture-subsampled-size-values";
-const char CameraProperties::SUPPORTED_PICTURE_TOPBOTTOM_SIZES[] = "prop-picture-topbottom-size-values";
-const char CameraProperties::SUPPORTED_PICTURE_SIDEBYSIDE_SIZES[] = "prop-picture-sidebyside-size-values";
-const char CameraProperties::SUPPORTED_PICTURE_FORMATS[] = "prop-picture-format-values";
-const char CameraProperties::SUPPORTED_THUMBNAIL_SIZES[] = "prop-jpeg-thumbnail-size-values";
-const char CameraProperties::SUPPORTED_WHITE_BALANCE[] = "prop-whitebalance-values";
-const char CameraProperties::SUPPORTED_EFFECTS[] = "prop-effect-values";
-const char CameraProperties::SUPPORTED_ANTIBANDING[] = "prop-antibanding-values";
-const char CameraProperties::SUPPORTED_EXPOSURE_MODES[] = "prop-exposure-mode-values";
-const char CameraProperties::SUPPORTED_MANUAL_EXPOSURE_MIN[] = "prop-manual-exposure-min";
-const char CameraProperties::SUPPORTED_MANUAL_EXPOSURE_MAX[] = "prop-manual-exposure-max";
-const char CameraProperties::SUPPORTED_MANUAL_EXPOSURE_STEP[] = "prop-manual-exposure-step";
-const char CameraProperties::SUPPORTED_MANUAL_GAIN_ISO_MIN[] = "prop-manual-gain-iso-min";
-const char CameraProperties::SUPPORTED_MANUAL_GAIN_ISO_MAX[] = "prop-manual-gain-iso-max";
-const char CameraProperties::SUPPORTED_MANUAL_GAIN_ISO_STEP[] = "prop-manual-gain-iso-step";
-const char CameraProperties::SUPPORTED_EV_MAX[] = "prop-ev-compensation-max";
-const char CameraProperties::SUPPORTED_EV_MIN[] = "prop-ev-compensation-min";
-const char CameraProperties::SUPPORTED_EV_STEP[] = "prop-ev-compensation-step";
-const char CameraProperties::SUPPORTED_ISO_VALUES[] = "prop-iso-mode-values";
-const char CameraProperties::SUPPORTED_SCENE_MODES[] = "prop-scene-mode-values";
-const char CameraProperties::SUPPORTED_FLASH_MODES[] = "prop-flash-mode-values";
-const char CameraProperties::SUPPORTED_FOCUS_MODES[] = "prop-focus-mode-values";
-const char CameraProperties::REQUIRED_PREVIEW_BUFS[] = "prop-required-preview-bufs";
-const char CameraProperties::REQUIRED_IMAGE_BUFS[] = "prop-required-image-bufs";
-const char CameraProperties::SUPPORTED_ZOOM_RATIOS[] = "prop-zoom-ratios";
-const char CameraProperties::SUPPORTED_ZOOM_STAGES[] = "prop-zoom-stages";
-const char CameraProperties::SUPPORTED_IPP_MODES[] = "prop-ipp-values";
-const char CameraProperties::SMOOTH_ZOOM_SUPPORTED[] = "prop-smooth-zoom-supported";
-const char CameraProperties::ZOOM_SUPPORTED[] = "prop-zoom-supported";
-const char CameraProperties::PREVIEW_SIZE[] = "prop-preview-size-default";
-const char CameraProperties::PREVIEW_FORMAT[] = "prop-preview-format-default";
-const char CameraProperties::PREVIEW_FRAME_RATE[] = "prop-preview-frame-rate-default";
-const char CameraProperties::ZOOM[] = "prop-zoom-default";
-const char CameraProperties::PICTURE_SIZE[] = "prop-picture-size-default";
-const char CameraProperties::PICTURE_FORMAT[] = "prop-picture-format-default";
-const char CameraProperties::JPEG_THUMBNAIL_SIZE[] = "prop-jpeg-thumbnail-size-default";
-const char CameraProperties::WHITEBALANCE[] = "prop-whitebalance-default";
-const char CameraProperties::EFFECT[] = "prop-effect-default";
-const char CameraProperties::ANTIBANDING[] = "prop-antibanding-default";
-const char CameraProperties::EXPOSURE_MODE[] = "prop-exposure-mode-default";
-const char CameraProperties::EV_COMPENSATION[] = "prop-ev-compensation-default";
-const char CameraProperties::ISO_MODE[] = "prop-iso-mode-default";
-const char CameraProperties::FOCUS_MODE[] = "prop-focus-mode-default";
-const char CameraProperties::SCENE_MODE[] = "prop-scene-mode-default";
-const char CameraProperties::FLASH_MODE[] = "prop-flash-mode-default";
-const char CameraProperties::JPEG_QUALITY[] = "prop-jpeg-quality-default";
-const char CameraProperties::CONTRAST[] = "prop-contrast-default";
-const char CameraProperties::BRIGHTNESS[] = "prop-brightness-default";
-const char CameraProperties::SATURATION[] = "prop-saturation-default";
-const char CameraProperties::SHARPNESS[] = "prop-sharpness-default";
-const char CameraProperties::IPP[] = "prop-ipp-default";
-const char CameraProperties::GBCE[] = "prop-gbce-default";
-const char CameraProperties::SUPPORTED_GBCE[] = "prop-gbce-supported";
-const char CameraProperties::GLBCE[] = "prop-glbce-default";
-const char CameraProperties::SUPPORTED_GLBCE[] = "prop-glbce-supported";
-const char CameraProperties::S3D_PRV_FRAME_LAYOUT[] = "prop-s3d-prv-frame-layout";
-const char CameraProperties::S3D_PRV_FRAME_LAYOUT_VALUES[] = "prop-s3d-prv-frame-layout-values";
-const char CameraProperties::S3D_CAP_FRAME_LAYOUT[] = "prop-s3d-cap-frame-layout";
-const char CameraProperties::S3D_CAP_FRAME_LAYOUT_VALUES[] = "prop-s3d-cap-frame-layout-values";
-const char CameraProperties::AUTOCONVERGENCE_MODE[] = "prop-auto-convergence-mode";
-const char CameraProperties::AUTOCONVERGENCE_MODE_VALUES[] = "prop-auto-convergence-mode-values";
-const char CameraProperties::MANUAL_CONVERGENCE[] = "prop-manual-convergence";
-const char CameraProperties::SUPPORTED_MANUAL_CONVERGENCE_MIN[] = "prop-supported-manual-convergence-min";
-const char CameraProperties::SUPPORTED_MANUAL_CONVERGENCE_MAX[] = "prop-supported-manual-convergence-max";
-const char CameraProperties::SUPPORTED_MANUAL_CONVERGENCE_STEP[] = "prop-supported-manual-convergence-step";
-const char CameraProperties::VSTAB[] = "prop-vstab-default";
-const char CameraProperties::VSTAB_SUPPORTED[] = "prop-vstab-supported";
-const char CameraProperties::VNF[] = "prop-vnf-default";
-const char CameraProperties::VNF_SUPPORTED[] = "prop-vnf-supported";
-const char CameraProperties::REVISION[] = "prop-revision";
-const char CameraProperties::FOCAL_LENGTH[] = "prop-focal-length";
-const char CameraProperties::HOR_ANGLE[] = "prop-horizontal-angle";
-const char CameraProperties::VER_ANGLE[] = "prop-vertical-angle";
-const char CameraProperties::FRAMERATE_RANGE[] = "prop-framerate-range-default";
-const char CameraProperties::FRAMERATE_RANGE_SUPPORTED[]="prop-framerate-range-values";
-const char CameraProperties::FRAMERATE_RANGE_EXT_SUPPORTED[]="prop-framerate-range-ext-values";
-const char CameraProperties::SENSOR_ORIENTATION[]= "sensor-orientation";
-const char CameraProperties::SENSOR_ORIENTATION_VALUES[]= "sensor-orientation-values";
-const char CameraProperties::EXIF_MAKE[] = "prop-exif-make";
-const char CameraProperties::EXIF_MODEL[] = "prop-exif-model";
-const char CameraProperties::JPEG_THUMBNAIL_QUALITY[] = "prop-jpeg-thumbnail-quality-default";
-const char CameraProperties::MAX_FOCUS_AREAS[] = "prop-max-focus-areas";
-const char CameraProperties::MAX_FD_HW_FACES[] = "prop-max-fd-hw-faces";
-const char CameraProperties::MAX_FD_SW_FACES[] = "prop-max-fd-sw-faces";
-const char CameraProperties::AUTO_EXPOSURE_LOCK[] = "prop-auto-exposure-lock";
-const char CameraProperties::AUTO_EXPOSURE_LOCK_SUPPORTED[] = "prop-auto-exposure-lock-supported";
-const char CameraProperties::AUTO_WHITEBALANCE_LOCK[] = "prop-auto-whitebalance-lock";
-const char CameraProperties::AUTO_WHITEBALANCE_LOCK_SUPPORTED[] = "prop-auto-whitebalance-lock-supported";
-const char CameraProperties::MAX_NUM_METERING_AREAS[] = "prop-max-num-metering-areas";
-const char CameraProperties::METERING_AREAS[] = "prop-metering-areas";
-const char CameraProperties::VIDEO_SNAPSHOT_SUPPORTED[] = "prop-video-snapshot-supported";
-const char CameraProperties::VIDEO_SIZE[] = "video-size";
-const char CameraProperties::SUPPORTED_VIDEO_SIZES[] = "video-size-values";
-const char CameraProperties::MECHANICAL_MISALIGNMENT_CORRECTION_SUPPORTED[] = "prop-mechanical-misalignment-correction-supported";
-const char CameraProperties::MECHANICAL_MISALIGNMENT_CORRECTION[] = "prop-mechanical-misalignment-correction";
-const char CameraProperties::CAP_MODE_VALUES[] = "prop-mode-values";
-const char CameraProperties::RAW_WIDTH[] = "prop-raw-width-values";
-const char CameraProperties::RAW_HEIGHT[] = "prop-raw-height-values";
-const char CameraProperties::MAX_PICTURE_WIDTH[] = "prop-max-picture-width";
-const char CameraProperties::MAX_PICTURE_HEIGHT[] = "prop-max-picture-height";
+#define CAMERA_PROPERTY_DEFINE(key, name) \
+    const CameraProperties::PropertyKey CameraProperties::key = { CameraProperties::PROP_##key, name };
+CAMERA_PROPERTY_KEYS(CAMERA_PROPERTY_DEFINE)
+#undef CAMERA_PROPERTY_DEFINE
 
 const char CameraProperties::DEFAULT_VALUE[] = "";
 
@@ -163,13 +53,104 @@ int CameraProperties::getProperties(int cameraIndex, CameraProperties::Propertie
     return 0;
 }
 
+static const char * const sPropertyNames[CameraProperties::PROPERTY_KEY_MAX] = {
+#define CAMERA_PROPERTY_NAME(key, name) name,
+    CAMERA_PROPERTY_KEYS(CAMERA_PROPERTY_NAME)
+#undef CAMERA_PROPERTY_NAME
+};
+
+// Key indices sorted by name, only used by the string-keyed accessors
+class PropertyNameIndex
+{
+public:
+    PropertyNameIndex()
+    {
+        for ( int i = 0 ; i < CameraProperties::PROPERTY_KEY_MAX ; i++ ) {
+            mSorted[i] = i;
+        }
+        qsort(mSorted, CameraProperties::PROPERTY_KEY_MAX, sizeof(mSorted[0]), compare);
+    }
+
+    int find(const char *name) const
+    {
+        int low = 0;
+        int high = CameraProperties::PROPERTY_KEY_MAX - 1;
+
+        while ( low <= high ) {
+            const int mid = ( low + high ) / 2;
+            const int cmp = strcmp(name, sPropertyNames[mSorted[mid]]);
+            if ( 0 == cmp ) {
+                return mSorted[mid];
+            } else if ( cmp < 0 ) {
+                high = mid - 1;
+            } else {
+                low = mid + 1;
+            }
+        }
+
+        return -1;
+    }
+
+private:
+    static int compare(const void *lhs, const void *rhs)
+    {
+        return strcmp(sPropertyNames[*(const int *) lhs], sPropertyNames[*(const int *) rhs]);
+    }
+
+    int mSorted[CameraProperties::PROPERTY_KEY_MAX];
+};
+
+static const PropertyNameIndex sPropertyNameIndex;
+
+static int parseInt(const char *value) {
+    if ( '\0' == *value ) {
+        return -1;
+    }
+    return strtol(value, 0, 0);
+}
+
+void CameraProperties::Properties::setValue(int mode, int index, const char *value, int intValue) {
+    Value &entry = mValues[mode][index];
+
+    if ( !value ) {
+        entry.mString = android::String8();
+        entry.mInt = -1;
+        entry.mPresent = false;
+    } else {
+        entry.mString.setTo(value);
+        entry.mInt = intValue;
+        entry.mPresent = true;
+    }
+}
+
+void CameraProperties::Properties::set(const PropertyKey &key, const char * const value) {
+    setValue(mCurrentMode, key.index, value, value ? parseInt(value) : -1);
+}
+
+void CameraProperties::Properties::set(const PropertyKey &key, const int value) {
+    char s_val[30];
+    sprintf(s_val, "%d", value);
+    setValue(mCurrentMode, key.index, s_val, value);
+}
+
+const char* CameraProperties::Properties::get(const PropertyKey &key) const {
+    return mValues[mCurrentMode][key.index].mString.string();
+}
+
+int CameraProperties::Properties::getInt(const PropertyKey &key) const {
+    return mValues[mCurrentMode][key.index].mInt;
+}
+
 void CameraProperties::Properties::set(const char * const prop, const char * const value) {
     CAMHAL_ASSERT(prop);
 
-    if ( !value ) {
-        mProperties[mCurrentMode].removeItem(android::String8(prop));
+    const int index = sPropertyNameIndex.find(prop);
+    if ( index >= 0 ) {
+        setValue(mCurrentMode, index, value, value ? parseInt(value) : -1);
+    } else if ( !value ) {
+        mExtraProperties[mCurrentMode].removeItem(android::String8(prop));
     } else {
-        mProperties[mCurrentMode].replaceValueFor(android::String8(prop), android::String8(value));
+        mExtraProperties[mCurrentMode].replaceValueFor(android::String8(prop), android::String8(value));
     }
 }
 
@@ -180,15 +161,19 @@ void CameraProperties::Properties::set(const char * const prop, const int value)
 }
 
 const char* CameraProperties::Properties::get(const char * prop) const {
-    return mProperties[mCurrentMode].valueFor(android::String8(prop)).string();
+    const int index = sPropertyNameIndex.find(prop);
+    if ( index >= 0 ) {
+        return mValues[mCurrentMode][index].mString.string();
+    }
+    return mExtraProperties[mCurrentMode].valueFor(android::String8(prop)).string();
 }
 
 int CameraProperties::Properties::getInt(const char * prop) const {
-    android::String8 value = mProperties[mCurrentMode].valueFor(android::String8(prop));
-    if (value.isEmpty()) {
-        return -1;
+    const int index = sPropertyNameIndex.find(prop);
+    if ( index >= 0 ) {
+        return mValues[mCurrentMode][index].mInt;
     }
-    return strtol(value, 0, 0);
+    return parseInt(mExtraProperties[mCurrentMode].valueFor(android::String8(prop)).string());
 }
 
 void CameraProperties::Properties::setSensorIndex(int idx) {
@@ -209,29 +194,140 @@ OperatingMode CameraProperties::Properties::getMode() const {
     return mCurrentMode;
 }
 
+size_t CameraProperties::Properties::count(int mode) const {
+    size_t ret = mExtraProperties[mode].size();
+
+    for ( int i = 0 ; i < PROPERTY_KEY_MAX ; i++ ) {
+        if ( mValues[mode][i].mPresent ) {
+            ret++;
+        }
+    }
+
+    return ret;
+}
+
 void CameraProperties::Properties::dump() {
     CAMHAL_LOGD("================================");
-    CAMHAL_LOGD("Dumping properties for camera: %d", getInt("prop-sensor-index"));
+    CAMHAL_LOGD("Dumping properties for camera: %d", getInt(CAMERA_SENSOR_INDEX));
 
-    for (size_t i = 0; i < mProperties[mCurrentMode].size(); i++) {
-        CAMHAL_LOGD("%s = %s",
-                mProperties[mCurrentMode].keyAt(i).string(),
-                mProperties[mCurrentMode].valueAt(i).string());
+    for (size_t i = 0; i < count(mCurrentMode); i++) {
+        CAMHAL_LOGD("%s = %s", keyAt(i), valueAt(i));
     }
 
     CAMHAL_LOGD("--------------------------------");
 }
 
+void CameraProperties::Properties::flatten(android::String8 &blob) const {
+    const int32_t currentMode = mCurrentMode;
+    blob.append((const char *) &currentMode, sizeof(currentMode));
+
+    for ( int mode = 0 ; mode < MODE_MAX ; mode++ ) {
+        const uint32_t count = this->count(mode);
+        blob.append((const char *) &count, sizeof(count));
+
+        // keys and values never contain NUL, so it doubles as the separator
+        for ( int i = 0 ; i < PROPERTY_KEY_MAX ; i++ ) {
+            const Value &value = mValues[mode][i];
+            if ( value.mPresent ) {
+                blob.append(sPropertyNames[i], strlen(sPropertyNames[i]) + 1);
+                blob.append(value.mString.string(), value.mString.length() + 1);
+            }
+        }
+
+        for ( size_t i = 0 ; i < mExtraProperties[mode].size() ; i++ ) {
+            const android::String8 &key = mExtraProperties[mode].keyAt(i);
+            const android::String8 &value = mExtraProperties[mode].valueAt(i);
+            blob.append(key.string(), key.length() + 1);
+            blob.append(value.string(), value.length() + 1);
+        }
+    }
+}
+
+static const char *unflattenString(const char *&data, const char *end) {
+    const char *str = data;
+    const char *nul = (const char *) memchr(data, '\0', end - data);
+
+    if ( NULL == nul ) {
+        return NULL;
+    }
+
+    data = nul + 1;
+    return str;
+}
+
+bool CameraProperties::Properties::unflatten(const char *&data, const char *end) {
+    int32_t currentMode;
+    if ( ( end - data ) < (ssize_t) sizeof(currentMode) ) {
+        return false;
+    }
+    memcpy(&currentMode, data, sizeof(currentMode));
+    data += sizeof(currentMode);
+
+    if ( ( currentMode < 0 ) || ( currentMode >= MODE_MAX ) ) {
+        return false;
+    }
+
+    for ( int mode = 0 ; mode < MODE_MAX ; mode++ ) {
+        uint32_t count;
+        if ( ( end - data ) < (ssize_t) sizeof(count) ) {
+            return false;
+        }
+        memcpy(&count, data, sizeof(count));
+        data += sizeof(count);
+
+        for ( int i = 0 ; i < PROPERTY_KEY_MAX ; i++ ) {
+            setValue(mode, i, NULL, -1);
+        }
+        mExtraProperties[mode].clear();
+
+        for ( uint32_t i = 0 ; i < count ; i++ ) {
+            const char *key = unflattenString(data, end);
+            const char *value = key ? unflattenString(data, end) : NULL;
+            if ( NULL == value ) {
+                return false;
+            }
+
+            const int index = sPropertyNameIndex.find(key);
+            if ( index >= 0 ) {
+                setValue(mode, index, value, parseInt(value));
+            } else {
+                mExtraProperties[mode].add(android::String8(key), android::String8(value));
+            }
+        }
+    }
+
+    mCurrentMode = static_cast<OperatingMode>(currentMode);
+
+    return true;
+}
+
+// Present known keys in index order come first, then the string-keyed extras
 const char* CameraProperties::Properties::keyAt(const unsigned int index) const {
-    if (index < mProperties[mCurrentMode].size()) {
-        return mProperties[mCurrentMode].keyAt(index).string();
+    unsigned int remaining = index;
+
+    for ( int i = 0 ; i < PROPERTY_KEY_MAX ; i++ ) {
+        if ( mValues[mCurrentMode][i].mPresent && ( 0 == remaining-- ) ) {
+            return sPropertyNames[i];
+        }
+    }
+
+    if (remaining < mExtraProperties[mCurrentMode].size()) {
+        return mExtraProperties[mCurrentMode].keyAt(remaining).string();
     }
     return NULL;
 }
 
 const char* CameraProperties::Properties::valueAt(const unsigned int index) const {
-    if (index < mProperties[mCurrentMode].size()) {
-        return mProperties[mCurrentMode].valueAt(index).string();
+    unsigned int remaining = index;
+
+    for ( int i = 0 ; i < PROPERTY_KEY_MAX ; i++ ) {
+        if ( mValues[mCurrentMode][i].mPresent && ( 0 == remaining-- ) ) {
+            return mValues[mCurrentMode][i].mString.string();
+        }
+    }
+
+    if (remaining < mExtraProperties[mCurrentMode].size()) {
+        return mExtraProperties[mCurrentMode].valueAt(remaining).string();
     }
     return NULL;
 }
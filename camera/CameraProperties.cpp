@@ -23,9 +23,15 @@
 
 #include "CameraProperties.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 #define CAMERA_ROOT         "CameraRoot"
 #define CAMERA_INSTANCE     "CameraInstance"
 
+#define CAPS_CACHE_PATH     "/data/misc/camera/camera-caps.cache"
+
 namespace Ti {
 namespace Camera {
 
@@ -39,6 +45,31 @@ static const char* g_camera_adapters[] = {
 #endif
 };
 
+///Bump whenever the adapters change the capabilities they report
+static const uint32_t CAPS_CACHE_MAGIC = 0x53504143; // "CAPS"
+static const uint32_t CAPS_CACHE_VERSION = 1;
+
+struct CapsCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t cameraCount;
+    uint32_t fingerprintSize;
+    uint32_t payloadSize;
+    uint32_t payloadHash;
+};
+
+static uint32_t hashCaps(const char *data, size_t size)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261U;
+    for ( size_t i = 0 ; i < size ; i++ ) {
+        hash ^= (uint8_t) data[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
 /*********************************************************
  CameraProperties - public function implemetation
 **********************************************************/
@@ -93,10 +124,28 @@ status_t CameraProperties::loadProperties()
     LOG_FUNCTION_NAME;
 
     status_t ret = NO_ERROR;
+    char fingerprint[PROPERTY_VALUE_MAX];
+    char value[PROPERTY_VALUE_MAX];
 
     //Must be re-initialized here, since loadProperties() could potentially be called more than once.
     mCamerasSupported = 0;
 
+    property_get("ro.build.fingerprint", fingerprint, "");
+    property_get("camera.caps.cache", value, "1");
+
+#ifdef V4L_CAMERA_ADAPTER
+    // USB cameras come and go, their capabilities can't be cached
+    const bool useCache = false;
+#else
+    const bool useCache = ( 0 != atoi(value) );
+#endif
+
+    if ( useCache && loadCachedProperties(fingerprint) ) {
+        CAMHAL_LOGI("num_cameras = %d, capabilities loaded from %s", mCamerasSupported, CAPS_CACHE_PATH);
+        LOG_FUNCTION_NAME_EXIT;
+        return NO_ERROR;
+    }
+
     // adapter updates capabilities and we update camera count
     const status_t err = CameraAdapter_Capabilities(mCameraProps, mCamerasSupported,
             MAX_CAMERAS_SUPPORTED, mCamerasSupported);
@@ -117,6 +166,10 @@ status_t CameraProperties::loadProperties()
             mCameraProps[i].setSensorIndex(i);
             mCameraProps[i].dump();
         }
+
+        if ( useCache ) {
+            saveCachedProperties(fingerprint);
+        }
     }
 
     CAMHAL_LOGV("mCamerasSupported = %d", mCamerasSupported);
@@ -124,6 +177,129 @@ status_t CameraProperties::loadProperties()
     return ret;
 }
 
+///Restores the properties of every camera from the cache file. Any mismatch in
+///magic, version, build fingerprint or payload hash is treated as a miss.
+bool CameraProperties::loadCachedProperties(const char *fingerprint)
+{
+    CapsCacheHeader header;
+    struct stat st;
+    char *buffer = NULL;
+    Properties *cached = NULL;
+    bool ret = false;
+    const size_t fingerprintSize = strlen(fingerprint);
+
+    int fd = open(CAPS_CACHE_PATH, O_RDONLY);
+    if ( fd < 0 ) {
+        return false;
+    }
+
+    if ( ( fstat(fd, &st) != 0 ) || ( st.st_size < (off_t) sizeof(header) ) ) {
+        close(fd);
+        return false;
+    }
+
+    // Whole cache in a single read
+    buffer = new char[st.st_size];
+    if ( read(fd, buffer, st.st_size) != st.st_size ) {
+        CAMHAL_LOGE("Short read of %s", CAPS_CACHE_PATH);
+        goto exit;
+    }
+
+    memcpy(&header, buffer, sizeof(header));
+
+    if ( ( CAPS_CACHE_MAGIC != header.magic ) ||
+         ( CAPS_CACHE_VERSION != header.version ) ||
+         ( 0 == header.cameraCount ) ||
+         ( (uint32_t) MAX_CAMERAS_SUPPORTED < header.cameraCount ) ||
+         ( fingerprintSize != header.fingerprintSize ) ||
+         ( (off_t) ( sizeof(header) + header.fingerprintSize + header.payloadSize ) != st.st_size ) ) {
+        CAMHAL_LOGD("Capability cache is stale or from another version");
+        goto exit;
+    }
+
+    if ( 0 != memcmp(buffer + sizeof(header), fingerprint, fingerprintSize) ) {
+        CAMHAL_LOGD("Capability cache was written by another build");
+        goto exit;
+    }
+
+    {
+        const char *data = buffer + sizeof(header) + fingerprintSize;
+        const char *end = data + header.payloadSize;
+
+        if ( hashCaps(data, header.payloadSize) != header.payloadHash ) {
+            CAMHAL_LOGE("Capability cache is corrupted");
+            goto exit;
+        }
+
+        // Scratch copies are a full value table each, keep them off the stack
+        cached = new Properties[header.cameraCount];
+        for ( uint32_t i = 0 ; i < header.cameraCount ; i++ ) {
+            int32_t sensorIndex;
+            if ( ( end - data ) < (ssize_t) sizeof(sensorIndex) ) {
+                goto exit;
+            }
+            memcpy(&sensorIndex, data, sizeof(sensorIndex));
+            data += sizeof(sensorIndex);
+
+            if ( ( (int32_t) i != sensorIndex ) || !cached[i].unflatten(data, end) ) {
+                CAMHAL_LOGE("Malformed capability cache entry for camera %u", i);
+                goto exit;
+            }
+        }
+
+        for ( uint32_t i = 0 ; i < header.cameraCount ; i++ ) {
+            mCameraProps[i] = cached[i];
+        }
+        mCamerasSupported = header.cameraCount;
+        ret = true;
+    }
+
+exit:
+    delete [] cached;
+    delete [] buffer;
+    close(fd);
+
+    return ret;
+}
+
+void CameraProperties::saveCachedProperties(const char *fingerprint) const
+{
+    CapsCacheHeader header;
+    android::String8 payload;
+    android::String8 tmpPath(CAPS_CACHE_PATH ".tmp");
+    bool written;
+
+    for ( int i = 0 ; i < mCamerasSupported ; i++ ) {
+        const int32_t sensorIndex = i;
+        payload.append((const char *) &sensorIndex, sizeof(sensorIndex));
+        mCameraProps[i].flatten(payload);
+    }
+
+    header.magic = CAPS_CACHE_MAGIC;
+    header.version = CAPS_CACHE_VERSION;
+    header.cameraCount = mCamerasSupported;
+    header.fingerprintSize = strlen(fingerprint);
+    header.payloadSize = payload.length();
+    header.payloadHash = hashCaps(payload.string(), payload.length());
+
+    int fd = open(tmpPath.string(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if ( fd < 0 ) {
+        CAMHAL_LOGD("Can't create %s: %s", tmpPath.string(), strerror(errno));
+        return;
+    }
+
+    written = ( write(fd, &header, sizeof(header)) == (ssize_t) sizeof(header) ) &&
+              ( write(fd, fingerprint, header.fingerprintSize) == (ssize_t) header.fingerprintSize ) &&
+              ( write(fd, payload.string(), payload.length()) == (ssize_t) payload.length() );
+    close(fd);
+
+    // Publish atomically so a concurrent or interrupted writer never leaves a torn cache
+    if ( !written || ( rename(tmpPath.string(), CAPS_CACHE_PATH) != 0 ) ) {
+        CAMHAL_LOGE("Failed to write capability cache %s", CAPS_CACHE_PATH);
+        unlink(tmpPath.string());
+    }
+}
+
 // Returns the number of Cameras found
 int CameraProperties::camerasSupported()
 {
@@ -64,76 +64,142 @@ static unsigned char jpeg_odml_dht[0x1a6] = {
     0xf9, 0xfa
 };
 
+/* Served in place of missing data when a frame is truncated */
+static const JOCTET jpeg_fake_eoi[2] = { 0xFF, JPEG_EOI };
+
 struct libjpeg_source_mgr : jpeg_source_mgr {
-    libjpeg_source_mgr(unsigned char *buffer_ptr, int len);
+    libjpeg_source_mgr(unsigned char *buffer_ptr, int len, bool insertDht);
     ~libjpeg_source_mgr();
 
-    unsigned char *mBufferPtr;
-    int mFilledLen;
+    // The stream is handed to libjpeg as a list of segments, either the frame
+    // alone or the SOI+DHT header followed by the frame without its own SOI
+    const JOCTET *mSegments[2];
+    long mSegmentLen[2];
+    int mSegmentCount;
+    int mNextSegment;
 };
 
 static void libjpeg_init_source(j_decompress_ptr cinfo) {
     libjpeg_source_mgr*  src = (libjpeg_source_mgr*)cinfo->src;
-    src->next_input_byte = (const JOCTET*)src->mBufferPtr;
+    src->next_input_byte = src->mSegments[0];
     src->bytes_in_buffer = 0;
     src->current_offset = 0;
+    src->mNextSegment = 0;
 }
 
 static boolean libjpeg_seek_input_data(j_decompress_ptr cinfo, long byte_offset) {
     libjpeg_source_mgr* src = (libjpeg_source_mgr*)cinfo->src;
-    src->current_offset = byte_offset;
-    src->next_input_byte = (const JOCTET*)src->mBufferPtr + byte_offset;
-    src->bytes_in_buffer = 0;
-    return TRUE;
+    long segment_start = 0;
+
+    for (int i = 0; i < src->mSegmentCount; i++) {
+        long segment_end = segment_start + src->mSegmentLen[i];
+        if (byte_offset < segment_end) {
+            src->current_offset = byte_offset;
+            src->next_input_byte = src->mSegments[i] + (byte_offset - segment_start);
+            src->bytes_in_buffer = segment_end - byte_offset;
+            src->mNextSegment = i + 1;
+            return TRUE;
+        }
+        segment_start = segment_end;
+    }
+
+    return FALSE;
 }
 
 static boolean libjpeg_fill_input_buffer(j_decompress_ptr cinfo) {
     libjpeg_source_mgr* src = (libjpeg_source_mgr*)cinfo->src;
-    src->current_offset += src->mFilledLen;
-    src->next_input_byte = src->mBufferPtr;
-    src->bytes_in_buffer = src->mFilledLen;
+
+    if (src->mNextSegment < src->mSegmentCount) {
+        if (src->mNextSegment > 0) {
+            src->current_offset += src->mSegmentLen[src->mNextSegment - 1];
+        }
+        src->next_input_byte = src->mSegments[src->mNextSegment];
+        src->bytes_in_buffer = src->mSegmentLen[src->mNextSegment];
+        src->mNextSegment++;
+    } else {
+        WARNMS(cinfo, JWRN_JPEG_EOF);
+        src->next_input_byte = jpeg_fake_eoi;
+        src->bytes_in_buffer = sizeof(jpeg_fake_eoi);
+    }
+
     return TRUE;
 }
 
 static void libjpeg_skip_input_data(j_decompress_ptr cinfo, long num_bytes) {
     libjpeg_source_mgr*  src = (libjpeg_source_mgr*)cinfo->src;
 
-    if (num_bytes > (long)src->bytes_in_buffer) {
-        CAMHAL_LOGEA("\n\n\n libjpeg_skip_input_data - num_bytes > (long)src->bytes_in_buffer \n\n\n");
-    } else {
-        src->next_input_byte += num_bytes;
-        src->bytes_in_buffer -= num_bytes;
+    if (num_bytes <= 0) {
+        return;
     }
-}
 
-static boolean libjpeg_resync_to_restart(j_decompress_ptr cinfo, int desired) {
-    libjpeg_source_mgr*  src = (libjpeg_source_mgr*)cinfo->src;
-    src->next_input_byte = (const JOCTET*)src->mBufferPtr;
-    src->bytes_in_buffer = 0;
-    return TRUE;
+    // Skipped data may span the header/frame boundary
+    while (num_bytes > (long)src->bytes_in_buffer) {
+        num_bytes -= (long)src->bytes_in_buffer;
+        libjpeg_fill_input_buffer(cinfo);
+    }
+
+    src->next_input_byte += num_bytes;
+    src->bytes_in_buffer -= num_bytes;
 }
 
 static void libjpeg_term_source(j_decompress_ptr /*cinfo*/) {}
 
-libjpeg_source_mgr::libjpeg_source_mgr(unsigned char *buffer_ptr, int len) : mBufferPtr(buffer_ptr), mFilledLen(len) {
+libjpeg_source_mgr::libjpeg_source_mgr(unsigned char *buffer_ptr, int len, bool insertDht)
+    : mSegmentCount(0), mNextSegment(0) {
     init_source = libjpeg_init_source;
     fill_input_buffer = libjpeg_fill_input_buffer;
     skip_input_data = libjpeg_skip_input_data;
-    resync_to_restart = libjpeg_resync_to_restart;
+    resync_to_restart = jpeg_resync_to_restart;
     term_source = libjpeg_term_source;
     seek_input_data = libjpeg_seek_input_data;
+
+    if (insertDht && (len > 2)) {
+        mSegments[mSegmentCount] = jpeg_odml_dht;
+        mSegmentLen[mSegmentCount++] = sizeof(jpeg_odml_dht);
+        mSegments[mSegmentCount] = buffer_ptr + 2;
+        mSegmentLen[mSegmentCount++] = len - 2;
+    } else {
+        mSegments[mSegmentCount] = buffer_ptr;
+        mSegmentLen[mSegmentCount++] = len;
+    }
 }
 
 libjpeg_source_mgr::~libjpeg_source_mgr() {}
 
+static void interleaveChroma(unsigned char *uv, const unsigned char *u, const unsigned char *v, int width) {
+#ifdef ARCH_ARM_HAVE_NEON
+    int n = width & ~15;
+    width -= n;
+    if (n > 0) {
+        asm volatile (
+        "0: @ 16 pixel interleave                                       \n\t"
+        "   vld1.8  {q0}, [%[u]]!                                       \n\t"
+        "   vld1.8  {q1}, [%[v]]!                                       \n\t"
+        "   vst2.8  {q0, q1}, [%[uv]]!   @ uvuv..                       \n\t"
+        "   subs %[n], %[n], #16                                        \n\t"
+        "   bgt 0b                                                      \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [uv] "+r" (uv), [u] "+r" (u), [v] "+r" (v), [n] "+r" (n)
+        :
+        : "cc", "memory", "q0", "q1"
+        );
+    }
+#endif
+    while ((width--) > 0) {
+        uv[0] = *u++;
+        uv[1] = *v++;
+        uv += 2;
+    }
+}
+
 Decoder_libjpeg::Decoder_libjpeg()
 {
     mWidth = 0;
     mHeight = 0;
-    Y_Plane = NULL;
-    U_Plane = NULL;
-    V_Plane = NULL;
-    UV_Plane = NULL;
+    mChromaRows = NULL;
+    mDummyRow = NULL;
 }
 
 Decoder_libjpeg::~Decoder_libjpeg()
@@ -143,21 +209,10 @@ Decoder_libjpeg::~Decoder_libjpeg()
 
 void Decoder_libjpeg::release()
 {
-    if (Y_Plane) {
-        free(Y_Plane);
-        Y_Plane = NULL;
-    }
-    if (U_Plane) {
-        free(U_Plane);
-        U_Plane = NULL;
-    }
-    if (V_Plane) {
-        free(V_Plane);
-        V_Plane = NULL;
-    }
-    if (UV_Plane) {
-        free(UV_Plane);
-        UV_Plane = NULL;
+    if (mChromaRows) {
+        free(mChromaRows);
+        mChromaRows = NULL;
+        mDummyRow = NULL;
     }
 }
 
@@ -200,11 +255,12 @@ int Decoder_libjpeg::appendDHT(unsigned char *jpeg_src, int filled_len, unsigned
 }
 
 
-bool Decoder_libjpeg::decode(unsigned char *jpeg_src, int filled_len, unsigned char *nv12_buffer, int stride)
+bool Decoder_libjpeg::decode(unsigned char *jpeg_src, int filled_len, unsigned char *nv12_buffer, int stride,
+                             bool insertDht)
 {
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr jerr;
-    struct libjpeg_source_mgr s_mgr(jpeg_src, filled_len);
+    struct libjpeg_source_mgr s_mgr(jpeg_src, filled_len, insertDht);
 
     if (filled_len == 0)
         return false;
@@ -216,6 +272,17 @@ bool Decoder_libjpeg::decode(unsigned char *jpeg_src, int filled_len, unsigned c
     int status = jpeg_read_header(&cinfo, true);
     if (status != JPEG_HEADER_OK) {
         CAMHAL_LOGEA("jpeg header corrupted");
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    // Only 2x horizontally subsampled chroma (4:2:2 or 4:2:0) maps onto NV12
+    if ((cinfo.num_components != NUM_COMPONENTS_IN_YUV) ||
+        (cinfo.comp_info[0].h_samp_factor != 2) ||
+        (cinfo.comp_info[1].h_samp_factor != 1) || (cinfo.comp_info[1].v_samp_factor != 1) ||
+        (cinfo.comp_info[2].h_samp_factor != 1) || (cinfo.comp_info[2].v_samp_factor != 1)) {
+        CAMHAL_LOGEA("Unsupported jpeg sampling factors");
+        jpeg_destroy_decompress(&cinfo);
         return false;
     }
 
@@ -224,70 +291,69 @@ bool Decoder_libjpeg::decode(unsigned char *jpeg_src, int filled_len, unsigned c
     status = jpeg_start_decompress(&cinfo);
     if (!status){
         CAMHAL_LOGEA("jpeg_start_decompress failed");
+        jpeg_destroy_decompress(&cinfo);
         return false;
     }
 
-    if (mWidth == 0){
-        mWidth = cinfo.output_width;
-        mHeight = cinfo.output_height;
-        CAMHAL_LOGEA("w x h = %d x %d. stride=%d", cinfo.output_width, cinfo.output_height, stride);
-    }
-    else if ((cinfo.output_width > mWidth) || (cinfo.output_height > mHeight)) {
-        CAMHAL_LOGEA(" Free the existing buffers so that they are reallocated for new w x h. Old WxH = %dx%d. New WxH = %dx%d",
-        mWidth, mHeight, cinfo.output_width, cinfo.output_height);
+    // Rows are decoded in whole iMCU rows, 16 pixels wide blocks at most
+    const unsigned int alignedWidth = (cinfo.output_width + 2 * DCTSIZE - 1) & ~(2 * DCTSIZE - 1);
+    const unsigned int chromaStride = alignedWidth / 2;
+
+    if ((mChromaRows == NULL) || (cinfo.output_width > mWidth)) {
+        CAMHAL_LOGDB("(Re)allocating chroma rows for w x h = %d x %d. stride=%d",
+                     cinfo.output_width, cinfo.output_height, stride);
         release();
         mWidth = cinfo.output_width;
         mHeight = cinfo.output_height;
+        mChromaRows = (unsigned char *)malloc(alignedWidth * (DCTSIZE + 1));
+        if (mChromaRows == NULL) {
+            CAMHAL_LOGEA("Unable to allocate chroma rows");
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+        mDummyRow = mChromaRows + alignedWidth * DCTSIZE;
     }
 
-    unsigned int decoded_uv_buffer_size = cinfo.output_width * cinfo.output_height / 2;
-    if (Y_Plane == NULL)Y_Plane = (unsigned char **)malloc(cinfo.output_height * sizeof(unsigned char *));
-    if (U_Plane == NULL)U_Plane = (unsigned char **)malloc(cinfo.output_height * sizeof(unsigned char *));
-    if (V_Plane == NULL)V_Plane = (unsigned char **)malloc(cinfo.output_height * sizeof(unsigned char *));
-    if (UV_Plane == NULL) UV_Plane = (unsigned char *)malloc(decoded_uv_buffer_size);
-
-    unsigned char **YUV_Planes[NUM_COMPONENTS_IN_YUV];
-    YUV_Planes[0] = Y_Plane;
-    YUV_Planes[1] = U_Plane;
-    YUV_Planes[2] = V_Plane;
-
-    unsigned char *row = &nv12_buffer[0];
-
-    // Y Component
-    for (unsigned int j = 0; j < cinfo.output_height; j++, row += stride)
-        YUV_Planes[0][j] = row;
-
-    row = &UV_Plane[0];
-
-    // U Component
-    for (unsigned int j = 0; j < cinfo.output_height; j+=2, row += cinfo.output_width / 2){
-        YUV_Planes[1][j+0] = row;
-        YUV_Planes[1][j+1] = row;
+    const unsigned int lumaRows = cinfo.max_v_samp_factor * DCTSIZE;
+    const unsigned int chromaRows = DCTSIZE;
+    const unsigned int uvRows = lumaRows / 2;
+    const unsigned int uvHeight = cinfo.output_height / 2;
+
+    unsigned char *uScratch = mChromaRows;
+    unsigned char *vScratch = mChromaRows + chromaStride * DCTSIZE;
+    unsigned char *uvPlane = nv12_buffer + (stride * cinfo.output_height);
+
+    JSAMPROW yRows[2 * DCTSIZE];
+    JSAMPROW uRows[DCTSIZE];
+    JSAMPROW vRows[DCTSIZE];
+    JSAMPARRAY YUV_Planes[NUM_COMPONENTS_IN_YUV] = { yRows, uRows, vRows };
+
+    // For 4:2:2 sources two chroma rows land on one NV12 row, the second wins
+    for (unsigned int k = 0; k < chromaRows; k++) {
+        unsigned int uvRow = k * uvRows / chromaRows;
+        uRows[k] = uScratch + (uvRow * chromaStride);
+        vRows[k] = vScratch + (uvRow * chromaStride);
     }
 
-    // V Component
-    for (unsigned int j = 0; j < cinfo.output_height; j+=2, row += cinfo.output_width / 2){
-        YUV_Planes[2][j+0] = row;
-        YUV_Planes[2][j+1] = row;
-    }
+    // Y goes straight to the output, chroma is interleaved while still in cache
+    while (cinfo.output_scanline < cinfo.output_height) {
+        unsigned int row = cinfo.output_scanline;
 
-    // Interleaving U and V
-    for (unsigned int i = 0; i < cinfo.output_height; i += 8) {
-        jpeg_read_raw_data(&cinfo, YUV_Planes, 8);
-        YUV_Planes[0] += 8;
-        YUV_Planes[1] += 8;
-        YUV_Planes[2] += 8;
-    }
+        for (unsigned int k = 0; k < lumaRows; k++) {
+            yRows[k] = (row + k < cinfo.output_height) ? nv12_buffer + ((row + k) * stride) : mDummyRow;
+        }
+
+        if (jpeg_read_raw_data(&cinfo, YUV_Planes, lumaRows) == 0) {
+            CAMHAL_LOGEA("jpeg_read_raw_data failed");
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
 
-    unsigned char *uv_ptr = nv12_buffer + (stride * cinfo.output_height);
-    unsigned char *u_ptr = UV_Plane;
-    unsigned char *v_ptr = UV_Plane + (decoded_uv_buffer_size / 2);
-    for(unsigned int i = 0; i < cinfo.output_height / 2; i++){
-        for(unsigned int j = 0; j < cinfo.output_width; j+=2){
-            *(uv_ptr + j) = *u_ptr; u_ptr++;
-            *(uv_ptr + j + 1) = *v_ptr; v_ptr++;
+        for (unsigned int k = 0; (k < uvRows) && (row / 2 + k < uvHeight); k++) {
+            interleaveChroma(uvPlane + ((row / 2 + k) * stride),
+                             uScratch + (k * chromaStride), vScratch + (k * chromaStride),
+                             cinfo.output_width / 2);
         }
-        uv_ptr = uv_ptr + stride;
     }
 
     jpeg_finish_decompress(&cinfo);
@@ -25,6 +25,7 @@
 
 #include "Encoder_libjpeg.h"
 #include "NV12_resize.h"
+#include "YuvConverter.h"
 #include "TICameraParameters.h"
 
 #include <stdlib.h>
@@ -118,122 +119,6 @@ static void nv21_to_yuv(uint8_t* dst, uint8_t* y, uint8_t* uv, int width) {
     }
 }
 
-static void uyvy_to_yuv(uint8_t* dst, uint32_t* src, int width) {
-    if (!dst || !src) {
-        return;
-    }
-
-    if (width % 2) {
-        return; // not supporting odd widths
-    }
-
-#ifdef ARCH_ARM_HAVE_NEON
-    // currently, neon routine only supports multiple of 16 width
-    if ((width % 16) == 0) {
-        int n = width;
-        asm volatile (
-        "   pld [%[src], %[src_stride], lsl #2]                         \n\t"
-        "   cmp %[n], #16                                               \n\t"
-        "   blt 5f                                                      \n\t"
-        "0: @ 16 pixel swap                                             \n\t"
-        "   vld2.8  {q0, q1} , [%[src]]! @ q0 = uv q1 = y               \n\t"
-        "   vuzp.8 q0, q2                @ d0 = u d4 = v                \n\t"
-        "   vmov d1, d0                  @ q0 = u0u1u2..u0u1u2...       \n\t"
-        "   vmov d5, d4                  @ q2 = v0v1v2..v0v1v2...       \n\t"
-        "   vzip.8 d0, d1                @ q0 = u0u0u1u1u2u2...         \n\t"
-        "   vzip.8 d4, d5                @ q2 = v0v0v1v1v2v2...         \n\t"
-        "   vswp q0, q1                  @ now q0 = y q1 = u q2 = v     \n\t"
-        "   vst3.8  {d0,d2,d4},[%[dst]]!                                \n\t"
-        "   vst3.8  {d1,d3,d5},[%[dst]]!                                \n\t"
-        "   sub %[n], %[n], #16                                         \n\t"
-        "   cmp %[n], #16                                               \n\t"
-        "   bge 0b                                                      \n\t"
-        "5: @ end                                                       \n\t"
-#ifdef NEEDS_ARM_ERRATA_754319_754320
-        "   vmov s0,s0  @ add noop for errata item                      \n\t"
-#endif
-        : [dst] "+r" (dst), [src] "+r" (src), [n] "+r" (n)
-        : [src_stride] "r" (width)
-        : "cc", "memory", "q0", "q1", "q2"
-        );
-    } else
-#endif
-    {
-        while ((width-=2) >= 0) {
-            uint8_t u0 = (src[0] >> 0) & 0xFF;
-            uint8_t y0 = (src[0] >> 8) & 0xFF;
-            uint8_t v0 = (src[0] >> 16) & 0xFF;
-            uint8_t y1 = (src[0] >> 24) & 0xFF;
-            dst[0] = y0;
-            dst[1] = u0;
-            dst[2] = v0;
-            dst[3] = y1;
-            dst[4] = u0;
-            dst[5] = v0;
-            dst += 6;
-            src++;
-        }
-    }
-}
-
-static void yuyv_to_yuv(uint8_t* dst, uint32_t* src, int width) {
-    if (!dst || !src) {
-        return;
-    }
-
-    if (width % 2) {
-        return; // not supporting odd widths
-    }
-
-#ifdef ARCH_ARM_HAVE_NEON
-    // currently, neon routine only supports multiple of 16 width
-    if ((width % 16) == 0) {
-        int n = width;
-        asm volatile (
-        "   pld [%[src], %[src_stride], lsl #2]                         \n\t"
-        "   cmp %[n], #16                                               \n\t"
-        "   blt 5f                                                      \n\t"
-        "0: @ 16 pixel swap                                             \n\t"
-        "   vld2.8  {q0, q1} , [%[src]]! @ q0 = yyyy.. q1 = uvuv..      \n\t"
-        "   vuzp.8 q1, q2                @ d2 = u d4 = v                \n\t"
-        "   vmov d3, d2                  @ q1 = u0u1u2..u0u1u2...       \n\t"
-        "   vmov d5, d4                  @ q2 = v0v1v2..v0v1v2...       \n\t"
-        "   vzip.8 d2, d3                @ q1 = u0u0u1u1u2u2...         \n\t"
-        "   vzip.8 d4, d5                @ q2 = v0v0v1v1v2v2...         \n\t"
-        "                                @ now q0 = y q1 = u q2 = v     \n\t"
-        "   vst3.8  {d0,d2,d4},[%[dst]]!                                \n\t"
-        "   vst3.8  {d1,d3,d5},[%[dst]]!                                \n\t"
-        "   sub %[n], %[n], #16                                         \n\t"
-        "   cmp %[n], #16                                               \n\t"
-        "   bge 0b                                                      \n\t"
-        "5: @ end                                                       \n\t"
-#ifdef NEEDS_ARM_ERRATA_754319_754320
-        "   vmov s0,s0  @ add noop for errata item                      \n\t"
-#endif
-        : [dst] "+r" (dst), [src] "+r" (src), [n] "+r" (n)
-        : [src_stride] "r" (width)
-        : "cc", "memory", "q0", "q1", "q2"
-        );
-    } else
-#endif
-    {
-        while ((width-=2) >= 0) {
-            uint8_t y0 = (src[0] >> 0) & 0xFF;
-            uint8_t u0 = (src[0] >> 8) & 0xFF;
-            uint8_t y1 = (src[0] >> 16) & 0xFF;
-            uint8_t v0 = (src[0] >> 24) & 0xFF;
-            dst[0] = y0;
-            dst[1] = u0;
-            dst[2] = v0;
-            dst[3] = y1;
-            dst[4] = u0;
-            dst[5] = v0;
-            dst += 6;
-            src++;
-        }
-    }
-}
-
 static void resize_nv12(Encoder_libjpeg::params* params, uint8_t* dst_buffer) {
     structConvImage o_img_ptr, i_img_ptr;
 
@@ -359,17 +244,38 @@ void ExifElementsTable::saveJpeg(unsigned char* jpeg, size_t jpeg_size) {
 
 /* public functions */
 ExifElementsTable::~ExifElementsTable() {
-    int num_elements = gps_tag_count + exif_tag_count;
+    if (jpeg_opened) {
+        DiscardData();
+    }
+}
 
-    for (int i = 0; i < num_elements; i++) {
-        if (table[i].Value) {
-            free(table[i].Value);
+void ExifElementsTable::clear() {
+    gps_tag_count = 0;
+    exif_tag_count = 0;
+    position = 0;
+    values_size = 0;
+#ifdef ANDROID_API_JB_OR_LATER
+    has_datetime_tag = false;
+#endif
+}
+
+void ExifElementsTable::copyFrom(const ExifElementsTable& tmpl) {
+    memcpy(table, tmpl.table, sizeof(ExifElement_t) * tmpl.position);
+    memcpy(values, tmpl.values, tmpl.values_size);
+
+    for (unsigned int i = 0; i < tmpl.position; i++) {
+        if (tmpl.table[i].Value) {
+            table[i].Value = values + (tmpl.table[i].Value - tmpl.values);
         }
     }
 
-    if (jpeg_opened) {
-        DiscardData();
-    }
+    gps_tag_count = tmpl.gps_tag_count;
+    exif_tag_count = tmpl.exif_tag_count;
+    position = tmpl.position;
+    values_size = tmpl.values_size;
+#ifdef ANDROID_API_JB_OR_LATER
+    has_datetime_tag = tmpl.has_datetime_tag;
+#endif
 }
 
 status_t ExifElementsTable::insertElement(const char* tag, const char* value) {
@@ -391,6 +297,11 @@ status_t ExifElementsTable::insertElement(const char* tag, const char* value) {
         value_length = strlen(value);
     }
 
+    if (values_size + value_length + 1 > MAX_EXIF_VALUES_SIZE) {
+        CAMHAL_LOGEB("No room left for EXIF value of %s", tag);
+        return NO_MEMORY;
+    }
+
     if (IsGpsTag(tag)) {
         table[position].GpsTag = TRUE;
         table[position].Tag = GpsTagNameToValue(tag);
@@ -412,13 +323,10 @@ status_t ExifElementsTable::insertElement(const char* tag, const char* value) {
         }
     }
 
-    table[position].DataLength = 0;
-    table[position].Value = (char*) malloc(sizeof(char) * (value_length + 1));
-
-    if (table[position].Value) {
-        memcpy(table[position].Value, value, value_length + 1);
-        table[position].DataLength = value_length + 1;
-    }
+    table[position].Value = values + values_size;
+    memcpy(table[position].Value, value, value_length + 1);
+    table[position].DataLength = value_length + 1;
+    values_size += value_length + 1;
 
     position++;
     return ret;
@@ -437,6 +345,8 @@ size_t Encoder_libjpeg::encode(params* input) {
     int out_height = 0, in_height = 0;
     int bpp = 2; // for uyvy
     int right_crop = 0, start_offset = 0;
+    bool isNV21 = false;
+    Yuv422Layout layout = YUV422_LAYOUT_YUYV;
 
     if (!input) {
         return 0;
@@ -508,16 +418,19 @@ size_t Encoder_libjpeg::encode(params* input) {
     row_src = src + start_offset;
     row_uv = src + out_width * out_height * bpp;
 
+    isNV21 = (strcmp(input->format, android::CameraParameters::PIXEL_FORMAT_YUV420SP) == 0);
+    if (strcmp(input->format, TICameraParameters::PIXEL_FORMAT_YUV422I_UYVY) == 0) {
+        layout = YUV422_LAYOUT_UYVY;
+    }
+
     while ((cinfo.next_scanline < cinfo.image_height) && !mCancelEncoding) {
         JSAMPROW row[1];    /* pointer to JSAMPLE row[s] */
 
         // convert input yuv format to yuv444
-        if (strcmp(input->format, android::CameraParameters::PIXEL_FORMAT_YUV420SP) == 0) {
+        if (isNV21) {
             nv21_to_yuv(row_tmp, row_src, row_uv, out_width - right_crop);
-        } else if (strcmp(input->format, TICameraParameters::PIXEL_FORMAT_YUV422I_UYVY) == 0) {
-            uyvy_to_yuv(row_tmp, (uint32_t*)row_src, out_width - right_crop);
-        } else if (strcmp(input->format, android::CameraParameters::PIXEL_FORMAT_YUV422I) == 0) {
-            yuyv_to_yuv(row_tmp, (uint32_t*)row_src, out_width - right_crop);
+        } else {
+            convertYUV422RowToYUV444(row_tmp, row_src, out_width - right_crop, layout);
         }
 
         row[0] = row_tmp;
@@ -525,7 +438,7 @@ size_t Encoder_libjpeg::encode(params* input) {
         row_src = row_src + out_width*bpp;
 
         // move uv row if input format needs it
-        if (strcmp(input->format, android::CameraParameters::PIXEL_FORMAT_YUV420SP) == 0) {
+        if (isNV21) {
             if (!(cinfo.next_scanline % 2))
                 row_uv = row_uv +  out_width * bpp;
         }
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+* @file FrameTracer.cpp
+*
+* Per-frame stage latency tracing for the preview path. Only built when
+* CAMERAHAL_FRAME_TRACE is defined.
+*
+*/
+
+#include "FrameTracer.h"
+
+#ifdef CAMERAHAL_FRAME_TRACE
+
+#include <unistd.h>
+#include <utils/KeyedVector.h>
+#include <utils/String8.h>
+#include <utils/Vector.h>
+
+namespace Ti {
+namespace Camera {
+
+FrameTracer FrameTracer::sInstance;
+
+static const char * const sStageNames[FrameTracer::STAGE_MAX] = {
+    "FillBufferDone",
+    "Dispatch",
+    "AppCallback",
+    "DisplayPost",
+    "DisplayEnqueue",
+    "Return",
+};
+
+static int compareLatency(const nsecs_t *lhs, const nsecs_t *rhs)
+{
+    if ( *lhs < *rhs ) {
+        return -1;
+    }
+
+    return ( *lhs > *rhs ) ? 1 : 0;
+}
+
+static nsecs_t percentile(const android::Vector<nsecs_t> &sorted, int pct)
+{
+    return sorted[( ( sorted.size() - 1 ) * pct ) / 100];
+}
+
+void FrameTracer::dump(int fd) const
+{
+    android::KeyedVector<const void *, nsecs_t> frameStart;
+    android::Vector<nsecs_t> latencies[STAGE_MAX];
+    size_t frames = 0;
+
+    const uint32_t next = (uint32_t) android_atomic_acquire_load(&mNext);
+    const uint32_t count = ( next < (uint32_t) RING_SIZE ) ? next : (uint32_t) RING_SIZE;
+
+    for ( uint32_t seq = next - count ; seq != next ; seq++ ) {
+        const Event &event = mEvents[seq & ( RING_SIZE - 1 )];
+
+        if ( android_atomic_acquire_load(&event.mSeq) != (int32_t) ( seq + 1 ) ) {
+            continue;
+        }
+
+        const void *key = event.mKey;
+        const int stage = event.mStage;
+        const nsecs_t timestamp = event.mTimestamp;
+
+        // Skip events a writer started to overwrite while they were being copied
+        if ( android_atomic_release_load(&event.mSeq) != (int32_t) ( seq + 1 ) ) {
+            continue;
+        }
+
+        if ( STAGE_FILL_BUFFER_DONE == stage ) {
+            frameStart.add(key, timestamp);
+            frames++;
+        } else if ( ( 0 < stage ) && ( stage < STAGE_MAX ) ) {
+            ssize_t index = frameStart.indexOfKey(key);
+            if ( 0 <= index ) {
+                latencies[stage].push(timestamp - frameStart.valueAt(index));
+            }
+        }
+    }
+
+    android::String8 result;
+    result.appendFormat("Frame trace: %u frames, latency from %s in us\n",
+                        (unsigned int) frames, sStageNames[STAGE_FILL_BUFFER_DONE]);
+    result.appendFormat("  %-16s %8s %8s %8s %8s\n", "stage", "count", "p50", "p99", "max");
+
+    for ( int stage = STAGE_FILL_BUFFER_DONE + 1 ; stage < STAGE_MAX ; stage++ ) {
+        android::Vector<nsecs_t> &sorted = latencies[stage];
+        if ( sorted.isEmpty() ) {
+            result.appendFormat("  %-16s %8u %8s %8s %8s\n", sStageNames[stage], 0, "-", "-", "-");
+            continue;
+        }
+
+        sorted.sort(compareLatency);
+        result.appendFormat("  %-16s %8u %8lld %8lld %8lld\n",
+                            sStageNames[stage],
+                            (unsigned int) sorted.size(),
+                            (long long) ns2us(percentile(sorted, 50)),
+                            (long long) ns2us(percentile(sorted, 99)),
+                            (long long) ns2us(sorted[sorted.size() - 1]));
+    }
+
+    write(fd, result.string(), result.size());
+}
+
+} // namespace Camera
+} // namespace Ti
+
+#endif //CAMERAHAL_FRAME_TRACE
@@ -17,6 +17,8 @@
 #include "CameraHal.h"
 #include "TICameraParameters.h"
 
+#include <cutils/properties.h>
+
 extern "C" {
 
 //#include <timm_osal_interfaces.h>
@@ -34,14 +36,21 @@ namespace Camera {
 
 #define ALLOCATION_2D 2
 
+///Default upper bound in KB for mapped ion memory parked in the reuse pool
+#define DEFAULT_POOL_MAX_KB "24576"
+
 ///Utility Macro Declarations
 
 /*--------------------MemoryManager Class STARTS here-----------------------------*/
 MemoryManager::MemoryManager() {
     mIonFd = -1;
+    mPoolBytes = 0;
+    mPoolMaxBytes = 0;
 }
 
 MemoryManager::~MemoryManager() {
+    trimPool();
+
     if ( mIonFd >= 0 ) {
         ion_close(mIonFd);
         mIonFd = -1;
@@ -58,6 +67,10 @@ status_t MemoryManager::initialize() {
         }
     }
 
+    char value[PROPERTY_VALUE_MAX];
+    property_get("camera.ion.pool.maxkb", value, DEFAULT_POOL_MAX_KB);
+    mPoolMaxBytes = (size_t) atoi(value) * 1024;
+
     return OK;
 }
 
@@ -67,6 +80,16 @@ CameraBuffer* MemoryManager::allocateBufferList(int width, int height, const cha
 
     CAMHAL_ASSERT(mIonFd != -1);
 
+    bool poolTrimmed = false;
+
+    if ( ( size != 0 ) && ( numBufs > 0 ) ) {
+        CameraBuffer *pooled = takePooledList(size, CameraHal::getPixelFormatConstant(format), numBufs);
+        if ( NULL != pooled ) {
+            LOG_FUNCTION_NAME_EXIT;
+            return pooled;
+        }
+    }
+
     ///We allocate numBufs+1 because the last entry will be marked NULL to indicate end of array, which is used when freeing
     ///the buffers
     const uint numArrayEntriesC = (uint)(numBufs+1);
@@ -103,6 +126,16 @@ CameraBuffer* MemoryManager::allocateBufferList(int width, int height, const cha
                 OMAP_ION_HEAP_TILER_MASK, &handle, &stride);
             }
 
+            if ( ( (ret < 0) || ((int)handle == -ENOMEM) ) && !poolTrimmed ) {
+                ///Parked lists may be what exhausted the heap, drop them and retry once
+                poolTrimmed = true;
+                if ( trimPool() > 0 ) {
+                    CAMHAL_LOGDB("Retrying ion allocation of size=%d after trimming the pool", size);
+                    i--;
+                    continue;
+                }
+            }
+
             if((ret < 0) || ((int)handle == -ENOMEM)) {
                 CAMHAL_LOGEB("FAILED to allocate ion buffer of size=%d. ret=%d(0x%x)", size, ret, ret);
                 goto error;
@@ -136,7 +169,7 @@ error:
 
     CAMHAL_LOGE("Freeing buffers already allocated after error occurred");
     if(buffers)
-        freeBufferList(buffers);
+        releaseBufferList(buffers);
 
     if ( NULL != mErrorNotifier.get() )
         mErrorNotifier->errorNotify(-ENOMEM);
@@ -177,8 +210,6 @@ int MemoryManager::freeBufferList(CameraBuffer *buffers)
     status_t ret = NO_ERROR;
     LOG_FUNCTION_NAME;
 
-    int i;
-
     if(!buffers)
         {
         CAMHAL_LOGEA("NULL pointer passed to freebuffer");
@@ -186,7 +217,19 @@ int MemoryManager::freeBufferList(CameraBuffer *buffers)
         return BAD_VALUE;
         }
 
-    i = 0;
+    if ( !poolBufferList(buffers) )
+        {
+        releaseBufferList(buffers);
+        }
+
+    LOG_FUNCTION_NAME_EXIT;
+    return ret;
+}
+
+void MemoryManager::releaseBufferList(CameraBuffer *buffers)
+{
+    int i = 0;
+
     while(buffers[i].type == CAMERA_BUFFER_ION)
         {
         if(buffers[i].size)
@@ -203,9 +246,102 @@ int MemoryManager::freeBufferList(CameraBuffer *buffers)
         }
 
     delete [] buffers;
+}
 
-    LOG_FUNCTION_NAME_EXIT;
-    return ret;
+bool MemoryManager::poolBufferList(CameraBuffer *buffers)
+{
+    int numBufs = 0;
+    int size = buffers[0].size;
+
+    while ( buffers[numBufs].type == CAMERA_BUFFER_ION ) {
+        if ( ( 0 == buffers[numBufs].size ) || ( (int) buffers[numBufs].size != size ) ) {
+            return false;
+        }
+        numBufs++;
+    }
+
+    const size_t bytes = (size_t) size * numBufs;
+    if ( ( 0 == numBufs ) || ( bytes > mPoolMaxBytes ) ) {
+        return false;
+    }
+
+    android::AutoMutex lock(mPoolLock);
+
+    ///Evict the least recently freed lists until the new one fits
+    while ( ( mPoolBytes + bytes ) > mPoolMaxBytes ) {
+        const PooledList &oldest = mPool[0];
+        mPoolBytes -= (size_t) oldest.size * oldest.numBufs;
+        releaseBufferList(oldest.buffers);
+        mPool.removeAt(0);
+    }
+
+    PooledList entry;
+    entry.buffers = buffers;
+    entry.numBufs = numBufs;
+    entry.size = size;
+    entry.format = buffers[0].format;
+    mPool.push(entry);
+    mPoolBytes += bytes;
+
+    CAMHAL_LOGDB("Pooled %d ion buffers of size=%d, pool holds %u bytes",
+                 numBufs, size, (unsigned int) mPoolBytes);
+
+    return true;
+}
+
+CameraBuffer *MemoryManager::takePooledList(int size, const char *format, int numBufs)
+{
+    android::AutoMutex lock(mPoolLock);
+
+    for ( ssize_t i = (ssize_t) mPool.size() - 1 ; i >= 0 ; i-- ) {
+        const PooledList &entry = mPool[i];
+
+        ///Formats come from getPixelFormatConstant(), so pointers are comparable
+        if ( ( entry.size != size ) || ( entry.numBufs != numBufs ) || ( entry.format != format ) ) {
+            continue;
+        }
+
+        CameraBuffer *buffers = entry.buffers;
+        mPoolBytes -= (size_t) size * numBufs;
+        mPool.removeAt(i);
+
+        ///Drop any per-use state left behind by the previous owner
+        for ( int j = 0 ; j < numBufs ; j++ ) {
+            CameraBuffer buffer;
+            memset(&buffer, 0, sizeof(buffer));
+            buffer.type = buffers[j].type;
+            buffer.opaque = buffers[j].opaque;
+            buffer.mapped = buffers[j].mapped;
+            buffer.ion_handle = buffers[j].ion_handle;
+            buffer.ion_fd = buffers[j].ion_fd;
+            buffer.fd = buffers[j].fd;
+            buffer.size = buffers[j].size;
+            buffer.format = buffers[j].format;
+            buffers[j] = buffer;
+        }
+
+        CAMHAL_LOGDB("Reusing %d pooled ion buffers of size=%d", numBufs, size);
+
+        return buffers;
+    }
+
+    return NULL;
+}
+
+size_t MemoryManager::trimPool()
+{
+    android::AutoMutex lock(mPoolLock);
+
+    const size_t released = mPoolBytes;
+
+    for ( size_t i = 0 ; i < mPool.size() ; i++ ) {
+        releaseBufferList(mPool[i].buffers);
+    }
+
+    mPool.clear();
+    mPoolBytes = 0;
+
+    return released;
 }
 
 status_t MemoryManager::setErrorHandler(ErrorNotifier *errorNotifier)
@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "NV12_resize.h"
 
 #ifdef LOG_TAG
@@ -21,7 +25,246 @@
 #endif
 #define LOG_TAG "NV12_resize"
 
-#define STRIDE 4096
+// Bilinear weights are 7 bit so that both taps of a filter fit in a byte
+#define FILTER_BITS 7
+#define FILTER_ONE (1 << FILTER_BITS)
+
+// Box filters are normalized with a 24 bit reciprocal, exact below this area
+#define BOX_MAX_AREA 255
+
+/* First source pixel and weight of the second one for an output row/column */
+typedef struct {
+    mmInt32 index;
+    mmInt32 weight;
+} ScaleTap;
+
+/* Two horizontally filtered source rows, reused across output rows */
+typedef struct {
+    mmUchar *buf[2];
+    mmInt32 row[2];
+} RowCache;
+
+static void buildTaps(ScaleTap *taps, mmInt32 srcSize, mmInt32 dstSize) {
+    // Pixel centers are aligned, positions are 16.16 fixed point
+    const int64_t step = ((int64_t) srcSize << 16) / dstSize;
+    int64_t pos = step / 2 - 0x8000;
+
+    for ( mmInt32 i = 0; i < dstSize; i++, pos += step ) {
+        mmInt32 index = 0;
+        mmInt32 weight = 0;
+
+        if ( pos > 0 ) {
+            index = (mmInt32) (pos >> 16);
+            weight = (mmInt32) ((pos & 0xffff) >> (16 - FILTER_BITS));
+        }
+        if ( index >= srcSize - 1 ) {
+            index = srcSize - 2;
+            weight = FILTER_ONE;
+        }
+
+        taps[i].index = index;
+        taps[i].weight = weight;
+    }
+}
+
+static void filterRow(mmUchar *dst, const mmUchar *src, const ScaleTap *taps,
+                      mmInt32 width, bool interleaved) {
+    if ( !interleaved ) {
+        for ( mmInt32 col = 0; col < width; col++ ) {
+            const mmUchar *s = src + taps[col].index;
+            const mmInt32 w = taps[col].weight;
+            dst[col] = (mmUchar) ((s[0] * (FILTER_ONE - w) + s[1] * w + FILTER_ONE / 2) >> FILTER_BITS);
+        }
+    } else {
+        for ( mmInt32 col = 0; col < width; col++ ) {
+            const mmUchar *s = src + taps[col].index * 2;
+            const mmInt32 w = taps[col].weight;
+            dst[col * 2] = (mmUchar) ((s[0] * (FILTER_ONE - w) + s[2] * w + FILTER_ONE / 2) >> FILTER_BITS);
+            dst[col * 2 + 1] = (mmUchar) ((s[1] * (FILTER_ONE - w) + s[3] * w + FILTER_ONE / 2) >> FILTER_BITS);
+        }
+    }
+}
+
+static void blendRows(mmUchar *dst, const mmUchar *row0, const mmUchar *row1,
+                      mmInt32 weight, mmInt32 n) {
+    if ( weight == 0 ) {
+        memcpy(dst, row0, n);
+        return;
+    } else if ( weight == FILTER_ONE ) {
+        memcpy(dst, row1, n);
+        return;
+    }
+
+    mmInt32 done = 0;
+
+#ifdef ARCH_ARM_HAVE_NEON
+    done = n & ~15;
+    if ( done > 0 ) {
+        mmInt32 count = done;
+        mmUchar *d = dst;
+        const mmUchar *r0 = row0;
+        const mmUchar *r1 = row1;
+        asm volatile (
+        "   vdup.8  d28, %[w0]                                          \n\t"
+        "   vdup.8  d29, %[w1]                                          \n\t"
+        "0: @ 16 pixel blend                                            \n\t"
+        "   pld [%[r0], #128]                                           \n\t"
+        "   pld [%[r1], #128]                                           \n\t"
+        "   vld1.8  {q0}, [%[r0]]!                                      \n\t"
+        "   vld1.8  {q1}, [%[r1]]!                                      \n\t"
+        "   vmull.u8  q2, d0, d28                                       \n\t"
+        "   vmull.u8  q3, d1, d28                                       \n\t"
+        "   vmlal.u8  q2, d2, d29                                       \n\t"
+        "   vmlal.u8  q3, d3, d29                                       \n\t"
+        "   vrshrn.u16  d0, q2, #7                                      \n\t"
+        "   vrshrn.u16  d1, q3, #7                                      \n\t"
+        "   vst1.8  {q0}, [%[d]]!                                       \n\t"
+        "   subs %[count], %[count], #16                                \n\t"
+        "   bgt 0b                                                      \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [d] "+r" (d), [r0] "+r" (r0), [r1] "+r" (r1), [count] "+r" (count)
+        : [w0] "r" (FILTER_ONE - weight), [w1] "r" (weight)
+        : "cc", "memory", "q0", "q1", "q2", "q3", "d28", "d29"
+        );
+    }
+#endif
+
+    for ( mmInt32 i = done; i < n; i++ ) {
+        dst[i] = (mmUchar) ((row0[i] * (FILTER_ONE - weight) + row1[i] * weight + FILTER_ONE / 2) >> FILTER_BITS);
+    }
+}
+
+static const mmUchar *cachedRow(RowCache *cache, mmInt32 row, mmInt32 keep,
+                                const mmUchar *src, mmInt32 srcStride,
+                                const ScaleTap *xTaps, mmInt32 width, bool interleaved) {
+    if ( cache->row[0] == row ) {
+        return cache->buf[0];
+    } else if ( cache->row[1] == row ) {
+        return cache->buf[1];
+    }
+
+    const int slot = (cache->row[0] == keep) ? 1 : 0;
+    filterRow(cache->buf[slot], src + row * srcStride, xTaps, width, interleaved);
+    cache->row[slot] = row;
+
+    return cache->buf[slot];
+}
+
+/* Separable bilinear: taps are in pixels, or in UV pairs for an interleaved plane */
+static void scalePlaneBilinear(const mmUchar *src, mmInt32 srcStride, mmInt32 srcWidth,
+                               mmUchar *dst, mmInt32 dstStride, mmInt32 dstWidth, mmInt32 dstHeight,
+                               const ScaleTap *xTaps, const ScaleTap *yTaps,
+                               RowCache *cache, bool interleaved) {
+    const mmInt32 bytes = interleaved ? dstWidth * 2 : dstWidth;
+    const bool copyX = (srcWidth == dstWidth);
+
+    cache->row[0] = cache->row[1] = -1;
+
+    for ( mmInt32 row = 0; row < dstHeight; row++ ) {
+        const mmInt32 y = yTaps[row].index;
+        const mmInt32 w = yTaps[row].weight;
+        const mmUchar *row0 = NULL;
+        const mmUchar *row1 = NULL;
+
+        if ( copyX ) {
+            row0 = src + y * srcStride;
+            row1 = row0 + srcStride;
+        } else {
+            if ( w != FILTER_ONE ) {
+                row0 = cachedRow(cache, y, y + 1, src, srcStride, xTaps, dstWidth, interleaved);
+            }
+            if ( w != 0 ) {
+                row1 = cachedRow(cache, y + 1, y, src, srcStride, xTaps, dstWidth, interleaved);
+            }
+        }
+
+        blendRows(dst + row * dstStride, row0, row1, w, bytes);
+    }
+}
+
+static void accumulateRow(mmUint16 *sum, const mmUchar *src, mmInt32 n) {
+    mmInt32 done = 0;
+
+#ifdef ARCH_ARM_HAVE_NEON
+    done = n & ~15;
+    if ( done > 0 ) {
+        mmInt32 count = done;
+        mmUint16 *s = sum;
+        const mmUchar *in = src;
+        asm volatile (
+        "0: @ 16 pixel accumulate                                       \n\t"
+        "   pld [%[in], #128]                                           \n\t"
+        "   vld1.8  {q0}, [%[in]]!                                      \n\t"
+        "   vld1.16  {q1, q2}, [%[s]]                                   \n\t"
+        "   vaddw.u8  q1, q1, d0                                        \n\t"
+        "   vaddw.u8  q2, q2, d1                                        \n\t"
+        "   vst1.16  {q1, q2}, [%[s]]!                                  \n\t"
+        "   subs %[count], %[count], #16                                \n\t"
+        "   bgt 0b                                                      \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [s] "+r" (s), [in] "+r" (in), [count] "+r" (count)
+        :
+        : "cc", "memory", "q0", "q1", "q2"
+        );
+    }
+#endif
+
+    for ( mmInt32 i = done; i < n; i++ ) {
+        sum[i] += src[i];
+    }
+}
+
+/* Averages fx * fy blocks, channels is 1 for luma or 2 for the interleaved UV plane */
+static void scalePlaneBox(const mmUchar *src, mmInt32 srcStride,
+                          mmUchar *dst, mmInt32 dstStride, mmInt32 dstWidth, mmInt32 dstHeight,
+                          mmInt32 fx, mmInt32 fy, mmInt32 channels, mmUint16 *colSum) {
+    const mmInt32 srcBytes = dstWidth * fx * channels;
+    const mmUint32 area = fx * fy;
+    const mmUint32 recip = ((1 << 24) + area - 1) / area;
+
+    for ( mmInt32 row = 0; row < dstHeight; row++ ) {
+        const mmUchar *in = src + row * fy * srcStride;
+        mmUchar *out = dst + row * dstStride;
+
+        memset(colSum, 0, srcBytes * sizeof(mmUint16));
+        for ( mmInt32 i = 0; i < fy; i++ ) {
+            accumulateRow(colSum, in + i * srcStride, srcBytes);
+        }
+
+        const mmUint16 *s = colSum;
+        if ( channels == 1 ) {
+            for ( mmInt32 col = 0; col < dstWidth; col++ ) {
+                mmUint32 total = area / 2;
+                for ( mmInt32 i = 0; i < fx; i++ ) {
+                    total += *s++;
+                }
+                out[col] = (mmUchar) ((total * recip) >> 24);
+            }
+        } else {
+            for ( mmInt32 col = 0; col < dstWidth; col++ ) {
+                mmUint32 totalU = area / 2;
+                mmUint32 totalV = area / 2;
+                for ( mmInt32 i = 0; i < fx; i++ ) {
+                    totalU += *s++;
+                    totalV += *s++;
+                }
+                out[col * 2] = (mmUchar) ((totalU * recip) >> 24);
+                out[col * 2 + 1] = (mmUchar) ((totalV * recip) >> 24);
+            }
+        }
+    }
+}
+
+static void copyPlane(const mmUchar *src, mmInt32 srcStride,
+                      mmUchar *dst, mmInt32 dstStride, mmInt32 bytes, mmInt32 rows) {
+    for ( mmInt32 row = 0; row < rows; row++ ) {
+        memcpy(dst + row * dstStride, src + row * srcStride, bytes);
+    }
+}
 
 /*==========================================================================
 * Function Name  : VT_resizeFrame_Video_opt2_lp
@@ -34,8 +277,8 @@
 *
 * Value Returned : mmBool               -> FALSE on error TRUE on success
 * NOTE:
-*            Not tested for crop funtionallity.
-*            faster version.
+*            Integer downscales use a box filter, everything else is
+*            bilinear with per row/column taps computed once per call.
 ============================================================================*/
 mmBool
 VT_resizeFrame_Video_opt2_lp(
@@ -46,40 +289,30 @@ VT_resizeFrame_Video_opt2_lp(
         ) {
     LOG_FUNCTION_NAME;
 
-    mmUint16 row,col;
-    mmUint32 resizeFactorX;
-    mmUint32 resizeFactorY;
-
-    mmUint16 x, y;
-
-    mmUchar* ptr8;
-    mmUchar *ptr8Cb, *ptr8Cr;
-
-    mmUint16 xf, yf;
-    mmUchar* inImgPtrY;
-    mmUchar* inImgPtrU;
-    mmUchar* inImgPtrV;
-    mmUint32 cox, coy, codx, cody;
-    mmUint16 idx,idy, idxC;
-
-    if ( i_img_ptr->uWidth == o_img_ptr->uWidth ) {
-        if ( i_img_ptr->uHeight == o_img_ptr->uHeight ) {
-            CAMHAL_LOGV("************************f(i_img_ptr->uHeight == o_img_ptr->uHeight) are same *********************\n");
-            CAMHAL_LOGV("************************(i_img_ptr->width == %d" , i_img_ptr->uWidth );
-            CAMHAL_LOGV("************************(i_img_ptr->uHeight == %d" , i_img_ptr->uHeight );
-            CAMHAL_LOGV("************************(o_img_ptr->width == %d" ,o_img_ptr->uWidth );
-            CAMHAL_LOGV("************************(o_img_ptr->uHeight == %d" , o_img_ptr->uHeight );
-        }
-    }
+    mmInt32 cox, coy, codx, cody;
+    mmInt32 idx, idy;
 
-    if ( !i_img_ptr || !i_img_ptr->imgPtr || !o_img_ptr || !o_img_ptr->imgPtr ) {
+    if ( !i_img_ptr || !i_img_ptr->imgPtr || !i_img_ptr->clrPtr ||
+            !o_img_ptr || !o_img_ptr->imgPtr || !o_img_ptr->clrPtr ) {
         CAMHAL_LOGE("Image Point NULL");
         return false;
     }
 
-    inImgPtrY = (mmUchar *) i_img_ptr->imgPtr + i_img_ptr->uOffset;
-    inImgPtrU = (mmUchar *) i_img_ptr->clrPtr + i_img_ptr->uOffset/2;
-    inImgPtrV = (mmUchar*)inImgPtrU + 1;
+    if( i_img_ptr->eFormat != IC_FORMAT_YCbCr420_lp ||
+            o_img_ptr->eFormat != IC_FORMAT_YCbCr420_lp ) {
+        CAMHAL_LOGE("eFormat not supported");
+        return false;
+    }
+
+    idx = i_img_ptr->uWidth;
+    idy = i_img_ptr->uHeight;
+
+    /* make sure valid input size */
+    if ( idx < 1 || idy < 1 || i_img_ptr->uStride < idx || o_img_ptr->uStride < o_img_ptr->uWidth ) {
+        CAMHAL_LOGE("Invalid size idx = %d idy = %d in stride = %d out stride = %d",
+                    idx, idy, i_img_ptr->uStride, o_img_ptr->uStride);
+        return false;
+    }
 
     if ( !cropout ) {
         cox = 0;
@@ -87,203 +320,94 @@ VT_resizeFrame_Video_opt2_lp(
         codx = o_img_ptr->uWidth;
         cody = o_img_ptr->uHeight;
     } else {
-        cox = cropout->x;
-        coy = cropout->y;
+        // Chroma is subsampled, so the rectangle has to start on an even pixel
+        cox = cropout->x & ~1;
+        coy = cropout->y & ~1;
         codx = cropout->uWidth;
         cody = cropout->uHeight;
     }
-    idx = i_img_ptr->uWidth;
-    idy = i_img_ptr->uHeight;
-
-    /* make sure valid input size */
-    if ( idx < 1 || idy < 1 || i_img_ptr->uStride < 1 ) {
-        CAMHAL_LOGE("idx or idy less then 1 idx = %d idy = %d stride = %d", idx, idy, i_img_ptr->uStride);
-        return false;
-    }
 
-    resizeFactorX = ((idx-1)<<9) / codx;
-    resizeFactorY = ((idy-1)<<9) / cody;
-
-    if( i_img_ptr->eFormat != IC_FORMAT_YCbCr420_lp ||
-            o_img_ptr->eFormat != IC_FORMAT_YCbCr420_lp ) {
-        CAMHAL_LOGE("eFormat not supported");
+    if ( codx < 1 || cody < 1 || cox + codx > o_img_ptr->uWidth || coy + cody > o_img_ptr->uHeight ) {
+        CAMHAL_LOGE("Output rectangle %dx%d@(%d,%d) outside of %dx%d image",
+                    codx, cody, cox, coy, o_img_ptr->uWidth, o_img_ptr->uHeight);
         return false;
     }
 
-    ptr8 = (mmUchar*)o_img_ptr->imgPtr + cox + coy*o_img_ptr->uWidth;
-
-    ////////////////////////////for Y//////////////////////////
-    for ( row = 0; row < cody; row++ ) {
-        mmUchar *pu8Yrow1 = NULL;
-        mmUchar *pu8Yrow2 = NULL;
-        y  = (mmUint16) ((mmUint32) (row*resizeFactorY) >> 9);
-        yf = (mmUchar)  ((mmUint32)((row*resizeFactorY) >> 6) & 0x7);
-        pu8Yrow1 = inImgPtrY + (y) * i_img_ptr->uStride;
-        pu8Yrow2 = pu8Yrow1 + i_img_ptr->uStride;
-
-        for ( col = 0; col < codx; col++ ) {
-            mmUchar in11, in12, in21, in22;
-            mmUchar *pu8ptr1 = NULL;
-            mmUchar *pu8ptr2 = NULL;
-            mmUchar w;
-            mmUint16 accum_1;
-            //mmUint32 accum_W;
-
-            x  = (mmUint16) ((mmUint32)  (col*resizeFactorX) >> 9);
-            xf = (mmUchar)  ((mmUint32) ((col*resizeFactorX) >> 6) & 0x7);
-
-            //accum_W = 0;
-            accum_1 =  0;
-
-            pu8ptr1 = pu8Yrow1 + (x);
-            pu8ptr2 = pu8Yrow2 + (x);
-
-            /* A pixel */
-            //in = *(inImgPtrY + (y)*idx + (x));
-            in11 = *(pu8ptr1);
-
-            w = bWeights[xf][yf][0];
-            accum_1 = (w * in11);
-            //accum_W += (w);
-
-            /* B pixel */
-            //in = *(inImgPtrY + (y)*idx + (x+1));
-            in12 = *(pu8ptr1+1);
-            w = bWeights[xf][yf][1];
-            accum_1 += (w * in12);
-            //accum_W += (w);
-
-            /* C pixel */
-            //in = *(inImgPtrY + (y+1)*idx + (x));
-            in21 = *(pu8ptr2);
-            w = bWeights[xf][yf][3];
-            accum_1 += (w * in21);
-            //accum_W += (w);
-
-            /* D pixel */
-            //in = *(inImgPtrY + (y+1)*idx + (x+1));
-            in22 = *(pu8ptr2+1);
-            w = bWeights[xf][yf][2];
-            accum_1 += (w * in22);
-            //accum_W += (w);
-
-            /* divide by sum of the weights */
-            //accum_1 /= (accum_W);
-            //accum_1 = (accum_1/64);
-            accum_1 = (accum_1>>6);
-            *ptr8 = (mmUchar)accum_1 ;
-
-            ptr8++;
+    const mmInt32 inStride = i_img_ptr->uStride;
+    const mmInt32 outStride = o_img_ptr->uStride;
+    const mmInt32 ix = i_img_ptr->uOffset % inStride;
+    const mmInt32 iy = i_img_ptr->uOffset / inStride;
+    const mmInt32 ox = o_img_ptr->uOffset % outStride + cox;
+    const mmInt32 oy = o_img_ptr->uOffset / outStride + coy;
+
+    const mmUchar *inY = (mmUchar *) i_img_ptr->imgPtr + iy * inStride + ix;
+    const mmUchar *inUV = (mmUchar *) i_img_ptr->clrPtr + (iy >> 1) * inStride + (ix & ~1);
+    mmUchar *outY = (mmUchar *) o_img_ptr->imgPtr + oy * outStride + ox;
+    mmUchar *outUV = (mmUchar *) o_img_ptr->clrPtr + (oy >> 1) * outStride + (ox & ~1);
+
+    const mmInt32 fx = idx / codx;
+    const mmInt32 fy = idy / cody;
+
+    if ( idx == codx && idy == cody ) {
+        CAMHAL_LOGV("Copy %dx%d", idx, idy);
+        copyPlane(inY, inStride, outY, outStride, codx, cody);
+        copyPlane(inUV, inStride, outUV, outStride, codx & ~1, cody >> 1);
+    } else if ( fx * codx == idx && fy * cody == idy && fx * fy <= BOX_MAX_AREA &&
+            !(codx & 1) && !(cody & 1) ) {
+        CAMHAL_LOGV("Box %dx%d -> %dx%d", idx, idy, codx, cody);
+
+        mmUint16 *colSum = (mmUint16 *) malloc(idx * sizeof(mmUint16));
+        if ( !colSum ) {
+            CAMHAL_LOGE("Out of memory");
+            return false;
         }
-        ptr8 = ptr8 + (o_img_ptr->uStride - codx);
-    }
-    ////////////////////////////for Y//////////////////////////
-
-    ///////////////////////////////for Cb-Cr//////////////////////
 
-    ptr8Cb = (mmUchar*)o_img_ptr->clrPtr + cox + coy*o_img_ptr->uWidth;
+        scalePlaneBox(inY, inStride, outY, outStride, codx, cody, fx, fy, 1, colSum);
+        scalePlaneBox(inUV, inStride, outUV, outStride, codx >> 1, cody >> 1, fx, fy, 2, colSum);
 
-    ptr8Cr = (mmUchar*)(ptr8Cb+1);
-
-    idxC = (idx>>1);
-    for ( row = 0; row < (((cody)>>1)); row++ ) {
-        mmUchar *pu8Cbr1 = NULL;
-        mmUchar *pu8Cbr2 = NULL;
-        mmUchar *pu8Crr1 = NULL;
-        mmUchar *pu8Crr2 = NULL;
-
-        y  = (mmUint16) ((mmUint32) (row*resizeFactorY) >> 9);
-        yf = (mmUchar)  ((mmUint32)((row*resizeFactorY) >> 6) & 0x7);
-
-        pu8Cbr1 = inImgPtrU + (y) * i_img_ptr->uStride;
-        pu8Cbr2 = pu8Cbr1 + i_img_ptr->uStride;
-        pu8Crr1 = inImgPtrV + (y) * i_img_ptr->uStride;
-        pu8Crr2 = pu8Crr1 + i_img_ptr->uStride;
-
-        for ( col = 0; col < (((codx)>>1)); col++ ) {
-            mmUchar in11, in12, in21, in22;
-            mmUchar *pu8Cbc1 = NULL;
-            mmUchar *pu8Cbc2 = NULL;
-            mmUchar *pu8Crc1 = NULL;
-            mmUchar *pu8Crc2 = NULL;
-
-            mmUchar w;
-            mmUint16 accum_1Cb, accum_1Cr;
-            //mmUint32 accum_WCb, accum_WCr;
-
-            x  = (mmUint16) ((mmUint32)  (col*resizeFactorX) >> 9);
-            xf = (mmUchar)  ((mmUint32) ((col*resizeFactorX) >> 6) & 0x7);
-
-            //accum_WCb = accum_WCr =  0;
-            accum_1Cb = accum_1Cr =  0;
-
-            pu8Cbc1 = pu8Cbr1 + (x*2);
-            pu8Cbc2 = pu8Cbr2 + (x*2);
-            pu8Crc1 = pu8Crr1 + (x*2);
-            pu8Crc2 = pu8Crr2 + (x*2);
-
-            /* A pixel */
-            w = bWeights[xf][yf][0];
-
-            in11 = *(pu8Cbc1);
-            accum_1Cb = (w * in11);
-            //    accum_WCb += (w);
-
-            in11 = *(pu8Crc1);
-            accum_1Cr = (w * in11);
-            //accum_WCr += (w);
-
-            /* B pixel */
-            w = bWeights[xf][yf][1];
-
-            in12 = *(pu8Cbc1+2);
-            accum_1Cb += (w * in12);
-            //accum_WCb += (w);
-
-            in12 = *(pu8Crc1+2);
-            accum_1Cr += (w * in12);
-            //accum_WCr += (w);
-
-            /* C pixel */
-            w = bWeights[xf][yf][3];
-
-            in21 = *(pu8Cbc2);
-            accum_1Cb += (w * in21);
-            //accum_WCb += (w);
-
-            in21 = *(pu8Crc2);
-            accum_1Cr += (w * in21);
-            //accum_WCr += (w);
-
-            /* D pixel */
-            w = bWeights[xf][yf][2];
-
-            in22 = *(pu8Cbc2+2);
-            accum_1Cb += (w * in22);
-            //accum_WCb += (w);
-
-            in22 = *(pu8Crc2+2);
-            accum_1Cr += (w * in22);
-            //accum_WCr += (w);
+        free(colSum);
+    } else {
+        // Chroma needs two taps in both directions as well
+        if ( idx < 4 || idy < 4 ) {
+            CAMHAL_LOGE("Input %dx%d too small for bilinear scaling", idx, idy);
+            return false;
+        }
 
-            /* divide by sum of the weights */
-            //accum_1Cb /= (accum_WCb);
-            accum_1Cb = (accum_1Cb>>6);
-            *ptr8Cb = (mmUchar)accum_1Cb ;
+        CAMHAL_LOGV("Bilinear %dx%d -> %dx%d", idx, idy, codx, cody);
 
-            accum_1Cr = (accum_1Cr >> 6);
-            *ptr8Cr = (mmUchar)accum_1Cr ;
+        const mmInt32 cdx = codx >> 1;
+        const mmInt32 cdy = cody >> 1;
+        const mmInt32 tapCount = codx + cody + cdx + cdy;
+        const mmInt32 rowBytes = (codx + 15) & ~15;
 
-            ptr8Cb++;
-            ptr8Cr++;
+        mmUchar *scratch = (mmUchar *) malloc(tapCount * sizeof(ScaleTap) + 2 * rowBytes);
+        if ( !scratch ) {
+            CAMHAL_LOGE("Out of memory");
+            return false;
+        }
 
-            ptr8Cb++;
-            ptr8Cr++;
+        ScaleTap *xTaps = (ScaleTap *) scratch;
+        ScaleTap *yTaps = xTaps + codx;
+        ScaleTap *cxTaps = yTaps + cody;
+        ScaleTap *cyTaps = cxTaps + cdx;
+        RowCache cache;
+        cache.buf[0] = scratch + tapCount * sizeof(ScaleTap);
+        cache.buf[1] = cache.buf[0] + rowBytes;
+
+        buildTaps(xTaps, idx, codx);
+        buildTaps(yTaps, idy, cody);
+        buildTaps(cxTaps, idx >> 1, cdx);
+        buildTaps(cyTaps, idy >> 1, cdy);
+
+        scalePlaneBilinear(inY, inStride, idx, outY, outStride, codx, cody,
+                           xTaps, yTaps, &cache, false);
+        if ( cdx > 0 && cdy > 0 ) {
+            scalePlaneBilinear(inUV, inStride, idx >> 1, outUV, outStride, cdx, cdy,
+                               cxTaps, cyTaps, &cache, true);
         }
-        ptr8Cb = ptr8Cb + (o_img_ptr->uStride-codx);
-        ptr8Cr = ptr8Cr + (o_img_ptr->uStride-codx);
+
+        free(scratch);
     }
-    ///////////////////For Cb- Cr////////////////////////////////////////
 
     CAMHAL_LOGV("success");
     return true;
@@ -359,7 +359,7 @@ status_t OMXCameraAdapter::setParameters3A(const android::CameraParameters &para
     str = params.get(android::CameraParameters::KEY_METERING_AREAS);
     if ( (str != NULL) ) {
         size_t MAX_METERING_AREAS;
-        android::Vector<android::sp<CameraArea> > tempAreas;
+        CameraAreas tempAreas;
 
         MAX_METERING_AREAS = atoi(params.get(android::CameraParameters::KEY_MAX_NUM_METERING_AREAS));
 
@@ -810,7 +810,7 @@ status_t OMXCameraAdapter::setFocusMode(Gen3A_settings& Gen3A)
         ////FIXME: Check if the extended focus control is needed? this overrides caf
         //focusControl.eFocusControl = ( OMX_IMAGE_FOCUSCONTROLTYPE ) OMX_IMAGE_FocusControlExtended;
         }
-    else if ( (!mFocusAreas.isEmpty()) && (!mFocusAreas.itemAt(0)->isZeroArea()) )
+    else if ( (!mFocusAreas.isEmpty()) && (!mFocusAreas[0].isZeroArea()) )
         {
 
         //Disable face priority first
@@ -939,6 +939,9 @@ status_t OMXCameraAdapter::setScene(Gen3A_settings& Gen3A)
                             ( OMX_INDEXTYPE ) OMX_TI_IndexConfigSceneMode,
                             &scene);
 
+    // Scene presets override most of the other 3A settings on the component
+    mApplied3AValid = 0;
+
     if (OMX_ErrorNone != eError) {
         CAMHAL_LOGEB("Error while configuring scene mode 0x%x", eError);
     } else {
@@ -1617,6 +1620,9 @@ status_t OMXCameraAdapter::set3ALock(OMX_BOOL toggleExp, OMX_BOOL toggleWb, OMX_
     mParameters3A.FocusLock = toggleFocus;
     mParameters3A.WhiteBalanceLock = toggleWb;
 
+    // Locks are toggled behind apply3Asettings() back here
+    mApplied3AValid &= ~(SetExpLock | SetWBLock);
+
     eError = OMX_GetConfig( mCameraAdapterParameters.mHandleComp,
                             (OMX_INDEXTYPE)OMX_IndexConfigImageExposureLock,
                             &lock);
@@ -1686,15 +1692,25 @@ status_t OMXCameraAdapter::set3ALock(OMX_BOOL toggleExp, OMX_BOOL toggleWb, OMX_
     return Utils::ErrorUtils::omxToAndroidError(eError);
 }
 
+CameraBuffer *OMXCameraAdapter::getAlgoAreasBuffer()
+{
+  // Called with mAlgoAreasLock held
+  if ( NULL == mAlgoAreasBuffer )
+      {
+      mAlgoAreasBuffer = mMemMgr.allocateBufferList(0, 0, NULL, ALGO_AREAS_BUFFER_SIZE, 1);
+      }
+
+  return mAlgoAreasBuffer;
+}
+
 status_t OMXCameraAdapter::setMeteringAreas(Gen3A_settings& Gen3A)
 {
   status_t ret = NO_ERROR;
   OMX_ERRORTYPE eError = OMX_ErrorNone;
 
   CameraBuffer *bufferlist;
-  OMX_ALGOAREASTYPE *meteringAreas;
+  OMX_ALGOAREASTYPE *meteringAreas = NULL;
   OMX_TI_CONFIG_SHAREDBUFFER sharedBuffer;
-  int areasSize = 0;
 
   LOG_FUNCTION_NAME
 
@@ -1706,9 +1722,13 @@ status_t OMXCameraAdapter::setMeteringAreas(Gen3A_settings& Gen3A)
       return NO_INIT;
     }
 
-  areasSize = ((sizeof(OMX_ALGOAREASTYPE)+4095)/4096)*4096;
-  bufferlist = mMemMgr.allocateBufferList(0, 0, NULL, areasSize, 1);
-  meteringAreas = (OMX_ALGOAREASTYPE *)bufferlist[0].opaque;
+  android::AutoMutex areasLock(mAlgoAreasLock);
+
+  bufferlist = getAlgoAreasBuffer();
+  if ( NULL != bufferlist )
+      {
+      meteringAreas = (OMX_ALGOAREASTYPE *)bufferlist[0].opaque;
+      }
 
   OMXCameraPortParameters * mPreviewData = NULL;
   mPreviewData = &mCameraAdapterParameters.mCameraPortParams[mCameraAdapterParameters.mPrevPortIndex];
@@ -1738,7 +1758,7 @@ status_t OMXCameraAdapter::setMeteringAreas(Gen3A_settings& Gen3A)
         }
 
       // transform the coordinates to 3A-type coordinates
-      mMeteringAreas.itemAt(n)->transfrom((size_t)mPreviewData->mWidth/widthDivisor,
+      mMeteringAreas[n].transfrom((size_t)mPreviewData->mWidth/widthDivisor,
                                       (size_t)mPreviewData->mHeight/heightDivisor,
                                       (size_t&)meteringAreas->tAlgoAreas[n].nTop,
                                       (size_t&)meteringAreas->tAlgoAreas[n].nLeft,
@@ -1754,7 +1774,7 @@ status_t OMXCameraAdapter::setMeteringAreas(Gen3A_settings& Gen3A)
       meteringAreas->tAlgoAreas[n].nHeight =
               ( meteringAreas->tAlgoAreas[n].nHeight * METERING_AREAS_RANGE ) / mPreviewData->mHeight;
 
-      meteringAreas->tAlgoAreas[n].nPriority = mMeteringAreas.itemAt(n)->getWeight();
+      meteringAreas->tAlgoAreas[n].nPriority = mMeteringAreas[n].getWeight();
 
       CAMHAL_LOGDB("Metering area %d : top = %d left = %d width = %d height = %d prio = %d",
               n, (int)meteringAreas->tAlgoAreas[n].nTop, (int)meteringAreas->tAlgoAreas[n].nLeft,
@@ -1766,14 +1786,13 @@ status_t OMXCameraAdapter::setMeteringAreas(Gen3A_settings& Gen3A)
   OMX_INIT_STRUCT_PTR (&sharedBuffer, OMX_TI_CONFIG_SHAREDBUFFER);
 
   sharedBuffer.nPortIndex = OMX_ALL;
-  sharedBuffer.nSharedBuffSize = areasSize;
+  sharedBuffer.nSharedBuffSize = ALGO_AREAS_BUFFER_SIZE;
   sharedBuffer.pSharedBuff = (OMX_U8 *)camera_buffer_get_omx_ptr (&bufferlist[0]);
 
   if ( NULL == sharedBuffer.pSharedBuff )
       {
       CAMHAL_LOGEA("No resources to allocate OMX shared buffer");
-      ret = -ENOMEM;
-      goto EXIT;
+      return -ENOMEM;
       }
 
       eError =  OMX_SetConfig(mCameraAdapterParameters.mHandleComp,
@@ -1789,12 +1808,6 @@ status_t OMXCameraAdapter::setMeteringAreas(Gen3A_settings& Gen3A)
       CAMHAL_LOGDA("Metering Areas SetConfig successfull.");
       }
 
- EXIT:
-  if (NULL != bufferlist)
-      {
-      mMemMgr.freeBufferList(bufferlist);
-      }
-
   return ret;
 }
 
@@ -1964,6 +1977,117 @@ EXIT:
 }
 #endif
 
+// Settings below are compared against the last value applied to the
+// component. The others have side effects beyond a single OMX config.
+static bool is3ASettingEqual(unsigned int setting, const Gen3A_settings &applied, const Gen3A_settings &requested)
+{
+    switch ( setting ) {
+        case SetEVCompensation:
+            return applied.EVCompensation == requested.EVCompensation;
+        case SetWhiteBallance:
+            return applied.WhiteBallance == requested.WhiteBallance;
+        case SetFlicker:
+            return applied.Flicker == requested.Flicker;
+        case SetBrightness:
+            return applied.Brightness == requested.Brightness;
+        case SetContrast:
+            return applied.Contrast == requested.Contrast;
+        case SetSharpness:
+            return applied.Sharpness == requested.Sharpness;
+        case SetSaturation:
+            return applied.Saturation == requested.Saturation;
+        case SetISO:
+            return applied.ISO == requested.ISO;
+        case SetEffect:
+            return applied.Effect == requested.Effect;
+        case SetExpLock:
+            return applied.ExposureLock == requested.ExposureLock;
+        case SetWBLock:
+            return applied.WhiteBalanceLock == requested.WhiteBalanceLock;
+        case SetAlgoExternalGamma:
+            return applied.AlgoExternalGamma == requested.AlgoExternalGamma;
+        case SetAlgoNSF1:
+            return applied.AlgoNSF1 == requested.AlgoNSF1;
+        case SetAlgoNSF2:
+            return applied.AlgoNSF2 == requested.AlgoNSF2;
+        case SetAlgoSharpening:
+            return applied.AlgoSharpening == requested.AlgoSharpening;
+        case SetAlgoThreeLinColorMap:
+            return applied.AlgoThreeLinColorMap == requested.AlgoThreeLinColorMap;
+        case SetAlgoGIC:
+            return applied.AlgoGIC == requested.AlgoGIC;
+        case SetGammaTable:
+            return 0 == memcmp(&applied.mGammaTable, &requested.mGammaTable, sizeof(applied.mGammaTable));
+        default:
+            return false;
+    }
+}
+
+// Returns false for settings that are not tracked by is3ASettingEqual()
+static bool copy3ASetting(unsigned int setting, Gen3A_settings &applied, const Gen3A_settings &requested)
+{
+    switch ( setting ) {
+        case SetEVCompensation:
+            applied.EVCompensation = requested.EVCompensation;
+            break;
+        case SetWhiteBallance:
+            applied.WhiteBallance = requested.WhiteBallance;
+            break;
+        case SetFlicker:
+            applied.Flicker = requested.Flicker;
+            break;
+        case SetBrightness:
+            applied.Brightness = requested.Brightness;
+            break;
+        case SetContrast:
+            applied.Contrast = requested.Contrast;
+            break;
+        case SetSharpness:
+            applied.Sharpness = requested.Sharpness;
+            break;
+        case SetSaturation:
+            applied.Saturation = requested.Saturation;
+            break;
+        case SetISO:
+            applied.ISO = requested.ISO;
+            break;
+        case SetEffect:
+            applied.Effect = requested.Effect;
+            break;
+        case SetExpLock:
+            applied.ExposureLock = requested.ExposureLock;
+            break;
+        case SetWBLock:
+            applied.WhiteBalanceLock = requested.WhiteBalanceLock;
+            break;
+        case SetAlgoExternalGamma:
+            applied.AlgoExternalGamma = requested.AlgoExternalGamma;
+            break;
+        case SetAlgoNSF1:
+            applied.AlgoNSF1 = requested.AlgoNSF1;
+            break;
+        case SetAlgoNSF2:
+            applied.AlgoNSF2 = requested.AlgoNSF2;
+            break;
+        case SetAlgoSharpening:
+            applied.AlgoSharpening = requested.AlgoSharpening;
+            break;
+        case SetAlgoThreeLinColorMap:
+            applied.AlgoThreeLinColorMap = requested.AlgoThreeLinColorMap;
+            break;
+        case SetAlgoGIC:
+            applied.AlgoGIC = requested.AlgoGIC;
+            break;
+        case SetGammaTable:
+            memcpy(&applied.mGammaTable, &requested.mGammaTable, sizeof(applied.mGammaTable));
+            break;
+        default:
+            return false;
+    }
+
+    return true;
+}
+
 status_t OMXCameraAdapter::apply3Asettings( Gen3A_settings& Gen3A )
 {
     status_t ret = NO_ERROR;
@@ -1998,103 +2122,124 @@ status_t OMXCameraAdapter::apply3Asettings( Gen3A_settings& Gen3A )
         if ( mPending3Asettings == 0 ) return NO_ERROR;
     }
 
+    // Drop whatever the component already has, the rest is issued back to
+    // back from here, which is normally the preview FillBufferDone.
+    unsigned int unchanged = mPending3Asettings & mApplied3AValid;
+    for( currSett = 1; currSett < E3aSettingMax; currSett <<= 1)
+        {
+        if( (currSett & unchanged) && !is3ASettingEqual(currSett, mApplied3A, Gen3A) )
+            {
+            unchanged &= ~currSett;
+            }
+        }
+
+    if ( unchanged )
+        {
+        mPending3Asettings &= ~unchanged;
+        m3AConfigsSaved += __builtin_popcount(unchanged);
+        CAMHAL_LOGDB("Skipped unchanged 3A settings 0x%x, %u config calls saved so far",
+                     unchanged, m3AConfigsSaved);
+        }
+
     for( currSett = 1; currSett < E3aSettingMax; currSett <<= 1)
         {
         if( currSett & mPending3Asettings )
             {
+            status_t settingRet = NO_ERROR;
+
             switch( currSett )
                 {
                 case SetEVCompensation:
                     {
-                    ret |= setEVCompensation(Gen3A);
+                    settingRet = setEVCompensation(Gen3A);
                     break;
                     }
 
                 case SetWhiteBallance:
                     {
-                    ret |= setWBMode(Gen3A);
+                    settingRet = setWBMode(Gen3A);
                     break;
                     }
 
                 case SetFlicker:
                     {
-                    ret |= setFlicker(Gen3A);
+                    settingRet = setFlicker(Gen3A);
                     break;
                     }
 
                 case SetBrightness:
                     {
-                    ret |= setBrightness(Gen3A);
+                    settingRet = setBrightness(Gen3A);
                     break;
                     }
 
                 case SetContrast:
                     {
-                    ret |= setContrast(Gen3A);
+                    settingRet = setContrast(Gen3A);
                     break;
                     }
 
                 case SetSharpness:
                     {
-                    ret |= setSharpness(Gen3A);
+                    settingRet = setSharpness(Gen3A);
                     break;
                     }
 
                 case SetSaturation:
                     {
-                    ret |= setSaturation(Gen3A);
+                    settingRet = setSaturation(Gen3A);
                     break;
                     }
 
                 case SetISO:
                     {
-                    ret |= setISO(Gen3A);
+                    settingRet = setISO(Gen3A);
                     break;
                     }
 
                 case SetEffect:
                     {
-                    ret |= setEffect(Gen3A);
+                    settingRet = setEffect(Gen3A);
                     break;
                     }
 
                 case SetFocus:
                     {
-                    ret |= setFocusMode(Gen3A);
+                    settingRet = setFocusMode(Gen3A);
                     break;
                     }
 
                 case SetExpMode:
                     {
-                    ret |= setExposureMode(Gen3A);
+                    settingRet = setExposureMode(Gen3A);
                     break;
                     }
 
                 case SetManualExposure: {
-                    ret |= setManualExposureVal(Gen3A);
+                    settingRet = setManualExposureVal(Gen3A);
                     break;
                 }
 
                 case SetFlash:
                     {
-                    ret |= setFlashMode(Gen3A);
+                    settingRet = setFlashMode(Gen3A);
                     break;
                     }
 
                 case SetExpLock:
                   {
-                    ret |= setExposureLock(Gen3A);
+                    settingRet = setExposureLock(Gen3A);
                     break;
                   }
 
                 case SetWBLock:
                   {
-                    ret |= setWhiteBalanceLock(Gen3A);
+                    settingRet = setWhiteBalanceLock(Gen3A);
                     break;
                   }
                 case SetMeteringAreas:
                   {
-                    ret |= setMeteringAreas(Gen3A);
+                    settingRet = setMeteringAreas(Gen3A);
                   }
                   break;
 
@@ -2102,43 +2247,43 @@ status_t OMXCameraAdapter::apply3Asettings( Gen3A_settings& Gen3A )
                 //TI extensions for enable/disable algos
                 case SetAlgoExternalGamma:
                   {
-                    ret |= setAlgoExternalGamma(Gen3A);
+                    settingRet = setAlgoExternalGamma(Gen3A);
                   }
                   break;
 
                 case SetAlgoNSF1:
                   {
-                    ret |= setAlgoNSF1(Gen3A);
+                    settingRet = setAlgoNSF1(Gen3A);
                   }
                   break;
 
                 case SetAlgoNSF2:
                   {
-                    ret |= setAlgoNSF2(Gen3A);
+                    settingRet = setAlgoNSF2(Gen3A);
                   }
                   break;
 
                 case SetAlgoSharpening:
                   {
-                    ret |= setAlgoSharpening(Gen3A);
+                    settingRet = setAlgoSharpening(Gen3A);
                   }
                   break;
 
                 case SetAlgoThreeLinColorMap:
                   {
-                    ret |= setAlgoThreeLinColorMap(Gen3A);
+                    settingRet = setAlgoThreeLinColorMap(Gen3A);
                   }
                   break;
 
                 case SetAlgoGIC:
                   {
-                    ret |= setAlgoGIC(Gen3A);
+                    settingRet = setAlgoGIC(Gen3A);
                   }
                   break;
 
                 case SetGammaTable:
                   {
-                    ret |= setGammaTable(Gen3A);
+                    settingRet = setGammaTable(Gen3A);
                   }
                   break;
 #endif
@@ -2148,6 +2293,17 @@ status_t OMXCameraAdapter::apply3Asettings( Gen3A_settings& Gen3A )
                                  currSett);
                     break;
                 }
+
+                ret |= settingRet;
+                if ( ( NO_ERROR == settingRet ) && copy3ASetting(currSett, mApplied3A, Gen3A) )
+                    {
+                    mApplied3AValid |= currSett;
+                    }
+                else
+                    {
+                    mApplied3AValid &= ~currSett;
+                    }
+
                 mPending3Asettings &= ~currSett;
             }
         }
@@ -272,7 +272,7 @@ status_t OMXCameraAdapter::setAutoConvergence(const char *pValstr, const char *p
     OMX_ERRORTYPE eError = OMX_ErrorNone;
     OMX_TI_CONFIG_CONVERGENCETYPE ACParams;
     const char *str = NULL;
-    android::Vector<android::sp<CameraArea> > tempAreas;
+    CameraAreas tempAreas;
     int mode;
     int changed = 0;
 
@@ -354,7 +354,7 @@ status_t OMXCameraAdapter::setAutoConvergence(const char *pValstr, const char *p
         }
 
         // transform the coordinates to 3A-type coordinates
-        mTouchAreas.itemAt(0)->transfrom((size_t)mPreviewData->mWidth/widthDivisor,
+        mTouchAreas[0].transfrom((size_t)mPreviewData->mWidth/widthDivisor,
                                          (size_t)mPreviewData->mHeight/heightDivisor,
                                          (size_t&) ACParams.nACProcWinStartY,
                                          (size_t&) ACParams.nACProcWinStartX,
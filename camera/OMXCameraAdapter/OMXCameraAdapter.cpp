@@ -82,6 +82,8 @@ status_t OMXCameraAdapter::initialize(CameraProperties::Properties* caps)
     mLocalVersionParam.s.nStep =  0x0;
 
     mPending3Asettings = 0;//E3AsettingsAll;
+    mApplied3AValid = 0;
+    m3AConfigsSaved = 0;
     mPendingCaptureSettings = 0;
     mPendingPreviewSettings = 0;
     mPendingReprocessSettings = 0;
@@ -130,6 +132,15 @@ status_t OMXCameraAdapter::initialize(CameraProperties::Properties* caps)
 
     mComponentState = OMX_StateLoaded;
 
+#ifndef USES_LEGACY_DOMX_DCC
+    // Capabilities may have come from the cache without the component ever
+    // being loaded, so the DCC profiles could still be pending
+    {
+        DCCHandler dcc_handler;
+        dcc_handler.loadDCC(mCameraAdapterParameters.mHandleComp);
+    }
+#endif
+
     CAMHAL_LOGVB("OMX_GetHandle -0x%x sensor_index = %lu", eError, mSensorIndex);
 #ifndef CAMERAHAL_TUNA
     initDccFileDataSave(&mCameraAdapterParameters.mHandleComp, mCameraAdapterParameters.mPrevPortIndex);
@@ -200,10 +211,10 @@ status_t OMXCameraAdapter::initialize(CameraProperties::Properties* caps)
 
     mBracketingEnabled = false;
     mZoomBracketingEnabled = false;
-    mBracketingBuffersQueuedCount = 0;
+    mBracketingHeldHead = 0;
+    mBracketingHeldCount = 0;
+    mBracketingHeldMax = 0;
     mBracketingRange = 1;
-    mLastBracetingBufferIdx = 0;
-    mBracketingBuffersQueued = NULL;
     mOMXStateSwitch = false;
     mBracketingSet = false;
 #ifdef CAMERAHAL_USE_RAW_IMAGE_SAVING
@@ -232,6 +243,13 @@ status_t OMXCameraAdapter::initialize(CameraProperties::Properties* caps)
     mReturnZoomStatus = false;
     mZoomInc = 1;
     mZoomParameterIdx = 0;
+    mSmoothZoomStartIdx = 0;
+    mSmoothZoomStartTime = 0;
+    {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("camera.omx.smoothzoom.stepms", value, "33");
+    mSmoothZoomStepTime = ms2ns(atoi(value));
+    }
     mExposureBracketingValidEntries = 0;
     mZoomBracketingValidEntries = 0;
     mSensorOverclock = false;
@@ -263,6 +281,7 @@ status_t OMXCameraAdapter::initialize(CameraProperties::Properties* caps)
     mEXIFData.mGPSData.mTimeStampValid = false;
     mEXIFData.mModelValid = false;
     mEXIFData.mMakeValid = false;
+    mEXIFTemplateValid = false;
 
     mCapturedFrames = 0;
     mBurstFramesAccum = 0;
@@ -339,6 +358,7 @@ status_t OMXCameraAdapter::initialize(CameraProperties::Properties* caps)
     //Setting this flag will that the first setParameter call will apply all 3A settings
     //and will not conditionally apply based on current values.
     mFirstTimeInit = true;
+    mApplied3AValid = 0;
 
     //Flag to avoid calling setVFramerate() before OMX_SetParameter(OMX_IndexParamPortDefinition)
     //Ducati will return an error otherwise.
@@ -486,34 +506,42 @@ status_t OMXCameraAdapter::fillThisBuffer(CameraBuffer * frameBuf, CameraFrame::
         }
 
     if ( NO_ERROR == ret ) {
-        for ( int i = 0 ; i < port->mNumBufs ; i++) {
-            if ((CameraBuffer *) port->mBufferHeader[i]->pAppPrivate == frameBuf) {
-                if ( isCaptureFrame && !mBracketingEnabled ) {
-                    android::AutoMutex lock(mBurstLock);
-                    if ((1 > mCapturedFrames) && !mBracketingEnabled && (mCapMode != CP_CAM)) {
-                        // Signal end of image capture
-                        if ( NULL != mEndImageCaptureCallback) {
-                            mEndImageCaptureCallback(mEndCaptureData);
-                        }
-                        port->mStatus[i] = OMXCameraPortParameters::IDLE;
-                        return NO_ERROR;
-                    } else if (mBurstFramesQueued >= mBurstFramesAccum) {
-                        port->mStatus[i] = OMXCameraPortParameters::IDLE;
-                        return NO_ERROR;
-                    }
-                    mBurstFramesQueued++;
+        // The buffer index is the port slot unless buffers were reordered
+        int i = frameBuf->index;
+        if ( ( 0 > i ) || ( i >= port->mNumBufs ) ||
+             ( (CameraBuffer *) port->mBufferHeader[i]->pAppPrivate != frameBuf ) ) {
+            for ( i = 0 ; i < port->mNumBufs ; i++ ) {
+                if ( (CameraBuffer *) port->mBufferHeader[i]->pAppPrivate == frameBuf ) {
+                    break;
                 }
-                port->mStatus[i] = OMXCameraPortParameters::FILL;
-                eError = OMX_FillThisBuffer(mCameraAdapterParameters.mHandleComp, port->mBufferHeader[i]);
-                if ( eError != OMX_ErrorNone )
-                {
-                    CAMHAL_LOGEB("OMX_FillThisBuffer 0x%x", eError);
-                    goto EXIT;
+            }
+        }
+
+        if ( i < port->mNumBufs ) {
+            if ( isCaptureFrame && !mBracketingEnabled ) {
+                android::AutoMutex lock(mBurstLock);
+                if ((1 > mCapturedFrames) && !mBracketingEnabled && (mCapMode != CP_CAM)) {
+                    // Signal end of image capture
+                    if ( NULL != mEndImageCaptureCallback) {
+                        mEndImageCaptureCallback(mEndCaptureData);
+                    }
+                    port->mStatus[i] = OMXCameraPortParameters::IDLE;
+                    return NO_ERROR;
+                } else if (mBurstFramesQueued >= mBurstFramesAccum) {
+                    port->mStatus[i] = OMXCameraPortParameters::IDLE;
+                    return NO_ERROR;
                 }
-                mFramesWithDucati++;
-                break;
-           }
-       }
+                mBurstFramesQueued++;
+            }
+            port->mStatus[i] = OMXCameraPortParameters::FILL;
+            eError = OMX_FillThisBuffer(mCameraAdapterParameters.mHandleComp, port->mBufferHeader[i]);
+            if ( eError != OMX_ErrorNone )
+            {
+                CAMHAL_LOGEB("OMX_FillThisBuffer 0x%x", eError);
+                goto EXIT;
+            }
+            mFramesWithDucati++;
+        }
     }
 
     LOG_FUNCTION_NAME_EXIT;
@@ -792,7 +820,7 @@ static status_t saveBufferToFile(const void *buf, int size, const char *filename
 #endif
 
 
-void OMXCameraAdapter::getParameters(android::CameraParameters& params)
+void OMXCameraAdapter::getParameters(CameraHalParameters& params)
 {
     status_t ret = NO_ERROR;
     OMX_CONFIG_EXPOSUREVALUETYPE exp;
@@ -2106,6 +2134,7 @@ status_t OMXCameraAdapter::UseBuffersPreview(CameraBuffer * bufArr, int num)
         GOTO_EXIT_IF((eError!=OMX_ErrorNone), eError);
 
         pBufferHdr->pAppPrivate = (OMX_PTR)&bufArr[index];
+        bufArr[index].index = index;
         pBufferHdr->nSize = sizeof(OMX_BUFFERHEADERTYPE);
         pBufferHdr->nVersion.s.nVersionMajor = 1 ;
         pBufferHdr->nVersion.s.nVersionMinor = 1 ;
@@ -2133,6 +2162,7 @@ status_t OMXCameraAdapter::UseBuffersPreview(CameraBuffer * bufArr, int num)
              if ( eError == OMX_ErrorNone )
                 {
                 pBufHdr->pAppPrivate = (OMX_PTR *)&mPreviewDataBuffers[i];
+                mPreviewDataBuffers[i].index = i;
                 pBufHdr->nSize = sizeof(OMX_BUFFERHEADERTYPE);
                 pBufHdr->nVersion.s.nVersionMajor = 1 ;
                 pBufHdr->nVersion.s.nVersionMinor = 1 ;
@@ -2382,7 +2412,7 @@ status_t OMXCameraAdapter::destroyTunnel()
     mCaptureData = &mCameraAdapterParameters.mCameraPortParams[mCameraAdapterParameters.mImagePortIndex];
     measurementData = &mCameraAdapterParameters.mCameraPortParams[mCameraAdapterParameters.mMeasurementPortIndex];
 
-    if (mAdapterState == LOADED_PREVIEW_STATE) {
+    if (getState() == LOADED_PREVIEW_STATE) {
         // Something happened in CameraHal between UseBuffers and startPreview
         // this means that state switch is still locked..so we need to unlock else
         // deadlock will occur on the next start preview
@@ -2513,6 +2543,7 @@ status_t OMXCameraAdapter::stopPreview() {
     switchToLoaded();
 
     mFirstTimeInit = true;
+    mApplied3AValid = 0;
     mPendingCaptureSettings = 0;
     mPendingReprocessSettings = 0;
     mFramesWithDucati = 0;
@@ -2755,7 +2786,7 @@ status_t OMXCameraAdapter::takePicture()
 
     LOG_FUNCTION_NAME;
 
-    if (mNextState != REPROCESS_STATE) {
+    if (getNextState() != REPROCESS_STATE) {
         android::AutoMutex lock(mFrameCountMutex);
         if (mFrameCount < 1) {
             // first frame may time some time to come...so wait for an adequate amount of time
@@ -2770,7 +2801,7 @@ status_t OMXCameraAdapter::takePicture()
 
     // TODO(XXX): re-using take picture to kick off reprocessing pipe
     // Need to rethink this approach during reimplementation
-    if (mNextState == REPROCESS_STATE) {
+    if (getNextState() == REPROCESS_STATE) {
         msg.command = CommandHandler::CAMERA_START_REPROCESS;
     } else {
         msg.command = CommandHandler::CAMERA_START_IMAGE_CAPTURE;
@@ -3391,8 +3422,7 @@ OMX_ERRORTYPE OMXCameraAdapterFillBufferDone(OMX_IN OMX_HANDLETYPE hComponent,
 
 #ifdef CAMERAHAL_OMX_PROFILING
 
-status_t OMXCameraAdapter::storeProfilingData(OMX_BUFFERHEADERTYPE* pBuffHeader) {
-    OMX_TI_PLATFORMPRIVATE *platformPrivate = NULL;
+status_t OMXCameraAdapter::storeProfilingData(const ExtradataIndex &extradata) {
     OMX_OTHER_EXTRADATATYPE *extraData = NULL;
     FILE *fd = NULL;
 
@@ -3400,9 +3430,7 @@ status_t OMXCameraAdapter::storeProfilingData(OMX_BUFFERHEADERTYPE* pBuffHeader)
 
     if ( UNLIKELY( mDebugProfile ) ) {
 
-        platformPrivate =  static_cast<OMX_TI_PLATFORMPRIVATE *> (pBuffHeader->pPlatformPrivate);
-        extraData = getExtradata(platformPrivate,
-                static_cast<OMX_EXTRADATATYPE> (OMX_TI_ProfilerData));
+        extraData = extradata.find(static_cast<OMX_EXTRADATATYPE> (OMX_TI_ProfilerData));
 
         if ( NULL != extraData ) {
             if( extraData->eType == static_cast<OMX_EXTRADATATYPE> (OMX_TI_ProfilerData) ) {
@@ -3457,9 +3485,17 @@ OMX_ERRORTYPE OMXCameraAdapter::OMXCameraAdapterFillBufferDone(OMX_IN OMX_HANDLE
         return OMX_ErrorBadParameter;
     }
 
+    // Only preview buffers start a traced frame
+    if ( OMX_CAMERA_PORT_VIDEO_OUT_PREVIEW == pBuffHeader->nOutputPortIndex ) {
+        CAMHAL_TRACE_FRAME(pBuffHeader->pAppPrivate, STAGE_FILL_BUFFER_DONE);
+    }
+
+    // Shared by all the extradata consumers of this buffer
+    const ExtradataIndex extradata(pBuffHeader->pPlatformPrivate);
+
 #ifdef CAMERAHAL_OMX_PROFILING
 
-    storeProfilingData(pBuffHeader);
+    storeProfilingData(extradata);
 
 #endif
 
@@ -3472,10 +3508,17 @@ OMX_ERRORTYPE OMXCameraAdapter::OMXCameraAdapterFillBufferDone(OMX_IN OMX_HANDLE
 
     pPortParam = &(mCameraAdapterParameters.mCameraPortParams[pBuffHeader->nOutputPortIndex]);
 
-    // Find buffer and mark it as filled
-    for (int i = 0; i < pPortParam->mNumBufs; i++) {
-        if (pPortParam->mBufferHeader[i] == pBuffHeader) {
-            pPortParam->mStatus[i] = OMXCameraPortParameters::DONE;
+    // Mark buffer as filled, its slot was recorded when the port buffers were registered
+    const CameraBuffer *filledBuffer = (const CameraBuffer *) pBuffHeader->pAppPrivate;
+    if ( ( NULL != filledBuffer ) &&
+         ( 0 <= filledBuffer->index ) && ( filledBuffer->index < pPortParam->mNumBufs ) &&
+         ( pPortParam->mBufferHeader[filledBuffer->index] == pBuffHeader ) ) {
+        pPortParam->mStatus[filledBuffer->index] = OMXCameraPortParameters::DONE;
+    } else {
+        for (int i = 0; i < pPortParam->mNumBufs; i++) {
+            if (pPortParam->mBufferHeader[i] == pBuffHeader) {
+                pPortParam->mStatus[i] = OMXCameraPortParameters::DONE;
+            }
         }
     }
 
@@ -3488,8 +3531,7 @@ OMX_ERRORTYPE OMXCameraAdapter::OMXCameraAdapterFillBufferDone(OMX_IN OMX_HANDLE
             }
 
         if ( mWaitingForSnapshot ) {
-            extraData = getExtradata(pBuffHeader->pPlatformPrivate,
-                                     (OMX_EXTRADATATYPE) OMX_AncillaryData);
+            extraData = extradata.find((OMX_EXTRADATATYPE) OMX_AncillaryData);
 
             if ( NULL != extraData ) {
                 ancillaryData = (OMX_TI_ANCILLARYDATATYPE*) extraData->data;
@@ -3517,8 +3559,7 @@ OMX_ERRORTYPE OMXCameraAdapter::OMXCameraAdapterFillBufferDone(OMX_IN OMX_HANDLE
             // video snapshot gets ancillary data and wb info from last snapshot frame
             mCaptureAncillaryData = ancillaryData;
             mWhiteBalanceData = NULL;
-            extraData = getExtradata(pBuffHeader->pPlatformPrivate,
-                                     (OMX_EXTRADATATYPE) OMX_WhiteBalance);
+            extraData = extradata.find((OMX_EXTRADATATYPE) OMX_WhiteBalance);
             if ( NULL != extraData )
                 {
                 mWhiteBalanceData = (OMX_TI_WHITEBALANCERESULTTYPE*) extraData->data;
@@ -3571,7 +3612,7 @@ OMX_ERRORTYPE OMXCameraAdapter::OMXCameraAdapterFillBufferDone(OMX_IN OMX_HANDLE
 
         recalculateFPS();
 
-        createPreviewMetadata(pBuffHeader, metadataResult, pPortParam->mWidth, pPortParam->mHeight);
+        createPreviewMetadata(extradata, metadataResult, pPortParam->mWidth, pPortParam->mHeight);
         if ( NULL != metadataResult.get() ) {
             notifyMetadataSubscribers(metadataResult);
             metadataResult.clear();
@@ -3593,7 +3634,7 @@ OMX_ERRORTYPE OMXCameraAdapter::OMXCameraAdapterFillBufferDone(OMX_IN OMX_HANDLE
         }
 
 #ifndef CAMERAHAL_TUNA
-        sniffDccFileDataSave(pBuffHeader);
+        sniffDccFileDataSave(extradata);
 #endif
 
         stat |= advanceZoom();
@@ -3687,7 +3728,7 @@ OMX_ERRORTYPE OMXCameraAdapter::OMXCameraAdapterFillBufferDone(OMX_IN OMX_HANDLE
 
 #ifdef OMAP_ENHANCEMENT_CPCAM
         if ( NULL != mSharedAllocator ) {
-            cameraFrame.mMetaData = new CameraMetadataResult(getMetaData(pBuffHeader->pPlatformPrivate, mSharedAllocator));
+            cameraFrame.mMetaData = new CameraMetadataResult(getMetaData(extradata, mSharedAllocator));
         }
 #endif
 
@@ -3870,8 +3911,6 @@ status_t OMXCameraAdapter::sendCallBacks(CameraFrame frame, OMX_IN OMX_BUFFERHEA
       return -EINVAL;
     }
 
-  android::AutoMutex lock(mSubscriberLock);
-
   //frame.mFrameType = typeOfFrame;
   frame.mFrameMask = mask;
   frame.mBuffer = (CameraBuffer *)pBuffHeader->pAppPrivate;
@@ -4076,10 +4115,57 @@ status_t OMXCameraAdapter::setExtraData(bool enable, OMX_U32 nPortIndex, OMX_EXT
     return (ret | Utils::ErrorUtils::omxToAndroidError(eError));
 }
 
-OMX_OTHER_EXTRADATATYPE *OMXCameraAdapter::getExtradata(const OMX_PTR ptrPrivate, OMX_EXTRADATATYPE type) const
+OMXCameraAdapter::ExtradataIndex::ExtradataIndex(const OMX_PTR platformPrivate)
+    : mPlatformPrivate(platformPrivate),
+      mParsed(false),
+      mCount(0),
+      mOverflow(NULL),
+      mOverflowSize(0)
+{
+}
+
+OMX_OTHER_EXTRADATATYPE *OMXCameraAdapter::ExtradataIndex::find(OMX_EXTRADATATYPE type) const
+{
+    if ( !mParsed ) {
+        parse();
+    }
+
+    for ( int i = 0; i < mCount; i++ ) {
+        if ( type == mTypes[i] ) {
+            return mEntries[i];
+        }
+    }
+
+    if ( NULL != mOverflow ) {
+        return walk(mOverflow, mOverflowSize, type);
+    }
+
+    // Required extradata type wasn't found
+    return NULL;
+}
+
+OMX_OTHER_EXTRADATATYPE *OMXCameraAdapter::ExtradataIndex::walk(OMX_OTHER_EXTRADATATYPE *extraData,
+                                                                 OMX_U32 remainingSize,
+                                                                 OMX_EXTRADATATYPE type) const
+{
+    while ( extraData->eType && extraData->nDataSize && extraData->data &&
+        (remainingSize >= extraData->nSize)) {
+        if ( type == extraData->eType ) {
+            return extraData;
+        }
+        remainingSize -= extraData->nSize;
+        extraData = (OMX_OTHER_EXTRADATATYPE*) ((char*)extraData + extraData->nSize);
+    }
+
+    return NULL;
+}
+
+void OMXCameraAdapter::ExtradataIndex::parse() const
 {
-    if ( NULL != ptrPrivate ) {
-        const OMX_TI_PLATFORMPRIVATE *platformPrivate = (const OMX_TI_PLATFORMPRIVATE *) ptrPrivate;
+    mParsed = true;
+
+    if ( NULL != mPlatformPrivate ) {
+        const OMX_TI_PLATFORMPRIVATE *platformPrivate = (const OMX_TI_PLATFORMPRIVATE *) mPlatformPrivate;
 
         CAMHAL_LOGVB("Size = %d, sizeof = %d, pAuxBuf = 0x%x, pAuxBufSize= %d, pMetaDataBufer = 0x%x, nMetaDataSize = %d",
                       platformPrivate->nSize,
@@ -4095,9 +4181,14 @@ OMX_OTHER_EXTRADATATYPE *OMXCameraAdapter::getExtradata(const OMX_PTR ptrPrivate
                 if ( NULL != extraData ) {
                     while ( extraData->eType && extraData->nDataSize && extraData->data &&
                         (remainingSize >= extraData->nSize)) {
-                        if ( type == extraData->eType ) {
-                            return extraData;
+                        if ( MAX_ENTRIES == mCount ) {
+                            mOverflow = extraData;
+                            mOverflowSize = remainingSize;
+                            break;
                         }
+                        mTypes[mCount] = extraData->eType;
+                        mEntries[mCount] = extraData;
+                        mCount++;
                         remainingSize -= extraData->nSize;
                         extraData = (OMX_OTHER_EXTRADATATYPE*) ((char*)extraData + extraData->nSize);
                     }
@@ -4116,9 +4207,6 @@ OMX_OTHER_EXTRADATATYPE *OMXCameraAdapter::getExtradata(const OMX_PTR ptrPrivate
     }  else {
         CAMHAL_LOGEA("Invalid OMX_TI_PLATFORMPRIVATE");
     }
-
-    // Required extradata type wasn't found
-    return NULL;
 }
 
 OMXCameraAdapter::CachedCaptureParameters* OMXCameraAdapter::cacheCaptureParameters() {
@@ -4190,6 +4278,8 @@ OMXCameraAdapter::OMXCameraAdapter(size_t sensor_index)
 
     mPreviewPortInitialized = false;
 
+    mAlgoAreasBuffer = NULL;
+
     LOG_FUNCTION_NAME_EXIT;
 }
 
@@ -4219,6 +4309,11 @@ OMXCameraAdapter::~OMXCameraAdapter()
         mOmxInitialized = false;
     }
 
+    if ( NULL != mAlgoAreasBuffer ) {
+        mMemMgr.freeBufferList(mAlgoAreasBuffer);
+        mAlgoAreasBuffer = NULL;
+    }
+
     //Remove any unhandled events
     if ( !mEventSignalQ.isEmpty() )
       {
@@ -932,15 +932,16 @@ status_t OMXCameraAdapter::doBracketing(OMX_BUFFERHEADERTYPE *pBuffHeader,
 
     if ( NO_ERROR == ret )
         {
-        mBracketingBuffersQueued[currentBufferIdx] = false;
-        mBracketingBuffersQueuedCount--;
+        mBracketingHeld[( mBracketingHeldHead + mBracketingHeldCount ) % MAX_NO_BUFFERS] = currentBufferIdx;
+        mBracketingHeldCount++;
 
-        if ( 0 >= mBracketingBuffersQueuedCount )
+        // Only the frames a capture request can still use are held back,
+        // every older one goes straight back to the component
+        while ( mBracketingHeldCount > mBracketingHeldMax )
             {
-            nextBufferIdx = ( currentBufferIdx + 1 ) % imgCaptureData->mNumBufs;
-            mBracketingBuffersQueued[nextBufferIdx] = true;
-            mBracketingBuffersQueuedCount++;
-            mLastBracetingBufferIdx = nextBufferIdx;
+            nextBufferIdx = mBracketingHeld[mBracketingHeldHead];
+            mBracketingHeldHead = ( mBracketingHeldHead + 1 ) % MAX_NO_BUFFERS;
+            mBracketingHeldCount--;
             setFrameRefCountByType((CameraBuffer *)imgCaptureData->mBufferHeader[nextBufferIdx]->pAppPrivate, typeOfFrame, 1);
             returnFrame((CameraBuffer *)imgCaptureData->mBufferHeader[nextBufferIdx]->pAppPrivate, typeOfFrame);
             }
@@ -970,23 +971,20 @@ status_t OMXCameraAdapter::sendBracketFrames(size_t &framesSent)
 
     if ( NO_ERROR == ret )
         {
-
-        currentBufferIdx = mLastBracetingBufferIdx;
-        do
+        // Oldest first, the order the frames were captured in
+        while ( 0 < mBracketingHeldCount )
             {
-            currentBufferIdx++;
-            currentBufferIdx %= imgCaptureData->mNumBufs;
-            if (!mBracketingBuffersQueued[currentBufferIdx] )
-                {
-                CameraFrame cameraFrame;
-                sendCallBacks(cameraFrame,
-                              imgCaptureData->mBufferHeader[currentBufferIdx],
-                              imgCaptureData->mImageType,
-                              imgCaptureData);
-                framesSent++;
-                }
-            } while ( currentBufferIdx != mLastBracetingBufferIdx );
-
+            currentBufferIdx = mBracketingHeld[mBracketingHeldHead];
+            mBracketingHeldHead = ( mBracketingHeldHead + 1 ) % MAX_NO_BUFFERS;
+            mBracketingHeldCount--;
+
+            CameraFrame cameraFrame;
+            sendCallBacks(cameraFrame,
+                          imgCaptureData->mBufferHeader[currentBufferIdx],
+                          imgCaptureData->mImageType,
+                          imgCaptureData);
+            framesSent++;
+            }
         }
 
     LOG_FUNCTION_NAME_EXIT;
@@ -1032,24 +1030,16 @@ status_t OMXCameraAdapter::startBracketing(int range)
         android::AutoMutex lock(mBracketingLock);
 
         mBracketingRange = range;
-        mBracketingBuffersQueued = new bool[imgCaptureData->mNumBufs];
-        if ( NULL == mBracketingBuffersQueued )
+        mBurstFramesAccum = imgCaptureData->mNumBufs;
+        mBracketingHeldHead = 0;
+        mBracketingHeldCount = 0;
+
+        // Keep the frames preceding the capture request, and at least one
+        // buffer with the component
+        mBracketingHeldMax = ( 1 < range ) ? ( range - 1 ) : 1;
+        if ( mBracketingHeldMax > ( imgCaptureData->mNumBufs - 1 ) )
             {
-            CAMHAL_LOGEA("Unable to allocate bracketing management structures");
-            ret = -1;
-            }
-
-        if ( NO_ERROR == ret )
-            {
-            mBracketingBuffersQueuedCount = imgCaptureData->mNumBufs;
-            mBurstFramesAccum = imgCaptureData->mNumBufs;
-            mLastBracetingBufferIdx = mBracketingBuffersQueuedCount - 1;
-
-            for ( int i = 0 ; i  < imgCaptureData->mNumBufs ; i++ )
-                {
-                mBracketingBuffersQueued[i] = true;
-                }
-
+            mBracketingHeldMax = imgCaptureData->mNumBufs - 1;
             }
         }
 
@@ -1087,15 +1077,9 @@ status_t OMXCameraAdapter::stopBracketing()
 
     android::AutoMutex lock(mBracketingLock);
 
-    if ( NULL != mBracketingBuffersQueued )
-    {
-        delete [] mBracketingBuffersQueued;
-    }
-
-    mBracketingBuffersQueued = NULL;
     mBracketingEnabled = false;
-    mBracketingBuffersQueuedCount = 0;
-    mLastBracetingBufferIdx = 0;
+    mBracketingHeldHead = 0;
+    mBracketingHeldCount = 0;
 
     LOG_FUNCTION_NAME_EXIT;
 
@@ -1389,7 +1373,7 @@ status_t OMXCameraAdapter::stopImageCapture()
     }
 
     // TODO(XXX): Reprocessing is currently piggy-backing capture commands
-    if (mAdapterState == REPROCESS_STATE) {
+    if (getState() == REPROCESS_STATE) {
         ret = stopReprocess();
     }
 
@@ -1896,7 +1880,7 @@ status_t OMXCameraAdapter::UseBuffersCapture(CameraBuffer * bufArr, int num)
 
 #endif
 
-        if (mNextState != LOADED_REPROCESS_CAPTURE_STATE) {
+        if (getNextState() != LOADED_REPROCESS_CAPTURE_STATE) {
             // Enable WB and vector shot extra data for metadata
             setExtraData(true, mCameraAdapterParameters.mImagePortIndex, OMX_WhiteBalance);
 #ifndef CAMERAHAL_TUNA
@@ -1907,7 +1891,7 @@ status_t OMXCameraAdapter::UseBuffersCapture(CameraBuffer * bufArr, int num)
 #ifdef OMAP_ENHANCEMENT_CPCAM
         // CPCam mode only supports vector shot
         // Regular capture is not supported
-        if ( (mCapMode == CP_CAM) && (mNextState != LOADED_REPROCESS_CAPTURE_STATE) ) {
+        if ( (mCapMode == CP_CAM) && (getNextState() != LOADED_REPROCESS_CAPTURE_STATE) ) {
             initVectorShot();
         }
 #endif
@@ -1938,9 +1922,9 @@ status_t OMXCameraAdapter::UseBuffersCapture(CameraBuffer * bufArr, int num)
     if (( NO_ERROR == ret) && (OMXCameraAdapter::CP_CAM == mCapMode)) {
         OMX_TI_CONFIG_SINGLEPREVIEWMODETYPE singlePrevMode;
         OMX_INIT_STRUCT_PTR (&singlePrevMode, OMX_TI_CONFIG_SINGLEPREVIEWMODETYPE);
-        if (mNextState == LOADED_CAPTURE_STATE) {
+        if (getNextState() == LOADED_CAPTURE_STATE) {
             singlePrevMode.eMode = OMX_TI_SinglePreviewMode_ImageCaptureHighSpeed;
-        } else if (mNextState == LOADED_REPROCESS_CAPTURE_STATE) {
+        } else if (getNextState() == LOADED_REPROCESS_CAPTURE_STATE) {
             singlePrevMode.eMode = OMX_TI_SinglePreviewMode_Reprocess;
         } else {
             CAMHAL_LOGE("Wrong state trying to start a capture in CPCAM mode?");
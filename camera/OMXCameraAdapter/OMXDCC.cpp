@@ -27,6 +27,8 @@
 #include "OMXDCC.h"
 #include <utils/String8.h>
 #include <utils/Vector.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace Ti {
 namespace Camera {
@@ -36,8 +38,38 @@ android::String8 DCCHandler::DCCPath("/data/misc/camera/");
 #else
 android::String8 DCCHandler::DCCPath("/system/etc/omapcam/");
 #endif
+android::String8 DCCHandler::DCCCachePath("/data/misc/camera/");
 bool DCCHandler::mDCCLoaded = false;
 
+static const uint32_t DCC_CACHE_MAGIC = 0x43434344; // "DCCC"
+static const uint32_t DCC_CACHE_VERSION = 1;
+static const size_t DCC_CACHE_PATH_SIZE = 256;
+
+struct DCCCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fileCount;
+    uint32_t payloadSize;
+};
+
+struct DCCCacheEntry {
+    char path[DCC_CACHE_PATH_SIZE];
+    uint32_t size;
+    uint32_t hash;
+    int64_t mtime;
+};
+
+static uint32_t hashDCC(const uint8_t *data, size_t size, uint32_t hash = 2166136261U)
+{
+    // FNV-1a
+    for ( size_t i = 0 ; i < size ; i++ ) {
+        hash ^= data[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
 status_t DCCHandler::loadDCC(OMX_HANDLETYPE hComponent)
 {
     OMX_ERRORTYPE dccError = OMX_ErrorNone;
@@ -46,9 +78,10 @@ status_t DCCHandler::loadDCC(OMX_HANDLETYPE hComponent)
         dccError = initDCC(hComponent);
         if (dccError != OMX_ErrorNone) {
             CAMHAL_LOGE(" Error in DCC Init");
+        } else {
+            // A failed load is retried on the next open
+            mDCCLoaded = true;
         }
-
-        mDCCLoaded = true;
     }
 
     return Utils::ErrorUtils::omxToAndroidError(dccError);
@@ -57,15 +90,16 @@ status_t DCCHandler::loadDCC(OMX_HANDLETYPE hComponent)
 OMX_ERRORTYPE DCCHandler::initDCC(OMX_HANDLETYPE hComponent)
 {
     OMX_TI_PARAM_DCCURIINFO param;
-    OMX_PTR ptempbuf;
     OMX_U16 nIndex = 0;
     OMX_ERRORTYPE eError = OMX_ErrorNone;
-    int ret;
-    OMX_S32 status = 0;
     android::Vector<android::String8 *> dccDirs;
+    android::Vector<DCCFile> dccFiles;
+    android::String8 uriKey;
+    android::String8 cachePath;
     OMX_U16 i;
     MemoryManager memMgr;
     CameraBuffer *dccBuffer = NULL;
+    size_t dccSize = 0;
     int dccbuf_size = 0;
     OMX_INIT_STRUCT_PTR(&param, OMX_TI_PARAM_DCCURIINFO);
 
@@ -85,6 +119,8 @@ OMX_ERRORTYPE DCCHandler::initDCC(OMX_HANDLETYPE hComponent)
                 dccDir->append((const char *) param.sDCCURI);
                 dccDir->append("/");
                 dccDirs.add(dccDir);
+                uriKey.append((const char *) param.sDCCURI);
+                uriKey.append("/");
             } else {
                 CAMHAL_LOGE("DCC URI not allocated");
                 eError = OMX_ErrorInsufficientResources;
@@ -98,13 +134,13 @@ OMX_ERRORTYPE DCCHandler::initDCC(OMX_HANDLETYPE hComponent)
         eError = OMX_ErrorNone;
     }
 
-    dccbuf_size = readDCCdir(NULL, dccDirs);
-    if(dccbuf_size <= 0) {
+    dccSize = listDCCdir(dccDirs, dccFiles);
+    if(dccSize == 0) {
         CAMHAL_LOGE("No DCC files found, switching back to default DCC");
         eError = OMX_ErrorInsufficientResources;
         goto EXIT;
     }
-    dccbuf_size = ((dccbuf_size + 4095 )/4096)*4096;
+    dccbuf_size = ((dccSize + 4095 )/4096)*4096;
 
     if ( memMgr.initialize() != NO_ERROR ) {
         CAMHAL_LOGE("DCC memory manager initialization failed!!!");
@@ -119,8 +155,18 @@ OMX_ERRORTYPE DCCHandler::initDCC(OMX_HANDLETYPE hComponent)
         goto EXIT;
     }
 
-    dccbuf_size = readDCCdir(dccBuffer[0].mapped, dccDirs);
-    CAMHAL_ASSERT_X(dccbuf_size > 0,"ERROR in copy DCC files into buffer");
+    // The URI set identifies the sensor, each one gets its own cache
+    cachePath.appendFormat("%sdcc-%08x.cache", DCCCachePath.string(),
+                           hashDCC((const uint8_t *) uriKey.string(), uriKey.length()));
+
+    if ( !loadDCCCache(cachePath, dccFiles, (uint8_t *) dccBuffer[0].mapped, dccSize) ) {
+        if ( readDCCFiles((uint8_t *) dccBuffer[0].mapped, dccFiles) != dccSize ) {
+            CAMHAL_LOGE("ERROR in copy DCC files into buffer");
+            eError = OMX_ErrorInsufficientResources;
+            goto EXIT;
+        }
+        saveDCCCache(cachePath, dccFiles, (const uint8_t *) dccBuffer[0].mapped, dccSize);
+    }
 
     eError = sendDCCBufPtr(hComponent, dccBuffer);
 
@@ -162,65 +208,191 @@ OMX_ERRORTYPE DCCHandler::sendDCCBufPtr(OMX_HANDLETYPE hComponent,
     return eError;
 }
 
-size_t DCCHandler::readDCCdir(OMX_PTR buffer,
-                          const android::Vector<android::String8 *> &dirPaths)
+size_t DCCHandler::listDCCdir(const android::Vector<android::String8 *> &dirPaths,
+                              android::Vector<DCCFile> &files)
 {
-    FILE *pFile;
-    OMX_S32 lSize;
-    OMX_S32 dcc_buf_size = 0;
-    size_t result;
-    OMX_STRING filename;
-    android::String8 temp;
     const char *dotdot = "..";
     DIR *d;
     struct dirent *dir;
-    OMX_U16 i = 0;
-    status_t stat = NO_ERROR;
-    size_t ret = 0;
+    struct stat st;
+    DCCFile file;
+    size_t dcc_buf_size = 0;
 
-    for (i = 0; i < dirPaths.size(); i++) {
+    for (size_t i = 0; i < dirPaths.size(); i++) {
         d = opendir(dirPaths.itemAt(i)->string());
         if (d) {
             // read each filename
             while ((dir = readdir(d)) != NULL) {
-                filename = dir->d_name;
-                temp.clear();
-                temp.append(dirPaths.itemAt(i)->string());
-                temp.append(filename);
-                if ((*filename != *dotdot)) {
-                    pFile = fopen(temp.string(), "rb");
-                    if (pFile == NULL) {
-                        stat = -errno;
-                    } else {
-                        fseek(pFile, 0, SEEK_END);
-                        lSize = ftell(pFile);
-                        rewind(pFile);
-                        // buffer is not NULL then copy all the DCC profiles into buffer
-                        // else return the size of the DCC directory.
-                        if (buffer) {
-                            // copy file into the buffer:
-                            result = fread(buffer, 1, lSize, pFile);
-                            if (result != (size_t) lSize) {
-                                stat = INVALID_OPERATION;
-                            }
-                            buffer = buffer + lSize;
-                        }
-                        // getting the size of the total dcc files available in FS */
-                        dcc_buf_size = dcc_buf_size + lSize;
-                        // terminate
-                        fclose(pFile);
-                    }
+                if ((*dir->d_name == *dotdot)) {
+                    continue;
+                }
+
+                file.path.setTo(dirPaths.itemAt(i)->string());
+                file.path.append(dir->d_name);
+                if ( ( 0 != stat(file.path.string(), &st) ) || !S_ISREG(st.st_mode) ) {
+                    continue;
                 }
+
+                file.size = st.st_size;
+                file.mtime = st.st_mtime;
+                files.add(file);
+
+                // getting the size of the total dcc files available in FS
+                dcc_buf_size += file.size;
             }
             closedir(d);
         }
     }
 
-    if (stat == NO_ERROR) {
-        ret = dcc_buf_size;
+    return dcc_buf_size;
+}
+
+size_t DCCHandler::readDCCFiles(uint8_t *buffer, const android::Vector<DCCFile> &files)
+{
+    FILE *pFile;
+    size_t result;
+    size_t dcc_buf_size = 0;
+    status_t stat = NO_ERROR;
+
+    for (size_t i = 0; i < files.size(); i++) {
+        const DCCFile &file = files.itemAt(i);
+
+        pFile = fopen(file.path.string(), "rb");
+        if (pFile == NULL) {
+            stat = -errno;
+            break;
+        }
+
+        // copy file into the buffer:
+        result = fread(buffer + dcc_buf_size, 1, file.size, pFile);
+        if (result != file.size) {
+            stat = INVALID_OPERATION;
+        }
+        dcc_buf_size += file.size;
+        fclose(pFile);
     }
 
-    return ret;
+    return ( NO_ERROR == stat ) ? dcc_buf_size : 0;
+}
+
+bool DCCHandler::loadDCCCache(const android::String8 &cachePath,
+                              const android::Vector<DCCFile> &files,
+                              uint8_t *buffer, size_t size)
+{
+    struct stat st;
+    bool valid = false;
+    int fd;
+
+    fd = open(cachePath.string(), O_RDONLY);
+    if ( 0 > fd ) {
+        return false;
+    }
+
+    const size_t mapSize = sizeof(DCCCacheHeader) + files.size() * sizeof(DCCCacheEntry) + size;
+    if ( ( 0 != fstat(fd, &st) ) || ( (size_t) st.st_size != mapSize ) ) {
+        CAMHAL_LOGD("DCC cache %s is stale", cachePath.string());
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ( MAP_FAILED == map ) {
+        return false;
+    }
+
+    const DCCCacheHeader *header = (const DCCCacheHeader *) map;
+    const DCCCacheEntry *entries = (const DCCCacheEntry *) ( header + 1 );
+    const uint8_t *payload = (const uint8_t *) ( entries + files.size() );
+
+    valid = ( DCC_CACHE_MAGIC == header->magic ) &&
+            ( DCC_CACHE_VERSION == header->version ) &&
+            ( files.size() == header->fileCount ) &&
+            ( size == header->payloadSize );
+
+    // Any source file added, removed, touched or resized invalidates the cache,
+    // the hashes catch a cache that was damaged after it was written
+    size_t offset = 0;
+    for ( size_t i = 0 ; valid && ( i < files.size() ) ; i++ ) {
+        const DCCFile &file = files.itemAt(i);
+        const DCCCacheEntry &entry = entries[i];
+
+        valid = ( 0 == strncmp(entry.path, file.path.string(), DCC_CACHE_PATH_SIZE) ) &&
+                ( entry.size == file.size ) &&
+                ( entry.mtime == file.mtime ) &&
+                ( entry.hash == hashDCC(payload + offset, entry.size) );
+        offset += entry.size;
+    }
+
+    if ( valid ) {
+        memcpy(buffer, payload, size);
+        CAMHAL_LOGD("DCC loaded from cache %s", cachePath.string());
+    } else {
+        CAMHAL_LOGD("DCC cache %s is stale", cachePath.string());
+    }
+
+    munmap(map, mapSize);
+
+    return valid;
+}
+
+void DCCHandler::saveDCCCache(const android::String8 &cachePath,
+                              const android::Vector<DCCFile> &files,
+                              const uint8_t *buffer, size_t size)
+{
+    android::String8 tempPath(cachePath);
+    DCCCacheHeader header;
+    DCCCacheEntry entry;
+    size_t offset = 0;
+    bool ok = true;
+    FILE *pFile;
+
+    for ( size_t i = 0 ; i < files.size() ; i++ ) {
+        if ( DCC_CACHE_PATH_SIZE <= files.itemAt(i).path.length() ) {
+            CAMHAL_LOGD("DCC path %s too long to cache", files.itemAt(i).path.string());
+            return;
+        }
+    }
+
+    // Written aside and renamed so a reader never sees a partial cache
+    tempPath.append(".tmp");
+    pFile = fopen(tempPath.string(), "wb");
+    if ( NULL == pFile ) {
+        CAMHAL_LOGD("Unable to create DCC cache %s: %d", tempPath.string(), -errno);
+        return;
+    }
+
+    header.magic = DCC_CACHE_MAGIC;
+    header.version = DCC_CACHE_VERSION;
+    header.fileCount = files.size();
+    header.payloadSize = size;
+    ok = ( 1 == fwrite(&header, sizeof(header), 1, pFile) );
+
+    for ( size_t i = 0 ; ok && ( i < files.size() ) ; i++ ) {
+        const DCCFile &file = files.itemAt(i);
+
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.path, file.path.string(), DCC_CACHE_PATH_SIZE - 1);
+        entry.size = file.size;
+        entry.mtime = file.mtime;
+        entry.hash = hashDCC(buffer + offset, file.size);
+        offset += file.size;
+
+        ok = ( 1 == fwrite(&entry, sizeof(entry), 1, pFile) );
+    }
+
+    if ( ok ) {
+        ok = ( size == fwrite(buffer, 1, size, pFile) );
+    }
+
+    ok = ( 0 == fclose(pFile) ) && ok;
+
+    if ( ok && ( 0 == rename(tempPath.string(), cachePath.string()) ) ) {
+        CAMHAL_LOGD("DCC cache %s written", cachePath.string());
+    } else {
+        CAMHAL_LOGE("Unable to write DCC cache %s", cachePath.string());
+        unlink(tempPath.string());
+    }
 }
 
 } // namespace Camera
@@ -62,7 +62,7 @@ status_t OMXCameraAdapter::initDccFileDataSave(OMX_HANDLETYPE* omxHandle, int po
     return ret;
 }
 
-status_t OMXCameraAdapter::sniffDccFileDataSave(OMX_BUFFERHEADERTYPE* pBuffHeader)
+status_t OMXCameraAdapter::sniffDccFileDataSave(const ExtradataIndex &extradata)
 {
     OMX_OTHER_EXTRADATATYPE *extraData;
     OMX_TI_DCCDATATYPE* dccData;
@@ -72,14 +72,7 @@ status_t OMXCameraAdapter::sniffDccFileDataSave(OMX_BUFFERHEADERTYPE* pBuffHeade
 
     android::AutoMutex lock(mDccDataLock);
 
-    if ( NULL == pBuffHeader ) {
-        CAMHAL_LOGEA("Invalid Buffer header");
-        LOG_FUNCTION_NAME_EXIT;
-        return -EINVAL;
-    }
-
-    extraData = getExtradata(pBuffHeader->pPlatformPrivate,
-                             (OMX_EXTRADATATYPE)OMX_TI_DccData);
+    extraData = extradata.find((OMX_EXTRADATATYPE)OMX_TI_DccData);
 
     if ( NULL != extraData ) {
         CAMHAL_LOGVB("Size = %d, sizeof = %d, eType = 0x%x, nDataSize= %d, nPortIndex = 0x%x, nVersion = 0x%x",
@@ -34,6 +34,7 @@ status_t OMXCameraAdapter::setParametersEXIF(const android::CameraParameters &pa
     status_t ret = NO_ERROR;
     const char *valstr = NULL;
     double gpsPos;
+    const EXIFData previous = mEXIFData;
 
     LOG_FUNCTION_NAME;
 
@@ -220,6 +221,9 @@ status_t OMXCameraAdapter::setParametersEXIF(const android::CameraParameters &pa
         mEXIFData.mFocalDen = 0;
     }
 
+    if ( 0 != memcmp(&previous, &mEXIFData, sizeof(EXIFData)) ) {
+        mEXIFTemplateValid = false;
+    }
 
     LOG_FUNCTION_NAME_EXIT;
 
@@ -528,19 +532,14 @@ status_t OMXCameraAdapter::setupEXIF()
     return ret;
 }
 
-status_t OMXCameraAdapter::setupEXIF_libjpeg(ExifElementsTable* exifTable,
-                                             OMX_TI_ANCILLARYDATATYPE* pAncillaryData,
-                                             OMX_TI_WHITEBALANCERESULTTYPE* pWhiteBalanceData)
+status_t OMXCameraAdapter::setupEXIFTemplate(const OMXCameraPortParameters *capData)
 {
     status_t ret = NO_ERROR;
-    OMX_ERRORTYPE eError = OMX_ErrorNone;
-    struct timeval sTv;
-    struct tm *pTime;
-    OMXCameraPortParameters * capData = NULL;
+    ExifElementsTable *exifTable = &mEXIFTemplate;
 
     LOG_FUNCTION_NAME;
 
-    capData = &mCameraAdapterParameters.mCameraPortParams[mCameraAdapterParameters.mImagePortIndex];
+    exifTable->clear();
 
     if ((NO_ERROR == ret) && (mEXIFData.mModelValid)) {
         ret = exifTable->insertElement(TAG_MODEL, mEXIFData.mModel);
@@ -563,23 +562,6 @@ status_t OMXCameraAdapter::setupEXIF_libjpeg(ExifElementsTable* exifTable,
         }
     }
 
-    if ((NO_ERROR == ret)) {
-        int status = gettimeofday (&sTv, NULL);
-        pTime = localtime (&sTv.tv_sec);
-        char temp_value[EXIF_DATE_TIME_SIZE + 1];
-        if ((0 == status) && (NULL != pTime)) {
-            snprintf(temp_value, EXIF_DATE_TIME_SIZE,
-                     "%04d:%02d:%02d %02d:%02d:%02d",
-                     pTime->tm_year + 1900,
-                     pTime->tm_mon + 1,
-                     pTime->tm_mday,
-                     pTime->tm_hour,
-                     pTime->tm_min,
-                     pTime->tm_sec );
-            ret = exifTable->insertElement(TAG_DATETIME, temp_value);
-        }
-     }
-
     if ((NO_ERROR == ret)) {
         char temp_value[5];
         snprintf(temp_value, sizeof(temp_value)/sizeof(char), "%lu", (unsigned long)capData->mWidth);
@@ -686,28 +668,11 @@ status_t OMXCameraAdapter::setupEXIF_libjpeg(ExifElementsTable* exifTable,
         ret = exifTable->insertElement(TAG_GPS_DATESTAMP, mEXIFData.mGPSData.mDatestamp);
     }
 
-    if (NO_ERROR == ret) {
-        const char* exif_orient =
-                ExifElementsTable::degreesToExifOrientation(mPictureRotation);
-
-        if (exif_orient) {
-           ret = exifTable->insertElement(TAG_ORIENTATION, exif_orient);
-        }
-    }
-
     // fill in short and ushort tags
     if (NO_ERROR == ret) {
         char temp_value[2];
         temp_value[1] = '\0';
 
-        // AWB
-        if (mParameters3A.WhiteBallance == OMX_WhiteBalControlAuto) {
-            temp_value[0] = '0';
-        } else {
-            temp_value[0] = '1';
-        }
-        exifTable->insertElement(TAG_WHITEBALANCE, temp_value);
-
         // MeteringMode
         // TODO(XXX): only supporting this metering mode at the moment, may change in future
         temp_value[0] = '2';
@@ -729,6 +694,81 @@ status_t OMXCameraAdapter::setupEXIF_libjpeg(ExifElementsTable* exifTable,
         exifTable->insertElement(TAG_CUSTOM_RENDERED, temp_value);
     }
 
+    if (NO_ERROR == ret) {
+        mEXIFTemplateWidth = capData->mWidth;
+        mEXIFTemplateHeight = capData->mHeight;
+        mEXIFTemplateValid = true;
+    } else {
+        CAMHAL_LOGEB("EXIF template incomplete: %d", ret);
+        mEXIFTemplateValid = false;
+    }
+
+    LOG_FUNCTION_NAME_EXIT;
+
+    return ret;
+}
+
+status_t OMXCameraAdapter::setupEXIF_libjpeg(ExifElementsTable* exifTable,
+                                             OMX_TI_ANCILLARYDATATYPE* pAncillaryData,
+                                             OMX_TI_WHITEBALANCERESULTTYPE* pWhiteBalanceData)
+{
+    status_t ret = NO_ERROR;
+    struct timeval sTv;
+    struct tm *pTime;
+    OMXCameraPortParameters * capData = NULL;
+
+    LOG_FUNCTION_NAME;
+
+    capData = &mCameraAdapterParameters.mCameraPortParams[mCameraAdapterParameters.mImagePortIndex];
+
+    // Tags coming from parameters are formatted once and copied for each shot
+    if ( !mEXIFTemplateValid ||
+         ( mEXIFTemplateWidth != capData->mWidth ) ||
+         ( mEXIFTemplateHeight != capData->mHeight ) ) {
+        ret = setupEXIFTemplate(capData);
+    }
+
+    exifTable->copyFrom(mEXIFTemplate);
+
+    if ((NO_ERROR == ret)) {
+        int status = gettimeofday (&sTv, NULL);
+        pTime = localtime (&sTv.tv_sec);
+        char temp_value[EXIF_DATE_TIME_SIZE + 1];
+        if ((0 == status) && (NULL != pTime)) {
+            snprintf(temp_value, EXIF_DATE_TIME_SIZE,
+                     "%04d:%02d:%02d %02d:%02d:%02d",
+                     pTime->tm_year + 1900,
+                     pTime->tm_mon + 1,
+                     pTime->tm_mday,
+                     pTime->tm_hour,
+                     pTime->tm_min,
+                     pTime->tm_sec );
+            ret = exifTable->insertElement(TAG_DATETIME, temp_value);
+        }
+     }
+
+    if (NO_ERROR == ret) {
+        const char* exif_orient =
+                ExifElementsTable::degreesToExifOrientation(mPictureRotation);
+
+        if (exif_orient) {
+           ret = exifTable->insertElement(TAG_ORIENTATION, exif_orient);
+        }
+    }
+
+    if (NO_ERROR == ret) {
+        char temp_value[2];
+        temp_value[1] = '\0';
+
+        // AWB
+        if (mParameters3A.WhiteBallance == OMX_WhiteBalControlAuto) {
+            temp_value[0] = '0';
+        } else {
+            temp_value[0] = '1';
+        }
+        exifTable->insertElement(TAG_WHITEBALANCE, temp_value);
+    }
+
     if (pAncillaryData && (NO_ERROR == ret)) {
         unsigned int numerator = 0, denominator = 0;
         char temp_value[256];
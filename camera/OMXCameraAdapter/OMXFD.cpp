@@ -197,7 +197,7 @@ status_t OMXCameraAdapter::setFaceDetection(bool enable, OMX_U32 orientation)
     return ret;
 }
 
-status_t OMXCameraAdapter::createPreviewMetadata(OMX_BUFFERHEADERTYPE* pBuffHeader,
+status_t OMXCameraAdapter::createPreviewMetadata(const ExtradataIndex &extradata,
                                           android::sp<CameraMetadataResult> &result,
                                           size_t previewWidth,
                                           size_t previewHeight)
@@ -214,16 +214,10 @@ status_t OMXCameraAdapter::createPreviewMetadata(OMX_BUFFERHEADERTYPE* pBuffHead
         return NO_INIT;
     }
 
-    if ( NULL == pBuffHeader ) {
-        CAMHAL_LOGEA("Invalid Buffer header");
-        return-EINVAL;
-    }
-
     if ( mFaceDetectionRunning && !mFaceDetectionPaused ) {
         OMX_OTHER_EXTRADATATYPE *extraData;
 
-        extraData = getExtradata(pBuffHeader->pPlatformPrivate,
-                                 (OMX_EXTRADATATYPE)OMX_FaceDetection);
+        extraData = extradata.find((OMX_EXTRADATATYPE)OMX_FaceDetection);
 
         if ( NULL != extraData ) {
             CAMHAL_LOGVB("Size = %d, sizeof = %d, eType = 0x%x, nDataSize= %d, nPortIndex = 0x%x, nVersion = 0x%x",
@@ -260,20 +254,19 @@ status_t OMXCameraAdapter::createPreviewMetadata(OMX_BUFFERHEADERTYPE* pBuffHead
         }
     }
 
-    result = new (std::nothrow) CameraMetadataResult;
+    result = mFaceMetadataPool.acquire();
     if(NULL == result.get()) {
         ret = NO_MEMORY;
         return ret;
     }
 
     //Encode face coordinates
-    faceRet = encodeFaceCoordinates(faceData, result->getMetadataResult()
-                                            , previewWidth, previewHeight);
+    faceRet = encodeFaceCoordinates(faceData, result.get(), previewWidth, previewHeight);
     if ((NO_ERROR == faceRet) || (NOT_ENOUGH_DATA == faceRet)) {
         // Ignore harmless errors (no error and no update) and go ahead and encode
         // the preview meta data
         metaRet = encodePreviewMetadata(result->getMetadataResult()
-                                        , pBuffHeader->pPlatformPrivate);
+                                        , extradata);
         if ( (NO_ERROR != metaRet) && (NOT_ENOUGH_DATA != metaRet) )  {
            // Some 'real' error occurred during preview meta data encod, clear metadata
            // result and return correct error code
@@ -298,93 +291,61 @@ status_t OMXCameraAdapter::createPreviewMetadata(OMX_BUFFERHEADERTYPE* pBuffHead
     return ret;
 }
 
+void OMXCameraAdapter::encodeFaceRect(OMX_S32 left, OMX_S32 top, OMX_S32 width, OMX_S32 height,
+                                      size_t previewWidth, size_t previewHeight, int32_t *rect)
+{
+    // Even rect entries are horizontal edges, odd ones vertical
+    static const OMX_S32 origin[2] = { CameraMetadataResult::LEFT, CameraMetadataResult::TOP };
+    static const OMX_S32 range[2] = { CameraMetadataResult::RIGHT - CameraMetadataResult::LEFT,
+                                      CameraMetadataResult::BOTTOM - CameraMetadataResult::TOP };
+    const OMX_S32 extent[2] = { ( OMX_S32 ) previewWidth, ( OMX_S32 ) previewHeight };
+    const OMX_S32 edge[4] = { left, top, left + width, top + height };
+
+    // Ducati names the corners after the face (left eye, top of hair) but
+    // reports them in frame coordinates, so a face seen upside down yields
+    // the same rectangle and mFaceOrientation needs no remapping here.
+    for ( int k = 0 ; k < 4 ; k++ ) {
+        const int axis = k & 1;
+        rect[k] = ( edge[k] * range[axis] + origin[axis] * extent[axis] ) / extent[axis];
+    }
+}
+
 status_t OMXCameraAdapter::encodeFaceCoordinates(const OMX_FACEDETECTIONTYPE *faceData,
-                                                 camera_frame_metadata_t *metadataResult,
+                                                 CameraMetadataResult *result,
                                                  size_t previewWidth,
                                                  size_t previewHeight)
 {
     status_t ret = NO_ERROR;
+    camera_frame_metadata_t *metadataResult = result->getMetadataResult();
     camera_face_t *faces;
-    size_t hRange, vRange;
-    double tmp;
+    size_t capacity;
     bool faceArrayChanged = false;
 
     LOG_FUNCTION_NAME;
 
-    hRange = CameraMetadataResult::RIGHT - CameraMetadataResult::LEFT;
-    vRange = CameraMetadataResult::BOTTOM - CameraMetadataResult::TOP;
-
     android::AutoMutex lock(mFaceDetectionLock);
 
-    // Avoid memory leak if called twice on same CameraMetadataResult
-    if ( (0 < metadataResult->number_of_faces) && (NULL != metadataResult->faces) ) {
-        free(metadataResult->faces);
-        metadataResult->number_of_faces = 0;
-        metadataResult->faces = NULL;
-    }
-
-    if ( (NULL != faceData) && (0 < faceData->ulFaceCount) ) {
-        int orient_mult;
-        int trans_left, trans_top, trans_right, trans_bot;
-
-        faces = ( camera_face_t * ) malloc(sizeof(camera_face_t)*faceData->ulFaceCount);
+    if ( (NULL != faceData) && (0 < faceData->ulFaceCount) &&
+         (0 < previewWidth) && (0 < previewHeight) ) {
+        faces = result->getFaceStorage();
+        capacity = result->getFaceCapacity();
         if ( NULL == faces ) {
-            ret = NO_MEMORY;
-            goto out;
+            capacity = faceData->ulFaceCount;
+            faces = ( camera_face_t * ) malloc(sizeof(camera_face_t)*capacity);
+            if ( NULL == faces ) {
+                ret = NO_MEMORY;
+                goto out;
+            }
         }
 
-        /**
-        / * When device is 180 degrees oriented to the sensor, need to translate
-        / * the output from Ducati to what Android expects
-        / * Ducati always gives face coordinates in this form, irrespective of
-        / * rotation, i.e (l,t) always represents the point towards the left eye
-        / * and top of hair.
-        / * (l, t)
-        / *   ---------------
-        / *   -   ,,,,,,,   -
-        / *   -  |       |  -
-        / *   -  |<a   <a|  -
-        / *   - (|   ^   |) -
-        / *   -  |  -=-  |  -
-        / *   -   \_____/   -
-        / *   ---------------
-        / *               (r, b)
-        / *
-        / * However, Android expects the coords to be in respect with what the
-        / * sensor is viewing, i.e Android expects sensor to see this with (l,t)
-        / * and (r,b) like so:
-        / * (l, t)
-        / *   ---------------
-        / *   -    _____    -
-        / *   -   /     \   -
-        / *   -  |  -=-  |  -
-        / *   - (|   ^   |) -
-        / *   -  |a>   a>|  -
-        / *   -  |       |  -
-        / *   -   ,,,,,,,   -
-        / *   ---------------
-        / *               (r, b)
-          */
-
-        if (mFaceOrientation == 180) {
-            orient_mult = -1;
-            trans_left = 2; // right is now left
-            trans_top = 3; // bottom is now top
-            trans_right = 0; // left is now right
-            trans_bot = 1; // top is not bottom
-        } else {
-            orient_mult = 1;
-            trans_left = 0; // left
-            trans_top = 1; // top
-            trans_right = 2; // right
-            trans_bot = 3; // bottom
+        // faceDetectionLastOutput only has room for this many
+        if ( MAX_NUM_FACES_SUPPORTED < capacity ) {
+            capacity = MAX_NUM_FACES_SUPPORTED;
         }
 
-        int j = 0, i = 0;
-        for ( ; j < faceData->ulFaceCount ; j++)
+        size_t i = 0;
+        for ( OMX_U32 j = 0 ; ( j < faceData->ulFaceCount ) && ( i < capacity ) ; j++ )
             {
-             OMX_S32 nLeft = 0;
-             OMX_S32 nTop = 0;
              //Face filtering
              //For real faces, it is seen that the h/w passes a score >=80
              //For false faces, we seem to get even a score of 70 sometimes.
@@ -393,34 +354,11 @@ status_t OMXCameraAdapter::encodeFaceCoordinates(const OMX_FACEDETECTIONTYPE *fa
             if(faceData->tFacePosition[j].nScore <= FACE_DETECTION_THRESHOLD)
              continue;
 
-            if (mFaceOrientation == 180) {
-                // from sensor pov, the left pos is the right corner of the face in pov of frame
-                nLeft = faceData->tFacePosition[j].nLeft + faceData->tFacePosition[j].nWidth;
-                nTop =  faceData->tFacePosition[j].nTop + faceData->tFacePosition[j].nHeight;
-            } else {
-                nLeft = faceData->tFacePosition[j].nLeft;
-                nTop =  faceData->tFacePosition[j].nTop;
-            }
-
-            tmp = ( double ) nLeft / ( double ) previewWidth;
-            tmp *= hRange;
-            tmp -= hRange/2;
-            faces[i].rect[trans_left] = tmp;
-
-            tmp = ( double ) nTop / ( double )previewHeight;
-            tmp *= vRange;
-            tmp -= vRange/2;
-            faces[i].rect[trans_top] = tmp;
-
-            tmp = ( double ) faceData->tFacePosition[j].nWidth / ( double ) previewWidth;
-            tmp *= hRange;
-            tmp *= orient_mult;
-            faces[i].rect[trans_right] = faces[i].rect[trans_left] + tmp;
-
-            tmp = ( double ) faceData->tFacePosition[j].nHeight / ( double ) previewHeight;
-            tmp *= vRange;
-            tmp *= orient_mult;
-            faces[i].rect[trans_bot] = faces[i].rect[trans_top] + tmp;
+            encodeFaceRect(faceData->tFacePosition[j].nLeft,
+                           faceData->tFacePosition[j].nTop,
+                           faceData->tFacePosition[j].nWidth,
+                           faceData->tFacePosition[j].nHeight,
+                           previewWidth, previewHeight, faces[i].rect);
 
             faces[i].score = faceData->tFacePosition[j].nScore;
             faces[i].id = 0;
@@ -439,22 +377,22 @@ status_t OMXCameraAdapter::encodeFaceCoordinates(const OMX_FACEDETECTIONTYPE *fa
         for (int i = 0; i  < metadataResult->number_of_faces; i++)
         {
             bool faceChanged = true;
-            int centerX = (faces[i].rect[trans_left] + faces[i].rect[trans_right] ) / 2;
-            int centerY = (faces[i].rect[trans_top] + faces[i].rect[trans_bot] ) / 2;
+            int centerX = (faces[i].rect[0] + faces[i].rect[2] ) / 2;
+            int centerY = (faces[i].rect[1] + faces[i].rect[3] ) / 2;
 
-            int sizeX = (faces[i].rect[trans_right] - faces[i].rect[trans_left] ) ;
-            int sizeY = (faces[i].rect[trans_bot] - faces[i].rect[trans_top] ) ;
+            int sizeX = (faces[i].rect[2] - faces[i].rect[0] ) ;
+            int sizeY = (faces[i].rect[3] - faces[i].rect[1] ) ;
 
             for (int j = 0; j < faceDetectionNumFacesLastOutput; j++)
             {
-                int tempCenterX = (faceDetectionLastOutput[j].rect[trans_left] +
-                                  faceDetectionLastOutput[j].rect[trans_right] ) / 2;
-                int tempCenterY = (faceDetectionLastOutput[j].rect[trans_top] +
-                                  faceDetectionLastOutput[j].rect[trans_bot] ) / 2;
-                int tempSizeX = (faceDetectionLastOutput[j].rect[trans_right] -
-                                faceDetectionLastOutput[j].rect[trans_left] ) ;
-                int tempSizeY = (faceDetectionLastOutput[j].rect[trans_bot] -
-                                faceDetectionLastOutput[j].rect[trans_top] ) ;
+                int tempCenterX = (faceDetectionLastOutput[j].rect[0] +
+                                  faceDetectionLastOutput[j].rect[2] ) / 2;
+                int tempCenterY = (faceDetectionLastOutput[j].rect[1] +
+                                  faceDetectionLastOutput[j].rect[3] ) / 2;
+                int tempSizeX = (faceDetectionLastOutput[j].rect[2] -
+                                faceDetectionLastOutput[j].rect[0] ) ;
+                int tempSizeY = (faceDetectionLastOutput[j].rect[3] -
+                                faceDetectionLastOutput[j].rect[1] ) ;
 
                 if ( ( tempCenterX == centerX) &&
                      ( tempCenterY == centerY) ) {
@@ -500,5 +438,33 @@ out:
     return ret;
 }
 
+OMXCameraAdapter::FaceMetadataPool::FaceMetadataPool()
+    : mNext(0)
+{
+    for ( size_t i = 0 ; i < POOL_SIZE ; i++ ) {
+        mResults[i] = new (std::nothrow) CameraMetadataResult(mFaces[i], MAX_NUM_FACES_SUPPORTED);
+    }
+}
+
+android::sp<CameraMetadataResult> OMXCameraAdapter::FaceMetadataPool::acquire()
+{
+    android::AutoMutex lock(mLock);
+
+    for ( size_t n = 0 ; n < POOL_SIZE ; n++ ) {
+        android::sp<CameraMetadataResult> &result = mResults[mNext];
+        mNext = ( mNext + 1 ) % POOL_SIZE;
+
+        // Subscribers still holding a result keep its slot busy
+        if ( ( NULL != result.get() ) && ( 1 == result->getStrongCount() ) ) {
+            result->reset();
+            return result;
+        }
+    }
+
+    CAMHAL_LOGDA("Face metadata pool exhausted, allocating");
+
+    return new (std::nothrow) CameraMetadataResult;
+}
+
 } // namespace Camera
 } // namespace Ti
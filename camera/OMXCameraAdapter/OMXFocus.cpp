@@ -40,7 +40,7 @@ status_t OMXCameraAdapter::setParametersFocus(const android::CameraParameters &p
 {
     status_t ret = NO_ERROR;
     const char *str = NULL;
-    android::Vector<android::sp<CameraArea> > tempAreas;
+    CameraAreas tempAreas;
     size_t MAX_FOCUS_AREAS;
 
     LOG_FUNCTION_NAME;
@@ -121,7 +121,7 @@ status_t OMXCameraAdapter::doAutoFocus()
     pauseFaceDetection(true);
 
     // This is needed for applying FOCUS_REGION correctly
-    if ( (!mFocusAreas.isEmpty()) && (!mFocusAreas.itemAt(0)->isZeroArea()))
+    if ( (!mFocusAreas.isEmpty()) && (!mFocusAreas[0].isZeroArea()))
     {
     //Disable face priority
     setAlgoPriority(FACE_PRIORITY, FOCUS_ALGO, false);
@@ -557,7 +557,7 @@ status_t OMXCameraAdapter::checkFocus(OMX_PARAM_FOCUSSTATUSTYPE *eFocusStatus)
     return ret;
 }
 
-status_t OMXCameraAdapter::updateFocusDistances(android::CameraParameters &params)
+status_t OMXCameraAdapter::updateFocusDistances(CameraHalParameters &params)
 {
     OMX_U32 focusNear, focusOptimal, focusFar;
     status_t ret = NO_ERROR;
@@ -661,7 +661,7 @@ status_t OMXCameraAdapter::encodeFocusDistance(OMX_U32 dist, char *buffer, size_
 status_t OMXCameraAdapter::addFocusDistances(OMX_U32 &near,
                                              OMX_U32 &optimal,
                                              OMX_U32 &far,
-                                             android::CameraParameters& params)
+                                             CameraHalParameters& params)
 {
     status_t ret = NO_ERROR;
 
@@ -713,10 +713,9 @@ status_t OMXCameraAdapter::setTouchFocus()
     status_t ret = NO_ERROR;
     OMX_ERRORTYPE eError = OMX_ErrorNone;
 
-    OMX_ALGOAREASTYPE *focusAreas;
+    OMX_ALGOAREASTYPE *focusAreas = NULL;
     OMX_TI_CONFIG_SHAREDBUFFER sharedBuffer;
     CameraBuffer *bufferlist;
-    int areasSize = 0;
 
     LOG_FUNCTION_NAME;
 
@@ -729,9 +728,13 @@ status_t OMXCameraAdapter::setTouchFocus()
     if ( NO_ERROR == ret )
         {
 
-        areasSize = ((sizeof(OMX_ALGOAREASTYPE)+4095)/4096)*4096;
-        bufferlist = mMemMgr.allocateBufferList(0, 0, NULL, areasSize, 1);
-        focusAreas = (OMX_ALGOAREASTYPE*) bufferlist[0].opaque;
+        android::AutoMutex areasLock(mAlgoAreasLock);
+
+        bufferlist = getAlgoAreasBuffer();
+        if ( NULL != bufferlist )
+            {
+            focusAreas = (OMX_ALGOAREASTYPE*) bufferlist[0].opaque;
+            }
 
         OMXCameraPortParameters * mPreviewData = NULL;
         mPreviewData = &mCameraAdapterParameters.mCameraPortParams[mCameraAdapterParameters.mPrevPortIndex];
@@ -751,7 +754,7 @@ status_t OMXCameraAdapter::setTouchFocus()
         // If the area is the special case of (0, 0, 0, 0, 0), then
         // the algorithm needs nNumAreas to be set to 0,
         // in order to automatically choose the best fitting areas.
-        if ( mFocusAreas.itemAt(0)->isZeroArea() )
+        if ( mFocusAreas[0].isZeroArea() )
             {
             focusAreas->nNumAreas = 0;
             }
@@ -768,7 +771,7 @@ status_t OMXCameraAdapter::setTouchFocus()
             }
 
             // transform the coordinates to 3A-type coordinates
-            mFocusAreas.itemAt(n)->transfrom((size_t)mPreviewData->mWidth/widthDivisor,
+            mFocusAreas[n].transfrom((size_t)mPreviewData->mWidth/widthDivisor,
                                             (size_t)mPreviewData->mHeight/heightDivisor,
                                             (size_t&)focusAreas->tAlgoAreas[n].nTop,
                                             (size_t&)focusAreas->tAlgoAreas[n].nLeft,
@@ -783,7 +786,7 @@ status_t OMXCameraAdapter::setTouchFocus()
                     ( focusAreas->tAlgoAreas[n].nWidth * TOUCH_FOCUS_RANGE ) / mPreviewData->mWidth;
             focusAreas->tAlgoAreas[n].nHeight =
                     ( focusAreas->tAlgoAreas[n].nHeight * TOUCH_FOCUS_RANGE ) / mPreviewData->mHeight;
-            focusAreas->tAlgoAreas[n].nPriority = mFocusAreas.itemAt(n)->getWeight();
+            focusAreas->tAlgoAreas[n].nPriority = mFocusAreas[n].getWeight();
 
              CAMHAL_LOGDB("Focus area %d : top = %d left = %d width = %d height = %d prio = %d",
                     n, (int)focusAreas->tAlgoAreas[n].nTop, (int)focusAreas->tAlgoAreas[n].nLeft,
@@ -794,29 +797,24 @@ status_t OMXCameraAdapter::setTouchFocus()
         OMX_INIT_STRUCT_PTR (&sharedBuffer, OMX_TI_CONFIG_SHAREDBUFFER);
 
         sharedBuffer.nPortIndex = OMX_ALL;
-        sharedBuffer.nSharedBuffSize = areasSize;
+        sharedBuffer.nSharedBuffSize = ALGO_AREAS_BUFFER_SIZE;
         sharedBuffer.pSharedBuff = (OMX_U8 *) camera_buffer_get_omx_ptr (&bufferlist[0]);
 
         if ( NULL == sharedBuffer.pSharedBuff )
             {
             CAMHAL_LOGEA("No resources to allocate OMX shared buffer");
             ret = -ENOMEM;
-            goto EXIT;
             }
-
+        else
+            {
             eError =  OMX_SetConfig(mCameraAdapterParameters.mHandleComp,
                                       (OMX_INDEXTYPE) OMX_TI_IndexConfigAlgoAreas, &sharedBuffer);
 
-        if ( OMX_ErrorNone != eError )
-            {
-            CAMHAL_LOGEB("Error while setting Focus Areas configuration 0x%x", eError);
-            ret = -EINVAL;
-            }
-
-    EXIT:
-        if (NULL != bufferlist)
-            {
-            mMemMgr.freeBufferList (bufferlist);
+            if ( OMX_ErrorNone != eError )
+                {
+                CAMHAL_LOGEB("Error while setting Focus Areas configuration 0x%x", eError);
+                ret = -EINVAL;
+                }
             }
         }
 
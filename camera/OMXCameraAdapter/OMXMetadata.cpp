@@ -32,7 +32,7 @@ namespace Ti {
 namespace Camera {
 
 #ifdef OMAP_ENHANCEMENT_CPCAM
-camera_memory_t * OMXCameraAdapter::getMetaData(const OMX_PTR plat_pvt,
+camera_memory_t * OMXCameraAdapter::getMetaData(const ExtradataIndex &extradata,
                                                 camera_request_memory allocator) const
 {
     camera_memory_t * ret = NULL;
@@ -47,23 +47,23 @@ camera_memory_t * OMXCameraAdapter::getMetaData(const OMX_PTR plat_pvt,
 
     size_t metaDataSize = sizeof(camera_metadata_t);
 
-    extraData = getExtradata(plat_pvt, (OMX_EXTRADATATYPE) OMX_FaceDetection);
+    extraData = extradata.find((OMX_EXTRADATATYPE) OMX_FaceDetection);
     if ( NULL != extraData ) {
         faceData = ( OMX_FACEDETECTIONTYPE * ) extraData->data;
         metaDataSize += faceData->ulFaceCount * sizeof(camera_metadata_face_t);
     }
 
-    extraData = getExtradata(plat_pvt, (OMX_EXTRADATATYPE) OMX_WhiteBalance);
+    extraData = extradata.find((OMX_EXTRADATATYPE) OMX_WhiteBalance);
     if ( NULL != extraData ) {
         WBdata = ( OMX_TI_WHITEBALANCERESULTTYPE * ) extraData->data;
     }
 
-    extraData = getExtradata(plat_pvt, (OMX_EXTRADATATYPE) OMX_TI_VectShotInfo);
+    extraData = extradata.find((OMX_EXTRADATATYPE) OMX_TI_VectShotInfo);
     if ( NULL != extraData ) {
         shotInfo = ( OMX_TI_VECTSHOTINFOTYPE * ) extraData->data;
     }
 
-    extraData = getExtradata(plat_pvt, (OMX_EXTRADATATYPE) OMX_TI_LSCTable);
+    extraData = extradata.find((OMX_EXTRADATATYPE) OMX_TI_LSCTable);
     if ( NULL != extraData ) {
         lscTbl = ( OMX_TI_LSCTABLETYPE * ) extraData->data;
         metaDataSize += OMX_TI_LSC_GAIN_TABLE_SIZE;
@@ -77,9 +77,12 @@ camera_memory_t * OMXCameraAdapter::getMetaData(const OMX_PTR plat_pvt,
         offset += sizeof(camera_metadata_t);
     }
 
-    if ( NULL != faceData ) {
+    const OMXCameraPortParameters &previewPort =
+        mCameraAdapterParameters.mCameraPortParams[mCameraAdapterParameters.mPrevPortIndex];
+    if ( ( NULL != faceData ) && ( 0 < previewPort.mWidth ) && ( 0 < previewPort.mHeight ) ) {
         metaData->number_of_faces = 0;
         int idx = 0;
+        int32_t rect[4];
         metaData->faces_offset = offset;
         struct camera_metadata_face *faces = reinterpret_cast<struct camera_metadata_face *> (static_cast<char*>(ret->data) + offset);
         for ( int j = 0; j < faceData->ulFaceCount ; j++ ) {
@@ -88,11 +91,16 @@ camera_memory_t * OMXCameraAdapter::getMetaData(const OMX_PTR plat_pvt,
             }
             idx = metaData->number_of_faces;
             metaData->number_of_faces++;
-            // TODO: Rework and re-use encodeFaceCoordinates()
-            faces[idx].left  = faceData->tFacePosition[j].nLeft;
-            faces[idx].top = faceData->tFacePosition[j].nTop;
-            faces[idx].bottom = faceData->tFacePosition[j].nWidth;
-            faces[idx].right = faceData->tFacePosition[j].nHeight;
+            // Same coordinate space as the preview face callbacks
+            encodeFaceRect(faceData->tFacePosition[j].nLeft,
+                           faceData->tFacePosition[j].nTop,
+                           faceData->tFacePosition[j].nWidth,
+                           faceData->tFacePosition[j].nHeight,
+                           previewPort.mWidth, previewPort.mHeight, rect);
+            faces[idx].left = rect[0];
+            faces[idx].top = rect[1];
+            faces[idx].right = rect[2];
+            faces[idx].bottom = rect[3];
         }
         offset += sizeof(camera_metadata_face_t) * metaData->number_of_faces;
     }
@@ -141,13 +149,13 @@ camera_memory_t * OMXCameraAdapter::getMetaData(const OMX_PTR plat_pvt,
 }
 #endif
 
-status_t OMXCameraAdapter::encodePreviewMetadata(camera_frame_metadata_t *meta, const OMX_PTR plat_pvt)
+status_t OMXCameraAdapter::encodePreviewMetadata(camera_frame_metadata_t *meta, const ExtradataIndex &extradata)
 {
     status_t ret = NO_ERROR;
 #ifdef OMAP_ENHANCEMENT_CPCAM
     OMX_OTHER_EXTRADATATYPE *extraData = NULL;
 
-    extraData = getExtradata(plat_pvt, (OMX_EXTRADATATYPE) OMX_TI_VectShotInfo);
+    extraData = extradata.find((OMX_EXTRADATATYPE) OMX_TI_VectShotInfo);
 
     if ( (NULL != extraData) && (NULL != extraData->data) ) {
         OMX_TI_VECTSHOTINFOTYPE *shotInfo;
@@ -171,7 +179,7 @@ status_t OMXCameraAdapter::encodePreviewMetadata(camera_frame_metadata_t *meta,
 #else
     // no-op in non enhancement mode
     CAMHAL_UNUSED(meta);
-    CAMHAL_UNUSED(plat_pvt);
+    CAMHAL_UNUSED(extradata);
 #endif
 
     return ret;
@@ -227,9 +227,9 @@ status_t OMXCameraAdapter::UseBuffersReprocess(CameraBuffer *bufArr, int num)
 
     CAMHAL_ASSERT(num > 0);
 
-    if (mAdapterState == REPROCESS_STATE) {
+    if (getState() == REPROCESS_STATE) {
         stopReprocess();
-    } else if (mAdapterState == CAPTURE_STATE) {
+    } else if (getState() == CAPTURE_STATE) {
         stopImageCapture();
         stopReprocess();
     }
@@ -243,7 +243,7 @@ status_t OMXCameraAdapter::UseBuffersReprocess(CameraBuffer *bufArr, int num)
     portData->mNumBufs = num;
 
     // Configure
-    ret = setParametersReprocess(mParams, bufArr, mAdapterState);
+    ret = setParametersReprocess(mParams, bufArr, getState());
 
     if (mReprocConfigured) {
         if (mPendingReprocessSettings & ECaptureParamSettings) {
@@ -23,6 +23,7 @@
 
 #include "CameraHal.h"
 #include "OMXCameraAdapter.h"
+#include <math.h>
 
 #ifdef CAMERAHAL_TUNA
 namespace {
@@ -181,58 +182,57 @@ status_t OMXCameraAdapter::advanceZoom()
         }
     else if ( mCurrentZoomIdx != mTargetZoomIdx )
         {
+        unsigned int nextZoomIdx;
+
         if ( ZOOM_ACTIVE & state )
             {
-            if ( mCurrentZoomIdx < mTargetZoomIdx )
-                {
-                mZoomInc = 1;
-                }
-            else
-                {
-                mZoomInc = -1;
-                }
-
-            mCurrentZoomIdx += mZoomInc;
+            nextZoomIdx = getSmoothZoomIdx(systemTime());
             }
         else
             {
-            mCurrentZoomIdx = mTargetZoomIdx;
+            nextZoomIdx = mTargetZoomIdx;
             }
 
-        ret = doZoom(mCurrentZoomIdx);
-
-        if ( ZOOM_ACTIVE & state )
+        // Frames arriving before the trajectory moves on issue no config,
+        // late ones skip the steps they missed
+        if ( nextZoomIdx != mCurrentZoomIdx )
             {
-            if ( mCurrentZoomIdx == mTargetZoomIdx )
-                {
-                CAMHAL_LOGDB("[Goal Reached] Smooth Zoom notify currentIdx = %d, targetIdx = %d",
-                             mCurrentZoomIdx,
-                             mTargetZoomIdx);
+            mCurrentZoomIdx = nextZoomIdx;
+            ret = doZoom(mCurrentZoomIdx);
 
-                if ( NO_ERROR == ret )
+            if ( ZOOM_ACTIVE & state )
+                {
+                if ( mCurrentZoomIdx == mTargetZoomIdx )
                     {
-
-                    ret =  BaseCameraAdapter::setState(CAMERA_STOP_SMOOTH_ZOOM);
+                    CAMHAL_LOGDB("[Goal Reached] Smooth Zoom notify currentIdx = %d, targetIdx = %d",
+                                 mCurrentZoomIdx,
+                                 mTargetZoomIdx);
 
                     if ( NO_ERROR == ret )
                         {
-                        ret = BaseCameraAdapter::commitState();
-                        }
-                    else
-                        {
-                        ret |= BaseCameraAdapter::rollbackState();
-                        }
 
+                        ret =  BaseCameraAdapter::setState(CAMERA_STOP_SMOOTH_ZOOM);
+
+                        if ( NO_ERROR == ret )
+                            {
+                            ret = BaseCameraAdapter::commitState();
+                            }
+                        else
+                            {
+                            ret |= BaseCameraAdapter::rollbackState();
+                            }
+
+                        }
+                    mReturnZoomStatus = false;
+                    notifyZoomSubscribers(mCurrentZoomIdx, true);
+                    }
+                else
+                    {
+                    CAMHAL_LOGDB("[Advancing] Smooth Zoom notify currentIdx = %d, targetIdx = %d",
+                                 mCurrentZoomIdx,
+                                 mTargetZoomIdx);
+                    notifyZoomSubscribers(mCurrentZoomIdx, false);
                     }
-                mReturnZoomStatus = false;
-                notifyZoomSubscribers(mCurrentZoomIdx, true);
-                }
-            else
-                {
-                CAMHAL_LOGDB("[Advancing] Smooth Zoom notify currentIdx = %d, targetIdx = %d",
-                             mCurrentZoomIdx,
-                             mTargetZoomIdx);
-                notifyZoomSubscribers(mCurrentZoomIdx, false);
                 }
             }
         }
@@ -263,6 +263,24 @@ status_t OMXCameraAdapter::advanceZoom()
     return ret;
 }
 
+unsigned int OMXCameraAdapter::getSmoothZoomIdx(nsecs_t now) const
+{
+    const int distance = (int) mTargetZoomIdx - (int) mSmoothZoomStartIdx;
+    const nsecs_t duration = abs(distance) * mSmoothZoomStepTime;
+    const nsecs_t elapsed = now - mSmoothZoomStartTime;
+
+    if ( ( 0 >= duration ) || ( elapsed >= duration ) )
+        {
+        return mTargetZoomIdx;
+        }
+
+    // Smoothstep easing, the same zoom speed whatever the frame rate
+    const double t = (double) elapsed / (double) duration;
+    const double eased = t * t * ( 3.0 - 2.0 * t );
+
+    return mSmoothZoomStartIdx + (int) floor(distance * eased + 0.5);
+}
+
 status_t OMXCameraAdapter::startSmoothZoom(int targetIdx)
 {
     status_t ret = NO_ERROR;
@@ -279,6 +297,9 @@ status_t OMXCameraAdapter::startSmoothZoom(int targetIdx)
         mTargetZoomIdx = targetIdx;
         mZoomParameterIdx = mCurrentZoomIdx;
         mReturnZoomStatus = false;
+        mZoomInc = ( mCurrentZoomIdx <= mTargetZoomIdx ) ? 1 : -1;
+        mSmoothZoomStartIdx = mCurrentZoomIdx;
+        mSmoothZoomStartTime = systemTime();
     } else {
         CAMHAL_LOGEB("Smooth value out of range %d!", targetIdx);
         ret = -EINVAL;
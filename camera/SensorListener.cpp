@@ -23,6 +23,7 @@
 
 #include "SensorListener.h"
 
+#include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
 #include <sys/types.h>
@@ -33,9 +34,17 @@ namespace Camera {
 /*** static declarations ***/
 static const float RADIANS_2_DEG = (float) (180 / M_PI);
 // measured values on device...might need tuning
-static const int DEGREES_90_THRESH = 50;
-static const int DEGREES_180_THRESH = 170;
-static const int DEGREES_270_THRESH = 250;
+static const float FILTER_ALPHA = 0.4f;
+// below this the device is close to free fall and the direction is noise
+static const float MIN_GRAVITY = 1.0f;
+// beyond this the device lies too flat for the orientation to be reliable
+static const int DEGREES_TILT_IGNORE = 45;
+// how far past the 45 degree boundary the angle must go to leave a quadrant
+static const int DEGREES_HYSTERESIS = 15;
+static const int DEBOUNCE_EVENTS = 3;
+static const int STABLE_EVENTS = 20;
+static const int ACTIVE_EVENT_RATE_MS = 100;
+static const int IDLE_EVENT_RATE_MS = 400;
 
 static int sensor_events_listener(int fd, int events, void* data)
 {
@@ -45,38 +54,14 @@ static int sensor_events_listener(int fd, int events, void* data)
     while ((num_sensors = listener->mSensorEventQueue->read(sen_events, 8)) > 0) {
         for (int i = 0; i < num_sensors; i++) {
             if (sen_events[i].type == android::Sensor::TYPE_ACCELEROMETER) {
-                float x = sen_events[i].vector.azimuth;
-                float y = sen_events[i].vector.pitch;
-                float z = sen_events[i].vector.roll;
-                float radius = 0;
-                int tilt = 0, orient = 0;
-
                 CAMHAL_LOGVA("ACCELEROMETER EVENT");
                 CAMHAL_LOGVB(" azimuth = %f pitch = %f roll = %f",
                              sen_events[i].vector.azimuth,
                              sen_events[i].vector.pitch,
                              sen_events[i].vector.roll);
-                // see http://en.wikipedia.org/wiki/Spherical_coordinate_system#Cartesian_coordinates
-                // about conversion from cartesian to spherical for orientation calculations
-                radius = (float) sqrt(x * x + y * y + z * z);
-                tilt = (int) asinf(z / radius) * RADIANS_2_DEG;
-                orient = (int) atan2f(-x, y) * RADIANS_2_DEG;
-
-                if (orient < 0) {
-                    orient += 360;
-                }
-
-                if (orient >= DEGREES_270_THRESH) {
-                    orient = 270;
-                } else if (orient >= DEGREES_180_THRESH) {
-                    orient = 180;
-                } else if (orient >= DEGREES_90_THRESH) {
-                    orient = 90;
-                } else {
-                    orient = 0;
-                }
-                listener->handleOrientation(orient, tilt);
-                CAMHAL_LOGVB(" tilt = %d orientation = %d", tilt, orient);
+                listener->handleAccelerometer(sen_events[i].vector.azimuth,
+                                              sen_events[i].vector.pitch,
+                                              sen_events[i].vector.roll);
             } else if (sen_events[i].type == android::Sensor::TYPE_GYROSCOPE) {
                 CAMHAL_LOGVA("GYROSCOPE EVENT");
             }
@@ -98,6 +83,8 @@ SensorListener::SensorListener() {
     mOrientationCb = NULL;
     mSensorEventQueue = NULL;
     mSensorLooperThread = NULL;
+    mAccelerometer = NULL;
+    resetOrientation();
 
     LOG_FUNCTION_NAME_EXIT;
 }
@@ -195,6 +182,113 @@ void SensorListener::handleOrientation(uint32_t orientation, uint32_t tilt) {
     LOG_FUNCTION_NAME_EXIT;
 }
 
+void SensorListener::handleAccelerometer(float x, float y, float z) {
+    int orientation = 0;
+    int tilt = 0;
+    bool settled = false;
+
+    {
+        android::AutoMutex lock(&mLock);
+
+        if (!(sensorsEnabled & SENSOR_ORIENTATION)) {
+            return;
+        }
+
+        // low-pass the gravity vector so hand shake doesn't move the angle
+        if (!mFilterPrimed) {
+            mGravity[0] = x;
+            mGravity[1] = y;
+            mGravity[2] = z;
+            mFilterPrimed = true;
+        } else {
+            mGravity[0] += FILTER_ALPHA * (x - mGravity[0]);
+            mGravity[1] += FILTER_ALPHA * (y - mGravity[1]);
+            mGravity[2] += FILTER_ALPHA * (z - mGravity[2]);
+        }
+
+        // see http://en.wikipedia.org/wiki/Spherical_coordinate_system#Cartesian_coordinates
+        // about conversion from cartesian to spherical for orientation calculations
+        const float radius = sqrtf(mGravity[0] * mGravity[0] +
+                                   mGravity[1] * mGravity[1] +
+                                   mGravity[2] * mGravity[2]);
+        if (radius < MIN_GRAVITY) {
+            return;
+        }
+
+        tilt = abs((int) (asinf(mGravity[2] / radius) * RADIANS_2_DEG));
+        if (tilt > DEGREES_TILT_IGNORE) {
+            mCandidateCount = 0;
+            return;
+        }
+
+        int angle = (int) (atan2f(-mGravity[0], mGravity[1]) * RADIANS_2_DEG);
+        if (angle < 0) {
+            angle += 360;
+        }
+
+        orientation = quantizeOrientation(angle);
+        CAMHAL_LOGVB(" tilt = %d angle = %d orientation = %d", tilt, angle, orientation);
+
+        if (orientation == mOrientation) {
+            mCandidateCount = 0;
+            if (++mStableCount == STABLE_EVENTS) {
+                setEventRate(IDLE_EVENT_RATE_MS);
+            }
+            return;
+        }
+
+        // the device is moving, sample at the full rate until it settles
+        if (mStableCount >= STABLE_EVENTS) {
+            setEventRate(ACTIVE_EVENT_RATE_MS);
+        }
+        mStableCount = 0;
+
+        if (orientation != mCandidate) {
+            mCandidate = orientation;
+            mCandidateCount = 0;
+        }
+
+        if (++mCandidateCount >= DEBOUNCE_EVENTS) {
+            mOrientation = orientation;
+            mCandidateCount = 0;
+            settled = true;
+        }
+    }
+
+    if (settled) {
+        handleOrientation(orientation, tilt);
+    }
+}
+
+int SensorListener::quantizeOrientation(int angle) const {
+    if (mOrientation >= 0) {
+        int delta = abs(angle - mOrientation);
+        if (delta > 180) {
+            delta = 360 - delta;
+        }
+        if (delta <= 45 + DEGREES_HYSTERESIS) {
+            return mOrientation;
+        }
+    }
+
+    return (((angle + 45) / 90) % 4) * 90;
+}
+
+void SensorListener::resetOrientation() {
+    mFilterPrimed = false;
+    mOrientation = -1;
+    mCandidate = -1;
+    mCandidateCount = 0;
+    mStableCount = 0;
+}
+
+void SensorListener::setEventRate(int rateMs) {
+    if (mAccelerometer) {
+        CAMHAL_LOGDB("orientation event rate %d ms", rateMs);
+        mSensorEventQueue->setEventRate(mAccelerometer, ms2ns(rateMs));
+    }
+}
+
 void SensorListener::enableSensor(sensor_type_t type) {
     android::Sensor const* sensor;
 #ifdef ANDROID_API_MM_OR_LATER
@@ -212,7 +306,9 @@ void SensorListener::enableSensor(sensor_type_t type) {
         if(sensor) {
             CAMHAL_LOGDB("orientation = %p (%s)", sensor, sensor->getName().string());
             mSensorEventQueue->enableSensor(sensor);
-            mSensorEventQueue->setEventRate(sensor, ms2ns(100));
+            mAccelerometer = sensor;
+            resetOrientation();
+            setEventRate(ACTIVE_EVENT_RATE_MS);
             sensorsEnabled |= SENSOR_ORIENTATION;
         } else {
             CAMHAL_LOGDB("not enabling absent orientation sensor");
@@ -238,6 +334,7 @@ void SensorListener::disableSensor(sensor_type_t type) {
         sensor = mgr.getDefaultSensor(android::Sensor::TYPE_ACCELEROMETER);
         CAMHAL_LOGDB("orientation = %p (%s)", sensor, sensor->getName().string());
         mSensorEventQueue->disableSensor(sensor);
+        mAccelerometer = NULL;
         sensorsEnabled &= ~SENSOR_ORIENTATION;
     }
 
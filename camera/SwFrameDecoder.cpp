@@ -17,67 +17,208 @@
 #include "Common.h"
 #include "SwFrameDecoder.h"
 
+#include <cutils/properties.h>
+
 namespace Ti {
 namespace Camera {
 
 SwFrameDecoder::SwFrameDecoder()
-: mjpegWithHdrSize(0), mJpegWithHeaderBuffer(NULL) {
+: mThreadCount(1), mJobSequence(0), mPublishSequence(0), mExiting(false) {
+    char value[PROPERTY_VALUE_MAX];
+
+    property_get("camera.v4l.decoder.threads", value, "2");
+    mThreadCount = atoi(value);
+    if (mThreadCount < 1) {
+        mThreadCount = 1;
+    } else if (mThreadCount > MAX_DECODE_THREADS) {
+        mThreadCount = MAX_DECODE_THREADS;
+    }
 }
 
 SwFrameDecoder::~SwFrameDecoder() {
-    delete [] mJpegWithHeaderBuffer;
-    mJpegWithHeaderBuffer = NULL;
+    doStop();
 }
 
 
 void SwFrameDecoder::doConfigure(const DecoderParameters& params) {
     LOG_FUNCTION_NAME;
 
-    mjpegWithHdrSize = (mParams.width * mParams.height / 2) +
-            mJpgdecoder.readDHTSize();
-    if (mJpegWithHeaderBuffer != NULL) {
-        delete [] mJpegWithHeaderBuffer;
-        mJpegWithHeaderBuffer = NULL;
+    CAMHAL_LOGD("MJPEG %dx%d will be decoded by %d threads", params.width, params.height, mThreadCount);
+
+    LOG_FUNCTION_NAME_EXIT;
+}
+
+status_t SwFrameDecoder::doStart() {
+    LOG_FUNCTION_NAME;
+
+    {
+        android::AutoMutex lock(mJobLock);
+        mJobs.clear();
+        mJobSequence = 0;
+        mPublishSequence = 0;
+        mExiting = false;
+    }
+
+    for (int i = 0; i < mThreadCount; i++) {
+        android::sp<DecodeThread> thread = new DecodeThread(this);
+        status_t ret = thread->run("SwFrameDecoder", android::PRIORITY_URGENT_DISPLAY);
+        if (ret != NO_ERROR) {
+            CAMHAL_LOGE("Couldn't run decode thread %d", i);
+            doStop();
+            return ret;
+        }
+        mThreads.push_back(thread);
+    }
+
+    LOG_FUNCTION_NAME_EXIT;
+    return NO_ERROR;
+}
+
+void SwFrameDecoder::doStop() {
+    LOG_FUNCTION_NAME;
+
+    {
+        android::AutoMutex lock(mJobLock);
+        mExiting = true;
+        mJobCondition.broadcast();
+        mPublishCondition.broadcast();
+    }
+
+    for (size_t i = 0; i < mThreads.size(); i++) {
+        mThreads.editItemAt(i)->requestExitAndWait();
+    }
+    mThreads.clear();
+
+    {
+        android::AutoMutex lock(mJobLock);
+        mJobs.clear();
     }
-    mJpegWithHeaderBuffer = new unsigned char[mjpegWithHdrSize];
 
     LOG_FUNCTION_NAME_EXIT;
 }
 
+void SwFrameDecoder::doFlush() {
+    android::AutoMutex lock(mJobLock);
+    mJobs.clear();
+}
+
 
 void SwFrameDecoder::doProcessInputBuffer() {
     LOG_FUNCTION_NAME;
+
+    DecodeJob job;
+    job.inIndex = mInQueue.itemAt(mInQueue.size() - 1);
+    job.outIndex = -1;
+
+    // The picked output buffer moves to the tail of mOutQueue, so buffers
+    // being decoded or filled sit there in job sequence order. Jobs are also
+    // published in sequence, hence dequeueOutputBuffer(), which scans from
+    // the head, returns frames strictly in capture order, including when a
+    // buffer given back by a failed decode is picked again.
+    for (size_t i = 0; i < mOutQueue.size(); i++) {
+        int index = mOutQueue[i];
+        android::sp<MediaBuffer>& outBuffer = mOutBuffers->editItemAt(index);
+        android::AutoMutex lock(outBuffer->getLock());
+        if (outBuffer->getStatus() == BufferStatus_OutQueued) {
+            outBuffer->setStatus(BufferStatus_OutWaitForFill);
+            job.outIndex = index;
+            mOutQueue.removeAt(i);
+            mOutQueue.push_back(index);
+            break;
+        }
+    }
+
+    {
+        android::sp<MediaBuffer>& inBuffer = mInBuffers->editItemAt(job.inIndex);
+        android::AutoMutex lock(inBuffer->getLock());
+        if (job.outIndex < 0) {
+            // All output buffers are being decoded or held by clients
+            CAMHAL_LOGD("No output buffer available, dropping MJPEG frame %d", job.inIndex);
+            inBuffer->setStatus(BufferStatus_InDecoded);
+            return;
+        }
+        inBuffer->setStatus(BufferStatus_InWaitForEmpty);
+    }
+
+    {
+        android::AutoMutex lock(mJobLock);
+        job.sequence = mJobSequence++;
+        mJobs.push_back(job);
+        mJobCondition.signal();
+    }
+
+    LOG_FUNCTION_NAME_EXIT;
+}
+
+bool SwFrameDecoder::decodeNextFrame(Decoder_libjpeg& jpgdecoder) {
+    DecodeJob job;
+
+    {
+        android::AutoMutex lock(mJobLock);
+        while (mJobs.isEmpty() && !mExiting) {
+            mJobCondition.wait(mJobLock);
+        }
+        if (mExiting) {
+            return false;
+        }
+        job = mJobs.itemAt(0);
+        mJobs.removeAt(0);
+    }
+
+    android::sp<MediaBuffer> inBuffer = mInBuffers->itemAt(job.inIndex);
+    android::sp<MediaBuffer> outBuffer = mOutBuffers->itemAt(job.outIndex);
+    unsigned char* jpeg = NULL;
+    int jpegSize = 0;
     nsecs_t timestamp = 0;
 
-    CAMHAL_LOGV("Will add header to MJPEG");
-    int final_jpg_sz = 0;
     {
-        int inIndex = mInQueue.itemAt(0);
-        android::sp<MediaBuffer>& inBuffer = mInBuffers->editItemAt(inIndex);
         android::AutoMutex lock(inBuffer->getLock());
+        jpeg = reinterpret_cast<unsigned char*>(inBuffer->buffer);
+        jpegSize = inBuffer->filledLen;
         timestamp = inBuffer->getTimestamp();
-        final_jpg_sz = mJpgdecoder.appendDHT(
-                reinterpret_cast<unsigned char*>(inBuffer->buffer),
-                inBuffer->filledLen, mJpegWithHeaderBuffer, mjpegWithHdrSize);
+    }
+
+    // No buffer lock is held while decoding, the WaitFor* states keep both
+    // buffers away from the adapter until the job is done
+    CameraBuffer* buffer = reinterpret_cast<CameraBuffer*>(outBuffer->buffer);
+    bool decoded = jpgdecoder.decode(jpeg, jpegSize,
+            reinterpret_cast<unsigned char*>(buffer->mapped), 4096, true);
+    if (!decoded) {
+        CAMHAL_LOGEA("Error while decoding JPEG");
+    }
+
+    {
+        android::AutoMutex lock(inBuffer->getLock());
         inBuffer->setStatus(BufferStatus_InDecoded);
     }
-    CAMHAL_LOGV("Added header to MJPEG");
+
     {
-        int outIndex = mOutQueue.itemAt(0);
-        android::sp<MediaBuffer>& outBuffer = mOutBuffers->editItemAt(outIndex);
         android::AutoMutex lock(outBuffer->getLock());
-        CameraBuffer* buffer = reinterpret_cast<CameraBuffer*>(outBuffer->buffer);
-        if (!mJpgdecoder.decode(mJpegWithHeaderBuffer, final_jpg_sz,
-                reinterpret_cast<unsigned char*>(buffer->mapped), 4096)) {
-            CAMHAL_LOGEA("Error while decoding JPEG");
-            return;
-        }
         outBuffer->setTimestamp(timestamp);
-        outBuffer->setStatus(BufferStatus_OutFilled);
     }
+
+    publishFrame(job, decoded);
     CAMHAL_LOGV("JPEG decoded!");
 
-    LOG_FUNCTION_NAME_EXIT;
+    return true;
+}
+
+void SwFrameDecoder::publishFrame(const DecodeJob& job, bool decoded) {
+    android::AutoMutex lock(mJobLock);
+
+    while ((job.sequence != mPublishSequence) && !mExiting) {
+        mPublishCondition.wait(mJobLock);
+    }
+
+    {
+        android::sp<MediaBuffer>& outBuffer = mOutBuffers->editItemAt(job.outIndex);
+        android::AutoMutex bufferLock(outBuffer->getLock());
+        // A frame that failed to decode gives its buffer back for the next one
+        outBuffer->setStatus(decoded ? BufferStatus_OutFilled : BufferStatus_OutQueued);
+    }
+
+    mPublishSequence++;
+    mPublishCondition.broadcast();
 }
 
 
@@ -33,6 +33,8 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/select.h>
@@ -55,8 +57,6 @@ namespace Camera {
 
 //Proto Types
 static void convertYUV422i_yuyvTouyvy(uint8_t *src, uint8_t *dest, size_t size );
-static void convertYUV422ToNV12Tiler(unsigned char *src, unsigned char *dest, int width, int height );
-static void convertYUV422ToNV12(unsigned char *src, unsigned char *dest, int width, int height );
 
 android::Mutex gV4LAdapterLock;
 char device[15];
@@ -208,7 +208,11 @@ status_t V4LCameraAdapter::v4lStartStreaming () {
             CAMHAL_LOGEB("StartStreaming: Unable to start capture: %s", strerror(errno));
             return ret;
         }
+
+        android::AutoMutex pendingLock(mPendingQBufLock);
         mVideoInfo->isStreaming = true;
+        mDequeueStopped = false;
+        mFailedQBufs = 0;
     }
 
     // This is WA for some cameras with incorrect driver behavior
@@ -236,12 +240,19 @@ status_t V4LCameraAdapter::v4lStopStreaming (int nBufferCount) {
     if (mVideoInfo->isStreaming) {
         bufType = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
+        // From here on returned buffers belong to a set that is going away,
+        // returnBufferToV4L() drops them instead of queueing them again
+        {
+            android::AutoMutex pendingLock(mPendingQBufLock);
+            mVideoInfo->isStreaming = false;
+            mPendingQBufs.clear();
+        }
+
         ret = v4lIoctl (mCameraHandle, VIDIOC_STREAMOFF, &bufType);
         if (ret != 0) {
             CAMHAL_LOGEB("StopStreaming: Unable to stop capture: %s", strerror(errno));
             return ret;
         }
-        mVideoInfo->isStreaming = false;
 
         /* Unmap buffers */
         mVideoInfo->buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -297,6 +308,14 @@ status_t V4LCameraAdapter::v4lSetFormat (int width, int height, uint32_t pix_for
     }
     v4lIoctl(mCameraHandle, VIDIOC_G_FMT, &mVideoInfo->format);
     CAMHAL_LOGDB("VIDIOC_G_FMT : WxH = %dx%d", mVideoInfo->format.fmt.pix.width, mVideoInfo->format.fmt.pix.height);
+    if ((int) mVideoInfo->format.fmt.pix.width != width ||
+        (int) mVideoInfo->format.fmt.pix.height != height ||
+        mVideoInfo->format.fmt.pix.pixelformat != pix_format) {
+        CAMHAL_LOGEB("VIDIOC_S_FMT returned %dx%d 0x%x instead of %dx%d 0x%x",
+                     mVideoInfo->format.fmt.pix.width, mVideoInfo->format.fmt.pix.height,
+                     mVideoInfo->format.fmt.pix.pixelformat, width, height, pix_format);
+        return BAD_VALUE;
+    }
     CAMHAL_LOGD("### Using: WxH = %dx%d  pixelformat=0x%x  ", mVideoInfo->format.fmt.pix.width, mVideoInfo->format.fmt.pix.height, mVideoInfo->format.fmt.pix.pixelformat);
     CAMHAL_LOGD("### Using: bytesperline=%d sizeimage=%d colorspace=0x%x", mVideoInfo->format.fmt.pix.bytesperline, mVideoInfo->format.fmt.pix.sizeimage, mVideoInfo->format.fmt.pix.colorspace);
     LOG_FUNCTION_NAME_EXIT;
@@ -328,13 +347,7 @@ status_t V4LCameraAdapter::restartPreview ()
     }
 
     for (int i = 0; i < mPreviewBufferCountQueueable; i++) {
-
-        v4l2_buffer buf;
-        buf.index = i;
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-
-        ret = v4lIoctl(mCameraHandle, VIDIOC_QBUF, &buf);
+        ret = queueBufferToV4L(i);
         if (ret < 0) {
             CAMHAL_LOGEA("VIDIOC_QBUF Failed");
             goto EXIT;
@@ -384,6 +397,12 @@ status_t V4LCameraAdapter::initialize(CameraProperties::Properties* caps)
         goto EXIT;
     }
 
+    if ((mEventFd = eventfd(0, EFD_NONBLOCK)) == -1) {
+        CAMHAL_LOGEB("Error while creating dequeue eventfd: %s", strerror(errno));
+        ret = NO_INIT;
+        goto EXIT;
+    }
+
     ret = v4lIoctl (mCameraHandle, VIDIOC_QUERYCAP, &mVideoInfo->cap);
     if (ret < 0) {
         CAMHAL_LOGEA("Error when querying the capabilities of the V4L Camera");
@@ -469,12 +488,8 @@ status_t V4LCameraAdapter::fillThisBuffer(CameraBuffer *frameBuf, CameraFrame::F
         }
 
     } else {
-        v4l2_buffer buf;
-        buf.index = idx;
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
         CAMHAL_LOGD("Will return buffer to V4L with id=%d", idx);
-        ret = v4lIoctl(mCameraHandle, VIDIOC_QBUF, &buf);
+        ret = returnBufferToV4L(idx);
         if (ret < 0) {
            CAMHAL_LOGEA("VIDIOC_QBUF Failed");
            goto EXIT;
@@ -544,7 +559,7 @@ EXIT:
 }
 
 
-void V4LCameraAdapter::getParameters(android::CameraParameters& params)
+void V4LCameraAdapter::getParameters(CameraHalParameters& params)
 {
     LOG_FUNCTION_NAME;
 
@@ -684,23 +699,12 @@ status_t V4LCameraAdapter::takePicture() {
         return BAD_VALUE;
     }
 
-    mPreviewing = false;
-    mLock.unlock();
-
-    {
-        android::AutoMutex stopLock(mStopLock);
-        CAMHAL_LOGW("Wait till preview stops");
-        ret = mStopCondition.waitRelative(mStopLock, 100000000);
-        if (ret != NO_ERROR) {
-            CAMHAL_LOGW("Timeout waiting for preview stop");
-        }
-    }
+    parkPreviewThread();
 
     if (isNeedToUseDecoder()) {
         mDecoder->stop();
         mDecoder->flush();
     }
-    mLock.lock();
     mCapturing = true;
     mPreviewing = false;
 
@@ -862,8 +866,6 @@ status_t V4LCameraAdapter::startPreview()
     }
 
     for (int i = 0; i < mPreviewBufferCountQueueable; i++) {
-        v4l2_buffer buf;
-
         memset (&mVideoInfo->buf, 0, sizeof (struct v4l2_buffer));
 
         mVideoInfo->buf.index = i;
@@ -876,11 +878,7 @@ status_t V4LCameraAdapter::startPreview()
             return ret;
         }
 
-        buf.index = i;
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-
-        ret = v4lIoctl(mCameraHandle, VIDIOC_QBUF, &buf);
+        ret = queueBufferToV4L(i);
         if (ret < 0) {
             CAMHAL_LOGEA("VIDIOC_QBUF Failed");
             goto EXIT;
@@ -924,10 +922,12 @@ status_t V4LCameraAdapter::stopPreview()
     if(!mPreviewing) {
         return NO_INIT;
     }
-    mPreviewing = false;
+
+    // The preview thread has left GetFrame() once this returns, so
+    // STREAMOFF below cannot race with a VIDIOC_DQBUF on the device
+    parkPreviewThread();
+
     if (isNeedToUseDecoder()) {
-        android::AutoMutex lock(mStopLock);
-        mStopCondition.waitRelative(mStopLock, 100000000);
         mDecoder->stop();
         mDecoder->flush();
     }
@@ -983,22 +983,40 @@ char * V4LCameraAdapter::GetFrame(int &index, int &filledLen)
     LOG_FUNCTION_NAME;
 
     v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     buf.memory = V4L2_MEMORY_MMAP;
 
+    bool deviceIdle = false;
+
     /* DQ */
     // Some V4L drivers, notably uvc, protect each incoming call with
-    // a driver-wide mutex.  If we use poll() or blocking VIDIOC_DQBUF ioctl
-    // here then we sometimes would run into a deadlock on VIDIO_QBUF ioctl.
+    // a driver-wide mutex.  A VIDIOC_QBUF issued from another thread while
+    // this one waits for a frame could then deadlock, so the device is never
+    // touched by other threads while streaming: returned buffers are put on
+    // mPendingQBufs and this thread is woken through mEventFd to queue them.
     while(true) {
-      if(!mVideoInfo->isStreaming) {
+      if (flushPendingBuffers() != NO_ERROR) {
         return NULL;
       }
 
+      {
+        android::AutoMutex pendingLock(mPendingQBufLock);
+        if (!mVideoInfo->isStreaming || mDequeueStopped) {
+          return NULL;
+        }
+      }
+
       ret = v4lIoctl(mCameraHandle, VIDIOC_DQBUF, &buf);
       if((ret == 0) || (errno != EAGAIN)) {
         break;
       }
+
+      ret = waitForFrame(deviceIdle);
+      if (ret != NO_ERROR && ret != TIMED_OUT) {
+        CAMHAL_LOGEB("GetFrame: poll failed: %s", strerror(errno));
+        return NULL;
+      }
     }
 
     if (ret < 0) {
@@ -1024,6 +1042,113 @@ char * V4LCameraAdapter::GetFrame(int &index, int &filledLen)
 
 
 
+status_t V4LCameraAdapter::waitForFrame(bool &deviceIdle)
+{
+    struct pollfd fds[2];
+    int ret;
+
+    // vb2 based drivers report POLLERR while no buffer is queued, in that case
+    // only the eventfd is watched until a buffer comes back from the clients
+    fds[0].fd = deviceIdle ? -1 : mCameraHandle;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = mEventFd;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    do {
+        ret = poll(fds, 2, DEQUEUE_POLL_TIMEOUT_MS);
+    } while (-1 == ret && EINTR == errno);
+
+    if (ret < 0) {
+        return UNKNOWN_ERROR;
+    }
+
+    if (ret == 0) {
+        CAMHAL_LOGDA("No frame from V4L within the poll timeout");
+        return TIMED_OUT;
+    }
+
+    if (fds[1].revents & POLLIN) {
+        eventfd_t value;
+        eventfd_read(mEventFd, &value);
+    }
+
+    deviceIdle = (fds[0].revents & POLLERR) != 0;
+
+    return NO_ERROR;
+}
+
+void V4LCameraAdapter::wakeDequeueThread()
+{
+    if (mEventFd >= 0) {
+        eventfd_write(mEventFd, 1);
+    }
+}
+
+status_t V4LCameraAdapter::flushPendingBuffers()
+{
+    android::Vector<int> pending;
+    status_t ret = NO_ERROR;
+
+    {
+        android::AutoMutex lock(mPendingQBufLock);
+        if (mPendingQBufs.isEmpty()) {
+            return NO_ERROR;
+        }
+        pending = mPendingQBufs;
+        mPendingQBufs.clear();
+    }
+
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (queueBufferToV4L(pending[i]) != NO_ERROR) {
+            // The driver no longer owns this buffer and nobody else will queue it
+            mFailedQBufs++;
+            CAMHAL_LOGEB("Requeue of V4L buffer %d failed, %d buffers lost",
+                         pending[i], mFailedQBufs);
+            ret = FAILED_TRANSACTION;
+        }
+    }
+
+    if ((ret != NO_ERROR) && (NULL != mErrorNotifier)) {
+        mErrorNotifier->errorNotify(CAMERA_ERROR_UNKNOWN);
+    }
+
+    return ret;
+}
+
+void V4LCameraAdapter::parkPreviewThread()
+{
+    // Called with mLock held, which is dropped while waiting so the
+    // preview thread can observe mPreviewing
+    {
+        android::AutoMutex stopLock(mStopLock);
+        mPreviewThreadParked = false;
+    }
+
+    mPreviewing = false;
+
+    {
+        android::AutoMutex pendingLock(mPendingQBufLock);
+        mDequeueStopped = true;
+    }
+    wakeDequeueThread();
+
+    mLock.unlock();
+
+    {
+        android::AutoMutex stopLock(mStopLock);
+        while (!mPreviewThreadParked) {
+            if (mStopCondition.waitRelative(mStopLock, ms2ns(DEQUEUE_POLL_TIMEOUT_MS)) != NO_ERROR) {
+                CAMHAL_LOGW("Timeout waiting for preview stop");
+                break;
+            }
+        }
+    }
+
+    mLock.lock();
+}
+
 //API to get the frame size required to be allocated. This size is used to override the size passed
 //by camera service when VSTAB/VNF is turned ON for example
 status_t V4LCameraAdapter::getFrameSize(size_t &width, size_t &height)
@@ -1174,12 +1299,19 @@ V4LCameraAdapter::V4LCameraAdapter(size_t sensor_index, CameraHal* hal)
     mDecoder = 0;
     nQueued = 0;
     nDequeued = 0;
+    mEventFd = -1;
+    mDequeueStopped = false;
+    mFailedQBufs = 0;
+    mPreviewThreadParked = true;
 
     setupWorkingMode();
 
     property_get("camera.v4l.skipframes", value, "1");
     mSkipFramesCount = atoi(value);
 
+    property_get("camera.v4l.convert.threads", value, "2");
+    mYuvConverter = new YuvConverter(atoi(value));
+
     LOG_FUNCTION_NAME_EXIT;
 }
 
@@ -1190,6 +1322,11 @@ V4LCameraAdapter::~V4LCameraAdapter()
     // Close the camera handle and free the video info structure
     close(mCameraHandle);
 
+    if (mEventFd >= 0) {
+        close(mEventFd);
+        mEventFd = -1;
+    }
+
     if (mVideoInfo)
       {
         free(mVideoInfo);
@@ -1197,6 +1334,7 @@ V4LCameraAdapter::~V4LCameraAdapter()
       }
 
     delete mDecoder;
+    delete mYuvConverter;
 
     mInBuffers.clear();
     mOutBuffers.clear();
@@ -1225,153 +1363,6 @@ static void convertYUV422i_yuyvTouyvy(uint8_t *src, uint8_t *dest, size_t size )
     LOG_FUNCTION_NAME_EXIT;
 }
 
-static void convertYUV422ToNV12Tiler(unsigned char *src, unsigned char *dest, int width, int height ) {
-    //convert YUV422I to YUV420 NV12 format and copies directly to preview buffers (Tiler memory).
-    int stride = 4096;
-    unsigned char *bf = src;
-    unsigned char *dst_y = dest;
-    unsigned char *dst_uv = dest + ( height * stride);
-#ifdef PPM_PER_FRAME_CONVERSION
-    static int frameCount = 0;
-    static nsecs_t ppm_diff = 0;
-    nsecs_t ppm_start  = systemTime();
-#endif
-
-    LOG_FUNCTION_NAME;
-
-    if (width % 16 ) {
-        for(int i = 0; i < height; i++) {
-            for(int j = 0; j < width; j++) {
-                *dst_y = *bf;
-                dst_y++;
-                bf = bf + 2;
-            }
-            dst_y += (stride - width);
-        }
-
-        bf = src;
-        bf++;  //UV sample
-        for(int i = 0; i < height/2; i++) {
-            for(int j=0; j<width; j++) {
-                *dst_uv = *bf;
-                dst_uv++;
-                bf = bf + 2;
-            }
-            bf = bf + width*2;
-            dst_uv = dst_uv + (stride - width);
-        }
-    } else {
-        //neon conversion
-        for(int i = 0; i < height; i++) {
-            int n = width;
-            int skip = i & 0x1;       // skip uv elements for the odd rows
-            asm volatile (
-                "   pld [%[src], %[src_stride], lsl #2]                         \n\t"
-                "   cmp %[n], #16                                               \n\t"
-                "   blt 5f                                                      \n\t"
-                "0: @ 16 pixel copy                                             \n\t"
-                "   vld2.8  {q0, q1} , [%[src]]! @ q0 = yyyy.. q1 = uvuv..      \n\t"
-                "                                @ now q0 = y q1 = uv           \n\t"
-                "   vst1.32   {d0,d1}, [%[dst_y]]!                              \n\t"
-                "   cmp    %[skip], #0                                          \n\t"
-                "   bne 1f                                                      \n\t"
-                "   vst1.32  {d2,d3},[%[dst_uv]]!                               \n\t"
-                "1: @ skip odd rows for UV                                      \n\t"
-                "   sub %[n], %[n], #16                                         \n\t"
-                "   cmp %[n], #16                                               \n\t"
-                "   bge 0b                                                      \n\t"
-                "5: @ end                                                       \n\t"
-#ifdef NEEDS_ARM_ERRATA_754319_754320
-                "   vmov s0,s0  @ add noop for errata item                      \n\t"
-#endif
-                : [dst_y] "+r" (dst_y), [dst_uv] "+r" (dst_uv), [src] "+r" (src), [n] "+r" (n)
-                : [src_stride] "r" (width), [skip] "r" (skip)
-                : "cc", "memory", "q0", "q1", "q2", "d0", "d1", "d2", "d3"
-            );
-            dst_y = dst_y + (stride - width);
-            if (skip == 0) {
-                dst_uv = dst_uv + (stride - width);
-            }
-        } //end of for()
-    }
-
-#ifdef PPM_PER_FRAME_CONVERSION
-    ppm_diff += (systemTime() - ppm_start);
-    frameCount++;
-
-    if (frameCount >= 30) {
-        ppm_diff = ppm_diff / frameCount;
-        LOGD("PPM: YUV422i to NV12 Conversion(%d x %d): %llu us ( %llu ms )", width, height,
-                ns2us(ppm_diff), ns2ms(ppm_diff) );
-        ppm_diff = 0;
-        frameCount = 0;
-    }
-#endif
-
-    LOG_FUNCTION_NAME_EXIT;
-}
-
-static void convertYUV422ToNV12(unsigned char *src, unsigned char *dest, int width, int height ) {
-    //convert YUV422I to YUV420 NV12 format.
-    unsigned char *bf = src;
-    unsigned char *dst_y = dest;
-    unsigned char *dst_uv = dest + (width * height);
-
-    LOG_FUNCTION_NAME;
-
-    if (width % 16 ) {
-        for(int i = 0; i < height; i++) {
-            for(int j = 0; j < width; j++) {
-                *dst_y = *bf;
-                dst_y++;
-                bf = bf + 2;
-            }
-        }
-
-        bf = src;
-        bf++;  //UV sample
-        for(int i = 0; i < height/2; i++) {
-            for(int j=0; j<width; j++) {
-                *dst_uv = *bf;
-                dst_uv++;
-                bf = bf + 2;
-            }
-            bf = bf + width*2;
-        }
-    } else {
-        //neon conversion
-        for(int i = 0; i < height; i++) {
-            int n = width;
-            int skip = i & 0x1;       // skip uv elements for the odd rows
-            asm volatile (
-                "   pld [%[src], %[src_stride], lsl #2]                         \n\t"
-                "   cmp %[n], #16                                               \n\t"
-                "   blt 5f                                                      \n\t"
-                "0: @ 16 pixel copy                                             \n\t"
-                "   vld2.8  {q0, q1} , [%[src]]! @ q0 = yyyy.. q1 = uvuv..      \n\t"
-                "                                @ now q0 = y q1 = uv           \n\t"
-                "   vst1.32   {d0,d1}, [%[dst_y]]!                              \n\t"
-                "   cmp    %[skip], #0                                          \n\t"
-                "   bne 1f                                                      \n\t"
-                "   vst1.32  {d2,d3},[%[dst_uv]]!                               \n\t"
-                "1: @ skip odd rows for UV                                      \n\t"
-                "   sub %[n], %[n], #16                                         \n\t"
-                "   cmp %[n], #16                                               \n\t"
-                "   bge 0b                                                      \n\t"
-                "5: @ end                                                       \n\t"
-#ifdef NEEDS_ARM_ERRATA_754319_754320
-                "   vmov s0,s0  @ add noop for errata item                      \n\t"
-#endif
-                : [dst_y] "+r" (dst_y), [dst_uv] "+r" (dst_uv), [src] "+r" (src), [n] "+r" (n)
-                : [src_stride] "r" (width), [skip] "r" (skip)
-                : "cc", "memory", "q0", "q1", "q2", "d0", "d1", "d2", "d3"
-            );
-        }
-    }
-
-    LOG_FUNCTION_NAME_EXIT;
-}
-
 
 
 
@@ -1384,13 +1375,11 @@ void V4LCameraAdapter::returnOutputBuffer(int index)
     LOG_FUNCTION_NAME;
 
     size_t width, height;
-    int stride = 4096;
+    int stride = PREVIEW_STRIDE;
     CameraFrame frame;
 
     getFrameSize(width, height);
 
-    android::Mutex::Autolock slock(mSubscriberLock);
-
     android::sp<MediaBuffer>& buffer = mOutBuffers.editItemAt(index);
 
     CameraBuffer* cbuffer = static_cast<CameraBuffer*>(buffer->buffer);
@@ -1425,8 +1414,24 @@ void V4LCameraAdapter::returnOutputBuffer(int index)
 }
 
 status_t V4LCameraAdapter::returnBufferToV4L(int id) {
+    android::AutoMutex lock(mPendingQBufLock);
+
+    if (!mVideoInfo->isStreaming) {
+        // The set this buffer came from is being or has been released
+        CAMHAL_LOGDB("Dropping V4L buffer %d returned after stream off", id);
+        return NO_ERROR;
+    }
+
+    // Hand the buffer over to the thread blocked in GetFrame()
+    mPendingQBufs.push(id);
+    wakeDequeueThread();
+    return NO_ERROR;
+}
+
+status_t V4LCameraAdapter::queueBufferToV4L(int id) {
     status_t ret = NO_ERROR;
     v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
     buf.index = id;
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     buf.memory = V4L2_MEMORY_MMAP;
@@ -1448,7 +1453,7 @@ int V4LCameraAdapter::previewThread()
     void *y_uv[2];
     int index = 0;
     int filledLen = 0;
-    int stride = 4096;
+    int stride = PREVIEW_STRIDE;
     char *fp = NULL;
 
     mParams.getPreviewSize(&width, &height);
@@ -1458,16 +1463,14 @@ int V4LCameraAdapter::previewThread()
         if (!mPreviewing) {
             //If stop preview is called - it can now go on.
             android::AutoMutex stopLock(mStopLock);
+            mPreviewThreadParked = true;
             mStopCondition.signal();
             return ret;
         }
     }
 
-    {
-        android::Mutex::Autolock lock(mSubscriberLock);
-        if ( mFrameSubscribers.size() == 0 ) {
-            return BAD_VALUE;
-        }
+    if ( getSubscriberCount(CameraFrame::PREVIEW_FRAME_SYNC) == 0 ) {
+        return BAD_VALUE;
     }
 
     if (isNeedToUseDecoder()){
@@ -1503,20 +1506,40 @@ int V4LCameraAdapter::previewThread()
 
         CameraBuffer *buffer = mPreviewBufs[index];
         if (mPixelFormat == V4L2_PIX_FMT_YUYV) {
-            convertYUV422ToNV12Tiler(reinterpret_cast<unsigned char*>(fp), reinterpret_cast<unsigned char*>(buffer->mapped), width, height);
+#ifdef PPM_PER_FRAME_CONVERSION
+            static int frameCount = 0;
+            static nsecs_t ppm_diff = 0;
+            nsecs_t ppm_start  = systemTime();
+#endif
+            //convert YUV422I to YUV420 NV12 format and copies directly to preview buffers (Tiler memory).
+            unsigned char *dest = reinterpret_cast<unsigned char*>(buffer->mapped);
+            mYuvConverter->convertYUV422ToNV12(reinterpret_cast<unsigned char*>(fp), width * 2,
+                                               dest, stride, dest + (height * stride), stride,
+                                               width, height, YUV422_LAYOUT_YUYV);
+#ifdef PPM_PER_FRAME_CONVERSION
+            ppm_diff += (systemTime() - ppm_start);
+            frameCount++;
+
+            if (frameCount >= 30) {
+                ppm_diff = ppm_diff / frameCount;
+                LOGD("PPM: YUV422i to NV12 Conversion(%d x %d): %llu us ( %llu ms )", width, height,
+                        ns2us(ppm_diff), ns2ms(ppm_diff) );
+                ppm_diff = 0;
+                frameCount = 0;
+            }
+#endif
         }
         CAMHAL_LOGVB("##...index= %d.;camera buffer= 0x%x; mapped= 0x%x.",index, buffer, buffer->mapped);
 
 #ifdef SAVE_RAW_FRAMES
         unsigned char* nv12_buff = (unsigned char*) malloc(width*height*3/2);
         //Convert yuv422i to yuv420sp(NV12) & dump the frame to a file
-        convertYUV422ToNV12 ( (unsigned char*)fp, nv12_buff, width, height);
+        convertYUV422ToNV12((unsigned char*)fp, width * 2, nv12_buff, width,
+                            nv12_buff + (width * height), width, width, height, YUV422_LAYOUT_YUYV);
         saveFile( nv12_buff, ((width*height)*3/2) );
         free (nv12_buff);
 #endif
 
-        android::Mutex::Autolock lock(mSubscriberLock);
-
         frame.mFrameType = CameraFrame::PREVIEW_FRAME_SYNC;
         frame.mBuffer = buffer;
         frame.mLength = width*height*3/2;
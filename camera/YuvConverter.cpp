@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+* @file YuvConverter.cpp
+*
+* Interleaved YUV422 (YUYV/UYVY) conversions shared by the V4L adapter
+* and the libjpeg encoder.
+*
+*/
+
+#include "YuvConverter.h"
+
+namespace Ti {
+namespace Camera {
+
+#ifdef ARCH_ARM_HAVE_NEON
+// Splits n (multiple of 16) pixels of a YUYV row, dst_uv may be NULL
+static void splitRowYUYV(const uint8_t *src, uint8_t *dst_y, uint8_t *dst_uv, int n) {
+    if (dst_uv) {
+        asm volatile (
+        "0: @ 16 pixel split                                            \n\t"
+        "   pld [%[src], #128]                                          \n\t"
+        "   vld2.8  {q0, q1} , [%[src]]! @ q0 = yyyy.. q1 = uvuv..      \n\t"
+        "   vst1.8  {q0}, [%[dst_y]]!                                   \n\t"
+        "   vst1.8  {q1}, [%[dst_uv]]!                                  \n\t"
+        "   subs %[n], %[n], #16                                        \n\t"
+        "   bgt 0b                                                      \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [dst_y] "+r" (dst_y), [dst_uv] "+r" (dst_uv), [src] "+r" (src), [n] "+r" (n)
+        :
+        : "cc", "memory", "q0", "q1"
+        );
+    } else {
+        asm volatile (
+        "0: @ 16 pixel luma only                                        \n\t"
+        "   pld [%[src], #128]                                          \n\t"
+        "   vld2.8  {q0, q1} , [%[src]]! @ q0 = yyyy.. q1 = uvuv..      \n\t"
+        "   vst1.8  {q0}, [%[dst_y]]!                                   \n\t"
+        "   subs %[n], %[n], #16                                        \n\t"
+        "   bgt 0b                                                      \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [dst_y] "+r" (dst_y), [src] "+r" (src), [n] "+r" (n)
+        :
+        : "cc", "memory", "q0", "q1"
+        );
+    }
+}
+
+// Splits n (multiple of 16) pixels of a UYVY row, dst_uv may be NULL
+static void splitRowUYVY(const uint8_t *src, uint8_t *dst_y, uint8_t *dst_uv, int n) {
+    if (dst_uv) {
+        asm volatile (
+        "0: @ 16 pixel split                                            \n\t"
+        "   pld [%[src], #128]                                          \n\t"
+        "   vld2.8  {q0, q1} , [%[src]]! @ q0 = uvuv.. q1 = yyyy..      \n\t"
+        "   vst1.8  {q1}, [%[dst_y]]!                                   \n\t"
+        "   vst1.8  {q0}, [%[dst_uv]]!                                  \n\t"
+        "   subs %[n], %[n], #16                                        \n\t"
+        "   bgt 0b                                                      \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [dst_y] "+r" (dst_y), [dst_uv] "+r" (dst_uv), [src] "+r" (src), [n] "+r" (n)
+        :
+        : "cc", "memory", "q0", "q1"
+        );
+    } else {
+        asm volatile (
+        "0: @ 16 pixel luma only                                        \n\t"
+        "   pld [%[src], #128]                                          \n\t"
+        "   vld2.8  {q0, q1} , [%[src]]! @ q0 = uvuv.. q1 = yyyy..      \n\t"
+        "   vst1.8  {q1}, [%[dst_y]]!                                   \n\t"
+        "   subs %[n], %[n], #16                                        \n\t"
+        "   bgt 0b                                                      \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [dst_y] "+r" (dst_y), [src] "+r" (src), [n] "+r" (n)
+        :
+        : "cc", "memory", "q0", "q1"
+        );
+    }
+}
+#endif
+
+static void splitRow(const uint8_t *src, uint8_t *dst_y, uint8_t *dst_uv, int width, Yuv422Layout layout) {
+    int done = 0;
+
+#ifdef ARCH_ARM_HAVE_NEON
+    done = width & ~15;
+    if (done > 0) {
+        if (layout == YUV422_LAYOUT_YUYV) {
+            splitRowYUYV(src, dst_y, dst_uv, done);
+        } else {
+            splitRowUYVY(src, dst_y, dst_uv, done);
+        }
+    }
+#endif
+
+    const uint8_t *y = src + ((layout == YUV422_LAYOUT_YUYV) ? 0 : 1);
+    const uint8_t *c = src + ((layout == YUV422_LAYOUT_YUYV) ? 1 : 0);
+
+    for (int j = done; j < width; j++) {
+        dst_y[j] = y[j * 2];
+    }
+
+    if (dst_uv) {
+        for (int j = done; j < width; j++) {
+            dst_uv[j] = c[j * 2];
+        }
+    }
+}
+
+void convertYUV422ToNV12(const uint8_t *src, int srcStride,
+                         uint8_t *dstY, int dstYStride,
+                         uint8_t *dstUV, int dstUVStride,
+                         int width, int height, Yuv422Layout layout) {
+    if (!src || !dstY || !dstUV) {
+        return;
+    }
+
+    for (int i = 0; i < height; i++) {
+        // chroma of the odd rows is dropped
+        uint8_t *uv = NULL;
+        if (!(i & 1) && (i / 2 < height / 2)) {
+            uv = dstUV + (i / 2) * dstUVStride;
+        }
+
+        splitRow(src, dstY, uv, width, layout);
+
+        src += srcStride;
+        dstY += dstYStride;
+    }
+}
+
+static void uyvy_to_yuv(uint8_t* dst, const uint32_t* src, int width) {
+#ifdef ARCH_ARM_HAVE_NEON
+    // currently, neon routine only supports multiple of 16 width
+    if ((width % 16) == 0) {
+        int n = width;
+        asm volatile (
+        "   pld [%[src], %[src_stride], lsl #2]                         \n\t"
+        "   cmp %[n], #16                                               \n\t"
+        "   blt 5f                                                      \n\t"
+        "0: @ 16 pixel swap                                             \n\t"
+        "   vld2.8  {q0, q1} , [%[src]]! @ q0 = uv q1 = y               \n\t"
+        "   vuzp.8 q0, q2                @ d0 = u d4 = v                \n\t"
+        "   vmov d1, d0                  @ q0 = u0u1u2..u0u1u2...       \n\t"
+        "   vmov d5, d4                  @ q2 = v0v1v2..v0v1v2...       \n\t"
+        "   vzip.8 d0, d1                @ q0 = u0u0u1u1u2u2...         \n\t"
+        "   vzip.8 d4, d5                @ q2 = v0v0v1v1v2v2...         \n\t"
+        "   vswp q0, q1                  @ now q0 = y q1 = u q2 = v     \n\t"
+        "   vst3.8  {d0,d2,d4},[%[dst]]!                                \n\t"
+        "   vst3.8  {d1,d3,d5},[%[dst]]!                                \n\t"
+        "   sub %[n], %[n], #16                                         \n\t"
+        "   cmp %[n], #16                                               \n\t"
+        "   bge 0b                                                      \n\t"
+        "5: @ end                                                       \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [dst] "+r" (dst), [src] "+r" (src), [n] "+r" (n)
+        : [src_stride] "r" (width)
+        : "cc", "memory", "q0", "q1", "q2"
+        );
+    } else
+#endif
+    {
+        while ((width-=2) >= 0) {
+            uint8_t u0 = (src[0] >> 0) & 0xFF;
+            uint8_t y0 = (src[0] >> 8) & 0xFF;
+            uint8_t v0 = (src[0] >> 16) & 0xFF;
+            uint8_t y1 = (src[0] >> 24) & 0xFF;
+            dst[0] = y0;
+            dst[1] = u0;
+            dst[2] = v0;
+            dst[3] = y1;
+            dst[4] = u0;
+            dst[5] = v0;
+            dst += 6;
+            src++;
+        }
+    }
+}
+
+static void yuyv_to_yuv(uint8_t* dst, const uint32_t* src, int width) {
+#ifdef ARCH_ARM_HAVE_NEON
+    // currently, neon routine only supports multiple of 16 width
+    if ((width % 16) == 0) {
+        int n = width;
+        asm volatile (
+        "   pld [%[src], %[src_stride], lsl #2]                         \n\t"
+        "   cmp %[n], #16                                               \n\t"
+        "   blt 5f                                                      \n\t"
+        "0: @ 16 pixel swap                                             \n\t"
+        "   vld2.8  {q0, q1} , [%[src]]! @ q0 = yyyy.. q1 = uvuv..      \n\t"
+        "   vuzp.8 q1, q2                @ d2 = u d4 = v                \n\t"
+        "   vmov d3, d2                  @ q1 = u0u1u2..u0u1u2...       \n\t"
+        "   vmov d5, d4                  @ q2 = v0v1v2..v0v1v2...       \n\t"
+        "   vzip.8 d2, d3                @ q1 = u0u0u1u1u2u2...         \n\t"
+        "   vzip.8 d4, d5                @ q2 = v0v0v1v1v2v2...         \n\t"
+        "                                @ now q0 = y q1 = u q2 = v     \n\t"
+        "   vst3.8  {d0,d2,d4},[%[dst]]!                                \n\t"
+        "   vst3.8  {d1,d3,d5},[%[dst]]!                                \n\t"
+        "   sub %[n], %[n], #16                                         \n\t"
+        "   cmp %[n], #16                                               \n\t"
+        "   bge 0b                                                      \n\t"
+        "5: @ end                                                       \n\t"
+#ifdef NEEDS_ARM_ERRATA_754319_754320
+        "   vmov s0,s0  @ add noop for errata item                      \n\t"
+#endif
+        : [dst] "+r" (dst), [src] "+r" (src), [n] "+r" (n)
+        : [src_stride] "r" (width)
+        : "cc", "memory", "q0", "q1", "q2"
+        );
+    } else
+#endif
+    {
+        while ((width-=2) >= 0) {
+            uint8_t y0 = (src[0] >> 0) & 0xFF;
+            uint8_t u0 = (src[0] >> 8) & 0xFF;
+            uint8_t y1 = (src[0] >> 16) & 0xFF;
+            uint8_t v0 = (src[0] >> 24) & 0xFF;
+            dst[0] = y0;
+            dst[1] = u0;
+            dst[2] = v0;
+            dst[3] = y1;
+            dst[4] = u0;
+            dst[5] = v0;
+            dst += 6;
+            src++;
+        }
+    }
+}
+
+void convertYUV422RowToYUV444(uint8_t *dst, const uint8_t *src, int width, Yuv422Layout layout) {
+    if (!dst || !src) {
+        return;
+    }
+
+    if (width % 2) {
+        return; // not supporting odd widths
+    }
+
+    if (layout == YUV422_LAYOUT_UYVY) {
+        uyvy_to_yuv(dst, reinterpret_cast<const uint32_t*>(src), width);
+    } else {
+        yuyv_to_yuv(dst, reinterpret_cast<const uint32_t*>(src), width);
+    }
+}
+
+/*--------------------YuvConverter Class STARTS here-----------------------------*/
+
+void YuvConverter::BandThread::post(const Band& band) {
+    android::AutoMutex lock(mLock);
+    mBand = band;
+    mPending = true;
+    mCondition.broadcast();
+}
+
+void YuvConverter::BandThread::waitDone() {
+    android::AutoMutex lock(mLock);
+    while (mPending && !mExiting) {
+        mCondition.wait(mLock);
+    }
+}
+
+void YuvConverter::BandThread::requestExit() {
+    Thread::requestExit();
+
+    android::AutoMutex lock(mLock);
+    mExiting = true;
+    mCondition.broadcast();
+}
+
+bool YuvConverter::BandThread::threadLoop() {
+    Band band;
+
+    {
+        android::AutoMutex lock(mLock);
+        while (!mPending && !mExiting) {
+            mCondition.wait(mLock);
+        }
+        if (mExiting) {
+            return false;
+        }
+        band = mBand;
+    }
+
+    YuvConverter::convertBand(band);
+
+    {
+        android::AutoMutex lock(mLock);
+        mPending = false;
+        mCondition.broadcast();
+    }
+
+    return true;
+}
+
+YuvConverter::YuvConverter(int threadCount)
+    : mThreadCount(threadCount)
+{
+    if (mThreadCount < 1) {
+        mThreadCount = 1;
+    } else if (mThreadCount > MAX_THREADS) {
+        mThreadCount = MAX_THREADS;
+    }
+}
+
+YuvConverter::~YuvConverter()
+{
+    for (size_t i = 0; i < mThreads.size(); i++) {
+        mThreads.editItemAt(i)->requestExit();
+        mThreads.editItemAt(i)->requestExitAndWait();
+    }
+    mThreads.clear();
+}
+
+void YuvConverter::convertBand(const Band& band) {
+    Ti::Camera::convertYUV422ToNV12(band.src, band.srcStride,
+                                    band.dstY, band.dstYStride,
+                                    band.dstUV, band.dstUVStride,
+                                    band.width, band.height, band.layout);
+}
+
+status_t YuvConverter::startThreads() {
+    for (int i = 1; i < mThreadCount; i++) {
+        android::sp<BandThread> thread = new BandThread();
+        status_t ret = thread->run("YuvConverter", android::PRIORITY_URGENT_DISPLAY);
+        if (ret != NO_ERROR) {
+            CAMHAL_LOGEB("Couldn't run conversion thread %d, using %d bands", i, i);
+            // Settle for the threads that did start, so this is never retried
+            mThreadCount = i;
+            return ret;
+        }
+        mThreads.push_back(thread);
+    }
+
+    return NO_ERROR;
+}
+
+void YuvConverter::convertYUV422ToNV12(const uint8_t *src, int srcStride,
+                                       uint8_t *dstY, int dstYStride,
+                                       uint8_t *dstUV, int dstUVStride,
+                                       int width, int height, Yuv422Layout layout) {
+    android::AutoMutex lock(mLock);
+
+    int bands = mThreadCount;
+    if (bands > height / MIN_BAND_ROWS) {
+        bands = height / MIN_BAND_ROWS;
+    }
+
+    if ((bands > 1) && mThreads.isEmpty()) {
+        startThreads();
+    }
+
+    if (bands > (int)mThreads.size() + 1) {
+        bands = mThreads.size() + 1;
+    }
+
+    if (bands <= 1) {
+        Ti::Camera::convertYUV422ToNV12(src, srcStride, dstY, dstYStride, dstUV, dstUVStride,
+                                        width, height, layout);
+        return;
+    }
+
+    // Bands start on even rows so that each one owns whole NV12 chroma rows
+    const int bandRows = ((height / bands) + 1) & ~1;
+    Band band;
+    band.srcStride = srcStride;
+    band.dstYStride = dstYStride;
+    band.dstUVStride = dstUVStride;
+    band.width = width;
+    band.layout = layout;
+
+    int row = 0;
+    for (int i = 0; i < bands - 1; i++, row += bandRows) {
+        band.src = src + row * srcStride;
+        band.dstY = dstY + row * dstYStride;
+        band.dstUV = dstUV + (row / 2) * dstUVStride;
+        band.height = bandRows;
+        mThreads.editItemAt(i)->post(band);
+    }
+
+    // The calling thread takes the last band
+    band.src = src + row * srcStride;
+    band.dstY = dstY + row * dstYStride;
+    band.dstUV = dstUV + (row / 2) * dstUVStride;
+    band.height = height - row;
+    convertBand(band);
+
+    for (int i = 0; i < bands - 1; i++) {
+        mThreads.editItemAt(i)->waitDone();
+    }
+}
+
+} // namespace Camera
+} // namespace Ti
@@ -17,6 +17,7 @@
 
 
 #include "CameraHal.h"
+#include "BufferSlotTable.h"
 #include <ui/GraphicBufferMapper.h>
 #include <hal_public.h>
 
@@ -162,8 +163,21 @@ private:
     //IMG_native_handle_t** mGrallocHandleMap; // -> frames[i].GrallocHandle
     uint32_t* mOffsetsMap; // -> frames[i].Offset
     int mFD;
-    android::KeyedVector<buffer_handle_t *, int> mFramesWithCameraAdapterMap;
-    android::KeyedVector<int, int> mFramesType;
+
+    ///Per-buffer state, indexed the same way as mBuffers
+    typedef struct
+        {
+        int mFrameType; ///-1 until the buffer has been posted
+        bool mWithCamera; ///Dequeued from the window
+        } BufferSlot;
+    BufferSlot *mSlots;
+
+    ///buffer_handle_t* -> slot lookup built at allocation time
+    BufferSlotTable mSlotTable;
+
+    ///Buffer kept dequeued and locked ahead of the next frame return, -1 if none
+    int mHeldSlot;
+    bool mDequeueAhead;
     android::sp<ErrorNotifier> mErrorNotifier;
 
     uint32_t mFrameWidth;
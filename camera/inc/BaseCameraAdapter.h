@@ -19,6 +19,8 @@
 #ifndef BASE_CAMERA_ADAPTER_H
 #define BASE_CAMERA_ADAPTER_H
 
+#include <cutils/atomic.h>
+
 #include "CameraHal.h"
 
 namespace Ti {
@@ -56,7 +58,7 @@ public:
 
     //APIs to configure Camera adapter and get the current parameter set
     virtual status_t setParameters(const android::CameraParameters& params) = 0;
-    virtual void getParameters(android::CameraParameters& params)  = 0;
+    virtual void getParameters(CameraHalParameters& params)  = 0;
 
     //API to send a command to the camera
     virtual status_t sendCommand(CameraCommands operation, int value1 = 0, int value2 = 0, int value3 = 0, int value4 = 0 );
@@ -172,6 +174,9 @@ protected:
     //Send the frame to subscribers
     status_t sendFrameToSubscribers(CameraFrame *frame);
 
+    //Number of subscribers currently registered for a frame type
+    size_t getSubscriberCount(CameraFrame::FrameType frameType) const;
+
     //Resets the refCount for this particular frame
     status_t resetFrameRefCount(CameraFrame &frame);
 
@@ -182,12 +187,46 @@ protected:
     int setInitFrameRefCount(CameraBuffer* buf, unsigned int mask);
     static const char* getLUTvalue_translateHAL(int Value, LUTtypeHAL LUT);
 
-// private member functions
+// private data types and member functions
 private:
+    //Subscribers are never modified in place. enableMsgType() and
+    //disableMsgType() publish a new copy, so dispatch can walk the
+    //current set without holding mSubscriberLock.
+    struct SubscriberSet {
+        android::KeyedVector<int, frame_callback> mFrame;
+        android::KeyedVector<int, frame_callback> mSnapshot;
+        android::KeyedVector<int, frame_callback> mFrameData;
+        android::KeyedVector<int, frame_callback> mVideo;
+        android::KeyedVector<int, frame_callback> mVideoIn;
+        android::KeyedVector<int, frame_callback> mImage;
+        android::KeyedVector<int, frame_callback> mRaw;
+        android::KeyedVector<int, event_callback> mFocus;
+        android::KeyedVector<int, event_callback> mZoom;
+        android::KeyedVector<int, event_callback> mShutter;
+        android::KeyedVector<int, event_callback> mMetadata;
+
+        android::KeyedVector<int, frame_callback> *framesFor(CameraFrame::FrameType frameType);
+        const android::KeyedVector<int, frame_callback> *framesFor(CameraFrame::FrameType frameType) const;
+    };
+
+    //Pins the current SubscriberSet for the lifetime of the object
+    class SubscriberRef {
+    public:
+        explicit SubscriberRef(const BaseCameraAdapter *adapter);
+        ~SubscriberRef();
+
+        const SubscriberSet *operator->() const { return mSet; }
+
+    private:
+        const BaseCameraAdapter *mAdapter;
+        const SubscriberSet *mSet;
+    };
+
     status_t __sendFrameToSubscribers(CameraFrame* frame,
-                                      android::KeyedVector<int, frame_callback> *subscribers,
+                                      const android::KeyedVector<int, frame_callback> *subscribers,
                                       CameraFrame::FrameType frameType);
     status_t rollbackToPreviousState();
+    void publishSubscribers(SubscriberSet *subscribers);
 
 // protected data types and variables
 protected:
@@ -212,6 +251,33 @@ protected:
         ERROR
     };
 
+    //Per-buffer reference counts for one frame type. Buffers are only
+    //added or cleared while they are not in flight; the counts themselves
+    //are atomic and looked up through CameraBuffer::index, so the frame
+    //and return paths need no lock.
+    class FrameRefCounts {
+    public:
+        static const size_t MAX_SLOTS = 32;
+
+        FrameRefCounts() : mCount(0) { }
+
+        void clear() { mCount = 0; }
+        status_t add(CameraBuffer *buffer, int refCount);
+        size_t size() const { return mCount; }
+        CameraBuffer *keyAt(size_t i) const { return mBuffers[i]; }
+
+        //Returns -1 for buffers that were never added
+        int get(const CameraBuffer *buffer) const;
+        void set(const CameraBuffer *buffer, int refCount);
+
+    private:
+        ssize_t slotOf(const CameraBuffer *buffer) const;
+
+        CameraBuffer *mBuffers[MAX_SLOTS];
+        volatile int32_t mRefCounts[MAX_SLOTS];
+        size_t mCount;
+    };
+
 #if PPM_INSTRUMENTATION || PPM_INSTRUMENTATION_ABS
 
     struct timeval mStartFocus;
@@ -221,59 +287,47 @@ protected:
 
     mutable android::Mutex mReturnFrameLock;
 
-    //Lock protecting the Adapter state
+    //Lock serializing the Adapter state transitions, the states
+    //themselves are atomics readable without it
     mutable android::Mutex mLock;
-    AdapterState mAdapterState;
-    AdapterState mNextState;
-
-    //Different frame subscribers get stored using these
-    android::KeyedVector<int, frame_callback> mFrameSubscribers;
-    android::KeyedVector<int, frame_callback> mSnapshotSubscribers;
-    android::KeyedVector<int, frame_callback> mFrameDataSubscribers;
-    android::KeyedVector<int, frame_callback> mVideoSubscribers;
-    android::KeyedVector<int, frame_callback> mVideoInSubscribers;
-    android::KeyedVector<int, frame_callback> mImageSubscribers;
-    android::KeyedVector<int, frame_callback> mRawSubscribers;
-    android::KeyedVector<int, event_callback> mFocusSubscribers;
-    android::KeyedVector<int, event_callback> mZoomSubscribers;
-    android::KeyedVector<int, event_callback> mShutterSubscribers;
-    android::KeyedVector<int, event_callback> mMetadataSubscribers;
+    volatile int32_t mAdapterState;
+    volatile int32_t mNextState;
 
     //Preview buffer management data
     CameraBuffer *mPreviewBuffers;
     int mPreviewBufferCount;
     size_t mPreviewBuffersLength;
-    android::KeyedVector<CameraBuffer *, int> mPreviewBuffersAvailable;
+    FrameRefCounts mPreviewBuffersAvailable;
     mutable android::Mutex mPreviewBufferLock;
 
     //Snapshot buffer management data
-    android::KeyedVector<CameraBuffer *, int> mSnapshotBuffersAvailable;
+    FrameRefCounts mSnapshotBuffersAvailable;
     mutable android::Mutex mSnapshotBufferLock;
 
     //Video buffer management data
     CameraBuffer *mVideoBuffers;
-    android::KeyedVector<CameraBuffer *, int> mVideoBuffersAvailable;
+    FrameRefCounts mVideoBuffersAvailable;
     int mVideoBuffersCount;
     size_t mVideoBuffersLength;
     mutable android::Mutex mVideoBufferLock;
 
     //Image buffer management data
     CameraBuffer *mCaptureBuffers;
-    android::KeyedVector<CameraBuffer *, int> mCaptureBuffersAvailable;
+    FrameRefCounts mCaptureBuffersAvailable;
     int mCaptureBuffersCount;
     size_t mCaptureBuffersLength;
     mutable android::Mutex mCaptureBufferLock;
 
     //Metadata buffermanagement
     CameraBuffer *mPreviewDataBuffers;
-    android::KeyedVector<CameraBuffer *, int> mPreviewDataBuffersAvailable;
+    FrameRefCounts mPreviewDataBuffersAvailable;
     int mPreviewDataBuffersCount;
     size_t mPreviewDataBuffersLength;
     mutable android::Mutex mPreviewDataBufferLock;
 
     //Video input buffer management data (used for reproc pipe)
     CameraBuffer *mVideoInBuffers;
-    android::KeyedVector<CameraBuffer *, int> mVideoInBuffersAvailable;
+    FrameRefCounts mVideoInBuffersAvailable;
     mutable android::Mutex mVideoInBufferLock;
 
     Utils::MessageQueue mFrameQ;
@@ -298,6 +352,17 @@ protected:
 #endif
 
     android::KeyedVector<void *, CameraFrame *> mFrameQueue;
+    mutable android::Mutex mFrameQueueLock;
+
+private:
+    //Current subscribers, see SubscriberSet
+    SubscriberSet * volatile mSubscribers;
+    //Number of SubscriberRef instances alive
+    mutable volatile int32_t mDispatchers;
+    //Signalled when the last SubscriberRef goes away, publishSubscribers()
+    //waits on it before freeing the set it replaced
+    mutable android::Mutex mDispatchLock;
+    mutable android::Condition mDispatchDone;
 };
 
 } // namespace Camera
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BUFFER_SLOT_TABLE_H
+#define BUFFER_SLOT_TABLE_H
+
+#include "CameraHal.h"
+
+namespace Ti {
+namespace Camera {
+
+/**
+ * Maps the opaque handle of a window buffer back to its index in a
+ * CameraBuffer array. Built once when the buffer list is set up, so the
+ * per-frame lookup is a hash probe instead of a walk over the list.
+ */
+class BufferSlotTable
+{
+public:
+    BufferSlotTable() : mBuffers(NULL), mSlots(NULL), mMask(0) { }
+    ~BufferSlotTable() { clear(); }
+
+    void build(const CameraBuffer *buffers, int count)
+    {
+        unsigned int size = 1;
+
+        clear();
+
+        while ( size < ( (unsigned int) count * 2 ) ) {
+            size <<= 1;
+        }
+
+        mBuffers = buffers;
+        mSlots = new int[size];
+        mMask = size - 1;
+
+        for ( unsigned int i = 0; i < size; i++ ) {
+            mSlots[i] = -1;
+        }
+
+        for ( int i = 0; i < count; i++ ) {
+            unsigned int pos = hash(buffers[i].opaque) & mMask;
+            while ( mSlots[pos] >= 0 ) {
+                pos = ( pos + 1 ) & mMask;
+            }
+            mSlots[pos] = i;
+        }
+    }
+
+    ///Returns the index of the buffer owning handle, -1 if there is none
+    int find(const void *handle) const
+    {
+        if ( NULL == mSlots ) {
+            return -1;
+        }
+
+        unsigned int pos = hash(handle) & mMask;
+        while ( mSlots[pos] >= 0 ) {
+            if ( mBuffers[mSlots[pos]].opaque == handle ) {
+                return mSlots[pos];
+            }
+            pos = ( pos + 1 ) & mMask;
+        }
+
+        return -1;
+    }
+
+    void clear()
+    {
+        if ( NULL != mSlots ) {
+            delete [] mSlots;
+            mSlots = NULL;
+        }
+        mBuffers = NULL;
+        mMask = 0;
+    }
+
+private:
+    static unsigned int hash(const void *handle)
+    {
+        uint32_t key = (uint32_t) (uintptr_t) handle;
+        key ^= key >> 16;
+        key *= 0x45d9f3b;
+        key ^= key >> 16;
+        return key;
+    }
+
+    BufferSlotTable(const BufferSlotTable &);
+    BufferSlotTable &operator=(const BufferSlotTable &);
+
+    const CameraBuffer *mBuffers;
+    int *mSlots;
+    unsigned int mMask;
+};
+
+} // namespace Camera
+} // namespace Ti
+
+#endif //BUFFER_SLOT_TABLE_H
@@ -20,6 +20,7 @@
 #ifdef OMAP_ENHANCEMENT_CPCAM
 
 #include "CameraHal.h"
+#include "BufferSlotTable.h"
 #include <ui/GraphicBufferMapper.h>
 #include <hal_public.h>
 
@@ -89,9 +90,15 @@ private:
     };
 
     // helper class to queue frame in different thread context
+    // Frames are copied into a fixed ring, producers block while it is full
     class QueueFrame : public android::Thread {
     public:
+        ///Deeper than the largest buffer list a buffer source is given
+        static const int QUEUE_DEPTH = 16;
+
         QueueFrame(BufferSourceAdapter* __this) : mBufferSourceAdapter(__this) {
+            mHead = 0;
+            mCount = 0;
             mDestroying = false;
         }
 
@@ -100,46 +107,53 @@ private:
 
         void addFrame(CameraFrame *frame) {
             android::AutoMutex lock(mFramesMutex);
-            mFrames.add(new CameraFrame(*frame));
+            while ((QUEUE_DEPTH == mCount) && !mDestroying) mSpaceCondition.wait(mFramesMutex);
+            if (mDestroying) {
+                return;
+            }
+            mFrames[(mHead + mCount) % QUEUE_DEPTH] = *frame;
+            mCount++;
             mFramesCondition.signal();
         }
 
         virtual void requestExit() {
             Thread::requestExit();
 
-            mDestroying = true;
-
             android::AutoMutex lock(mFramesMutex);
-            while (!mFrames.empty()) {
-                CameraFrame *frame = mFrames.itemAt(0);
-                mFrames.removeAt(0);
-                frame->mMetaData.clear();
-                delete frame;
+            mDestroying = true;
+            while (0 < mCount) {
+                mFrames[mHead].mMetaData.clear();
+                mHead = (mHead + 1) % QUEUE_DEPTH;
+                mCount--;
             }
             mFramesCondition.signal();
+            mSpaceCondition.broadcast();
         }
 
         virtual bool threadLoop() {
-            CameraFrame *frame = NULL;
+            CameraFrame frame;
+            bool haveFrame = false;
             {
                 android::AutoMutex lock(mFramesMutex);
-                while (mFrames.empty() && !mDestroying) mFramesCondition.wait(mFramesMutex);
+                while ((0 == mCount) && !mDestroying) mFramesCondition.wait(mFramesMutex);
                 if (!mDestroying) {
-                    frame = mFrames.itemAt(0);
-                    mFrames.removeAt(0);
+                    frame = mFrames[mHead];
+                    mFrames[mHead].mMetaData.clear();
+                    mHead = (mHead + 1) % QUEUE_DEPTH;
+                    mCount--;
+                    haveFrame = true;
+                    mSpaceCondition.signal();
                 }
             }
 
-            if (frame) {
-                mBufferSourceAdapter->handleFrameCallback(frame);
-                frame->mMetaData.clear();
+            if (haveFrame) {
+                mBufferSourceAdapter->handleFrameCallback(&frame);
+                frame.mMetaData.clear();
 
-                if (frame->mFrameType != CameraFrame::REPROCESS_INPUT_FRAME) {
+                if (frame.mFrameType != CameraFrame::REPROCESS_INPUT_FRAME) {
                     // signal return frame thread that it can dequeue a buffer now
                     mBufferSourceAdapter->mReturnFrame->signal();
                 }
-
-                delete frame;
             }
 
             return true;
@@ -147,8 +161,11 @@ private:
 
     private:
         BufferSourceAdapter* mBufferSourceAdapter;
-        android::Vector<CameraFrame *> mFrames;
+        CameraFrame mFrames[QUEUE_DEPTH];
+        int mHead;
+        int mCount;
         android::Condition mFramesCondition;
+        android::Condition mSpaceCondition;
         android::Mutex mFramesMutex;
         bool mDestroying;
     };
@@ -205,7 +222,10 @@ private:
     int mBufferCount;
     CameraBuffer *mBuffers;
 
-    android::KeyedVector<buffer_handle_t *, int> mFramesWithCameraAdapterMap;
+    ///Per slot of mBuffers, true while the buffer is dequeued from the buffer source
+    bool *mBuffersWithCamera;
+    ///buffer_handle_t* -> slot lookup, rebuilt whenever mBuffers changes
+    BufferSlotTable mSlotTable;
     android::sp<ErrorNotifier> mErrorNotifier;
     android::sp<ReturnFrame> mReturnFrame;
     android::sp<QueueFrame> mQueueFrame;
@@ -34,6 +34,8 @@
 #include <utils/Log.h>
 #include <utils/threads.h>
 #include <utils/threads.h>
+#include <utils/SortedVector.h>
+#include <utils/Vector.h>
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
 #include <camera/CameraParameters.h>
@@ -59,6 +61,7 @@
 #include "Semaphore.h"
 #include "CameraProperties.h"
 #include "SensorListener.h"
+#include "FrameTracer.h"
 
 //temporarily define format here
 #define HAL_PIXEL_FORMAT_TI_NV12 0x100
@@ -197,10 +200,58 @@ inline int FpsRange::min() const { return mMin; }
 
 inline int FpsRange::max() const { return mMax; }
 
-class CameraArea : public android::RefBase
+///Comma separated list of supported values, tokenized once so that lookups
+///don't have to copy and re-tokenize the capability string
+class SupportedValues {
+public:
+    void add(const char *supported);
+    void clear();
+
+    bool contains(const char *value) const;
+    bool contains(int value) const;
+
+private:
+    ///Kept sorted for binary search
+    android::Vector<android::String8> mValues;
+};
+
+///"WxH" resolution list
+class SupportedResolutions {
+public:
+    void add(const char *supported);
+    void clear();
+
+    bool contains(unsigned int width, unsigned int height) const;
+
+private:
+    ///Packed as (width << 16) | height
+    android::SortedVector<uint32_t> mResolutions;
+};
+
+///"(min,max)" frame rate range list, a range is supported if it fits one of them
+class SupportedFpsRanges {
+public:
+    void add(const char *supported);
+    void clear();
+
+    bool contains(int fpsMin, int fpsMax) const;
+
+private:
+    android::Vector<FpsRange> mRanges;
+};
+
+class CameraAreas;
+
+class CameraArea
 {
 public:
 
+    CameraArea() : mTop(0),
+                   mLeft(0),
+                   mBottom(0),
+                   mRight(0),
+                   mWeight(0) {}
+
     CameraArea(ssize_t top,
                ssize_t left,
                ssize_t bottom,
@@ -216,29 +267,29 @@ public:
                        size_t &top,
                        size_t &left,
                        size_t &areaWidth,
-                       size_t &areaHeight);
+                       size_t &areaHeight) const;
 
-    bool isValid()
+    bool isValid() const
         {
         return ( ( 0 != mTop ) || ( 0 != mLeft ) || ( 0 != mBottom ) || ( 0 != mRight) );
         }
 
-    bool isZeroArea()
+    bool isZeroArea() const
     {
         return  ( (0 == mTop ) && ( 0 == mLeft ) && ( 0 == mBottom )
                  && ( 0 == mRight ) && ( 0 == mWeight ));
     }
 
-    size_t getWeight()
+    size_t getWeight() const
         {
         return mWeight;
         }
 
-    bool compare(const android::sp<CameraArea> &area);
+    bool compare(const CameraArea &area) const;
 
     static status_t parseAreas(const char *area,
                                size_t areaLength,
-                               android::Vector< android::sp<CameraArea> > &areas);
+                               CameraAreas &areas);
 
     static status_t checkArea(ssize_t top,
                               ssize_t left,
@@ -246,7 +297,7 @@ public:
                               ssize_t right,
                               ssize_t weight);
 
-    static bool areAreasDifferent(android::Vector< android::sp<CameraArea> > &, android::Vector< android::sp<CameraArea> > &);
+    static bool areAreasDifferent(const CameraAreas &, const CameraAreas &);
 
 protected:
     static const ssize_t TOP = -1000;
@@ -263,6 +314,65 @@ protected:
     size_t mWeight;
 };
 
+/**
+ * Fixed-capacity list of areas held by value. parseAreas() fills it
+ * straight from the parameter string and keeps a hash of the contents,
+ * so unchanged areas are rejected without walking the list.
+ */
+class CameraAreas
+{
+public:
+    ///Upper bound of the 3A algo areas the sensor can take
+    static const size_t MAX_AREAS = 35;
+
+    CameraAreas() : mCount(0), mHash(0) {}
+
+    size_t size() const { return mCount; }
+    bool isEmpty() const { return ( 0 == mCount ); }
+    void clear() { mCount = 0; mHash = 0; }
+
+    const CameraArea &operator[](size_t index) const { return mAreas[index]; }
+
+private:
+    friend class CameraArea;
+
+    CameraArea mAreas[MAX_AREAS];
+    size_t mCount;
+    uint32_t mHash;
+};
+
+/**
+ * CameraParameters that count the changes made through them. Setters
+ * only bump the generation when the stored value actually differs, so
+ * a cached copy is stale exactly when the generation moved.
+ */
+class CameraHalParameters : public android::CameraParameters
+{
+public:
+    CameraHalParameters() : mGeneration(0) {}
+
+    CameraHalParameters &operator=(const android::CameraParameters &params);
+    CameraHalParameters &operator=(const CameraHalParameters &params);
+
+    uint32_t generation() const { return mGeneration; }
+
+    void set(const char *key, const char *value);
+    void set(const char *key, int value);
+    void setFloat(const char *key, float value);
+    void remove(const char *key);
+    void unflatten(const android::String8 &params);
+
+    void setPreviewSize(int width, int height);
+    void setPictureSize(int width, int height);
+    void setVideoSize(int width, int height);
+    void setPreviewFrameRate(int fps);
+    void setPreviewFormat(const char *format);
+    void setPictureFormat(const char *format);
+
+private:
+    uint32_t mGeneration;
+};
+
 class CameraMetadataResult : public android::RefBase
 {
 public:
@@ -275,6 +385,8 @@ public:
         mMetadata.analog_gain = 0;
         mMetadata.exposure_time = 0;
 #endif
+        mFaceStorage = NULL;
+        mFaceCapacity = 0;
     };
 #endif
 
@@ -289,12 +401,25 @@ public:
 #ifdef OMAP_ENHANCEMENT_CPCAM
         mExtendedMetadata = NULL;
 #endif
+        mFaceStorage = NULL;
+        mFaceCapacity = 0;
    }
 
+    ///faceStorage stays owned by the caller and is reused across reset()
+    CameraMetadataResult(camera_face_t *faceStorage, size_t faceCapacity) {
+        mMetadata.faces = NULL;
+        mMetadata.number_of_faces = 0;
+#ifdef OMAP_ENHANCEMENT_CPCAM
+        mMetadata.analog_gain = 0;
+        mMetadata.exposure_time = 0;
+        mExtendedMetadata = NULL;
+#endif
+        mFaceStorage = faceStorage;
+        mFaceCapacity = faceCapacity;
+    }
+
     virtual ~CameraMetadataResult() {
-        if ( NULL != mMetadata.faces ) {
-            free(mMetadata.faces);
-        }
+        releaseFaces();
 #ifdef OMAP_ENHANCEMENT_CPCAM
         if ( NULL != mExtendedMetadata ) {
             mExtendedMetadata->release(mExtendedMetadata);
@@ -304,6 +429,19 @@ public:
 
     camera_frame_metadata_t *getMetadataResult() { return &mMetadata; };
 
+    camera_face_t *getFaceStorage() { return mFaceStorage; };
+    size_t getFaceCapacity() const { return mFaceCapacity; };
+
+    void reset() {
+        releaseFaces();
+        mMetadata.faces = NULL;
+        mMetadata.number_of_faces = 0;
+#ifdef OMAP_ENHANCEMENT_CPCAM
+        mMetadata.analog_gain = 0;
+        mMetadata.exposure_time = 0;
+#endif
+    }
+
 #ifdef OMAP_ENHANCEMENT_CPCAM
     camera_memory_t *getExtendedMetadata() { return mExtendedMetadata; };
 #endif
@@ -316,10 +454,18 @@ public:
 
 private:
 
+    void releaseFaces() {
+        if ( ( NULL != mMetadata.faces ) && ( mFaceStorage != mMetadata.faces ) ) {
+            free(mMetadata.faces);
+        }
+    }
+
     camera_frame_metadata_t mMetadata;
 #ifdef OMAP_ENHANCEMENT_CPCAM
     camera_memory_t *mExtendedMetadata;
 #endif
+    camera_face_t *mFaceStorage;
+    size_t mFaceCapacity;
 };
 
 typedef enum {
@@ -857,9 +1003,29 @@ public:
     virtual int getFd() ;
     virtual int freeBufferList(CameraBuffer * buflist);
 
+    ///Releases every buffer list parked in the reuse pool, returns the bytes freed
+    size_t trimPool();
+
 private:
+    ///Freed buffer list kept mapped for reuse by a matching allocation
+    struct PooledList {
+        CameraBuffer *buffers;
+        int numBufs;
+        int size;
+        const char *format;
+    };
+
+    void releaseBufferList(CameraBuffer *buffers);
+    CameraBuffer *takePooledList(int size, const char *format, int numBufs);
+    bool poolBufferList(CameraBuffer *buffers);
+
     android::sp<ErrorNotifier> mErrorNotifier;
     int mIonFd;
+
+    android::Mutex mPoolLock;
+    android::Vector<PooledList> mPool;
+    size_t mPoolBytes;
+    size_t mPoolMaxBytes;
 };
 
 
@@ -986,7 +1152,7 @@ public:
 
     //APIs to configure Camera adapter and get the current parameter set
     virtual int setParameters(const android::CameraParameters& params) = 0;
-    virtual void getParameters(android::CameraParameters& params) = 0;
+    virtual void getParameters(CameraHalParameters& params) = 0;
 
     //Registers callback for returning image buffers back to CameraHAL
     virtual int registerImageReleaseCallback(release_image_buffers_callback callback, void *user_data) = 0;
@@ -1334,6 +1500,9 @@ private:
     /** @name internalFunctionsPrivate */
     //@{
 
+    /** Applies the camera parameters, skipping a repeat of the last applied string. */
+    int         applyParameters(android::CameraParameters& params, const android::String8 *flattened);
+
     /**  Set the camera parameters specific to Video Recording. */
     bool        setVideoModeParameters(const android::CameraParameters&);
 
@@ -1375,18 +1544,9 @@ private:
     /** Free RAW bufs */
     status_t freeRawBufs();
 
-    //Check if a given resolution is supported by the current camera
-    //instance
-    bool isResolutionValid(unsigned int width, unsigned int height, const char *supportedResolutions);
-
-    //Check if a given variable frame rate range is supported by the current camera
-    //instance
-    bool isFpsRangeValid(int fpsMin, int fpsMax, const char *supportedFpsRanges);
-
-    //Check if a given parameter is supported by the current camera
-    // instance
-    bool isParameterValid(const char *param, const char *supportedParams);
-    bool isParameterValid(int param, const char *supportedParams);
+    //Parse the capability lists used to validate parameters, for every
+    //operating mode of the current camera instance
+    void initCapabilitySets();
     status_t doesSetParameterNeedUpdate(const char *new_param, const char *old_params, bool &update);
 
     /** Initialize default parameters */
@@ -1503,7 +1663,23 @@ private:
 
     void* mCameraAdapterHandle;
 
-    android::CameraParameters mParameters;
+    CameraHalParameters mParameters;
+
+    ///Client string last built by getParameters(), and the generation it was built from
+    android::Mutex mParametersCacheLock;
+    char *mParametersCache;
+    uint32_t mParametersCacheGeneration;
+    int mParametersCacheVideoWidth;
+    int mParametersCacheVideoHeight;
+
+    ///What the last successful setParameters(const char*) applied, to skip exact repeats
+    struct AppliedParameters {
+        android::String8 mParams;
+        uint32_t mGeneration;
+        bool mPreviewEnabled;
+        int32_t mMsgEnabled;
+    } mAppliedParameters;
+
     bool mPreviewRunning;
     bool mPreviewStateOld;
     bool mRecordingEnabled;
@@ -1537,6 +1713,27 @@ private:
 
     CameraProperties::Properties* mCameraProperties;
 
+    ///Capabilities checked by setParameters(), parsed once at initialize()
+    struct CapabilitySets {
+        SupportedValues previewFormats;
+        SupportedValues ippModes;
+        SupportedValues focusModes;
+        SupportedValues pictureFormats;
+        SupportedValues exposureModes;
+        SupportedValues whiteBalance;
+        SupportedValues antibanding;
+        SupportedValues isoModes;
+        SupportedValues sceneModes;
+        SupportedValues flashModes;
+        SupportedValues effects;
+        SupportedValues frameRates;
+        SupportedResolutions previewSizes;
+        SupportedResolutions pictureSizes;
+        SupportedFpsRanges fpsRanges;
+    };
+
+    CapabilitySets mCapabilitySets[MODE_MAX];
+
     bool mPreviewStartInProgress;
     bool mPreviewInitializationDone;
 
@@ -55,137 +55,150 @@ enum OperatingMode {
     MODE_MAX
 };
 
+// Every capability key: identifier and the name it is stored under
+#define CAMERA_PROPERTY_KEYS(KEY) \
+    KEY(INVALID, "prop-invalid-key") \
+    KEY(CAMERA_NAME, "prop-camera-name") \
+    KEY(CAMERA_SENSOR_INDEX, "prop-sensor-index") \
+    KEY(CAMERA_SENSOR_ID, "prop-sensor-id") \
+    KEY(ORIENTATION_INDEX, "prop-orientation") \
+    KEY(FACING_INDEX, "prop-facing") \
+    KEY(SUPPORTED_PREVIEW_SIZES, "prop-preview-size-values") \
+    KEY(SUPPORTED_PREVIEW_SUBSAMPLED_SIZES, "prop-preview-subsampled-size-values") \
+    KEY(SUPPORTED_PREVIEW_TOPBOTTOM_SIZES, "prop-preview-topbottom-size-values") \
+    KEY(SUPPORTED_PREVIEW_SIDEBYSIDE_SIZES, "prop-preview-sidebyside-size-values") \
+    KEY(SUPPORTED_PREVIEW_FORMATS, "prop-preview-format-values") \
+    KEY(SUPPORTED_PREVIEW_FRAME_RATES, "prop-preview-frame-rate-values") \
+    KEY(SUPPORTED_PREVIEW_FRAME_RATES_EXT, "prop-preview-frame-rate-ext-values") \
+    KEY(SUPPORTED_PICTURE_SIZES, "prop-picture-size-values") \
+    KEY(SUPPORTED_PICTURE_SUBSAMPLED_SIZES, "prop-picture-subsampled-size-values") \
+    KEY(SUPPORTED_PICTURE_TOPBOTTOM_SIZES, "prop-picture-topbottom-size-values") \
+    KEY(SUPPORTED_PICTURE_SIDEBYSIDE_SIZES, "prop-picture-sidebyside-size-values") \
+    KEY(SUPPORTED_PICTURE_FORMATS, "prop-picture-format-values") \
+    KEY(SUPPORTED_THUMBNAIL_SIZES, "prop-jpeg-thumbnail-size-values") \
+    KEY(SUPPORTED_WHITE_BALANCE, "prop-whitebalance-values") \
+    KEY(SUPPORTED_EFFECTS, "prop-effect-values") \
+    KEY(SUPPORTED_ANTIBANDING, "prop-antibanding-values") \
+    KEY(SUPPORTED_EXPOSURE_MODES, "prop-exposure-mode-values") \
+    KEY(SUPPORTED_MANUAL_EXPOSURE_MIN, "prop-manual-exposure-min") \
+    KEY(SUPPORTED_MANUAL_EXPOSURE_MAX, "prop-manual-exposure-max") \
+    KEY(SUPPORTED_MANUAL_EXPOSURE_STEP, "prop-manual-exposure-step") \
+    KEY(SUPPORTED_MANUAL_GAIN_ISO_MIN, "prop-manual-gain-iso-min") \
+    KEY(SUPPORTED_MANUAL_GAIN_ISO_MAX, "prop-manual-gain-iso-max") \
+    KEY(SUPPORTED_MANUAL_GAIN_ISO_STEP, "prop-manual-gain-iso-step") \
+    KEY(SUPPORTED_EV_MAX, "prop-ev-compensation-max") \
+    KEY(SUPPORTED_EV_MIN, "prop-ev-compensation-min") \
+    KEY(SUPPORTED_EV_STEP, "prop-ev-compensation-step") \
+    KEY(SUPPORTED_ISO_VALUES, "prop-iso-mode-values") \
+    KEY(SUPPORTED_SCENE_MODES, "prop-scene-mode-values") \
+    KEY(SUPPORTED_FLASH_MODES, "prop-flash-mode-values") \
+    KEY(SUPPORTED_FOCUS_MODES, "prop-focus-mode-values") \
+    KEY(REQUIRED_PREVIEW_BUFS, "prop-required-preview-bufs") \
+    KEY(REQUIRED_IMAGE_BUFS, "prop-required-image-bufs") \
+    KEY(SUPPORTED_ZOOM_RATIOS, "prop-zoom-ratios") \
+    KEY(SUPPORTED_ZOOM_STAGES, "prop-zoom-stages") \
+    KEY(SUPPORTED_IPP_MODES, "prop-ipp-values") \
+    KEY(SMOOTH_ZOOM_SUPPORTED, "prop-smooth-zoom-supported") \
+    KEY(ZOOM_SUPPORTED, "prop-zoom-supported") \
+    KEY(PREVIEW_SIZE, "prop-preview-size-default") \
+    KEY(PREVIEW_FORMAT, "prop-preview-format-default") \
+    KEY(PREVIEW_FRAME_RATE, "prop-preview-frame-rate-default") \
+    KEY(ZOOM, "prop-zoom-default") \
+    KEY(PICTURE_SIZE, "prop-picture-size-default") \
+    KEY(PICTURE_FORMAT, "prop-picture-format-default") \
+    KEY(JPEG_THUMBNAIL_SIZE, "prop-jpeg-thumbnail-size-default") \
+    KEY(WHITEBALANCE, "prop-whitebalance-default") \
+    KEY(EFFECT, "prop-effect-default") \
+    KEY(ANTIBANDING, "prop-antibanding-default") \
+    KEY(EXPOSURE_MODE, "prop-exposure-mode-default") \
+    KEY(EV_COMPENSATION, "prop-ev-compensation-default") \
+    KEY(ISO_MODE, "prop-iso-mode-default") \
+    KEY(FOCUS_MODE, "prop-focus-mode-default") \
+    KEY(SCENE_MODE, "prop-scene-mode-default") \
+    KEY(FLASH_MODE, "prop-flash-mode-default") \
+    KEY(JPEG_QUALITY, "prop-jpeg-quality-default") \
+    KEY(CONTRAST, "prop-contrast-default") \
+    KEY(BRIGHTNESS, "prop-brightness-default") \
+    KEY(SATURATION, "prop-saturation-default") \
+    KEY(SHARPNESS, "prop-sharpness-default") \
+    KEY(IPP, "prop-ipp-default") \
+    KEY(GBCE, "prop-gbce-default") \
+    KEY(SUPPORTED_GBCE, "prop-gbce-supported") \
+    KEY(GLBCE, "prop-glbce-default") \
+    KEY(SUPPORTED_GLBCE, "prop-glbce-supported") \
+    KEY(S3D_PRV_FRAME_LAYOUT, "prop-s3d-prv-frame-layout") \
+    KEY(S3D_PRV_FRAME_LAYOUT_VALUES, "prop-s3d-prv-frame-layout-values") \
+    KEY(S3D_CAP_FRAME_LAYOUT, "prop-s3d-cap-frame-layout") \
+    KEY(S3D_CAP_FRAME_LAYOUT_VALUES, "prop-s3d-cap-frame-layout-values") \
+    KEY(AUTOCONVERGENCE_MODE, "prop-auto-convergence-mode") \
+    KEY(AUTOCONVERGENCE_MODE_VALUES, "prop-auto-convergence-mode-values") \
+    KEY(MANUAL_CONVERGENCE, "prop-manual-convergence") \
+    KEY(SUPPORTED_MANUAL_CONVERGENCE_MIN, "prop-supported-manual-convergence-min") \
+    KEY(SUPPORTED_MANUAL_CONVERGENCE_MAX, "prop-supported-manual-convergence-max") \
+    KEY(SUPPORTED_MANUAL_CONVERGENCE_STEP, "prop-supported-manual-convergence-step") \
+    KEY(VSTAB, "prop-vstab-default") \
+    KEY(VSTAB_SUPPORTED, "prop-vstab-supported") \
+    KEY(VNF, "prop-vnf-default") \
+    KEY(VNF_SUPPORTED, "prop-vnf-supported") \
+    KEY(REVISION, "prop-revision") \
+    KEY(FOCAL_LENGTH, "prop-focal-length") \
+    KEY(HOR_ANGLE, "prop-horizontal-angle") \
+    KEY(VER_ANGLE, "prop-vertical-angle") \
+    KEY(FRAMERATE_RANGE, "prop-framerate-range-default") \
+    KEY(FRAMERATE_RANGE_SUPPORTED, "prop-framerate-range-values") \
+    KEY(FRAMERATE_RANGE_EXT_SUPPORTED, "prop-framerate-range-ext-values") \
+    KEY(SENSOR_ORIENTATION, "sensor-orientation") \
+    KEY(SENSOR_ORIENTATION_VALUES, "sensor-orientation-values") \
+    KEY(EXIF_MAKE, "prop-exif-make") \
+    KEY(EXIF_MODEL, "prop-exif-model") \
+    KEY(JPEG_THUMBNAIL_QUALITY, "prop-jpeg-thumbnail-quality-default") \
+    KEY(MAX_FOCUS_AREAS, "prop-max-focus-areas") \
+    KEY(MAX_FD_HW_FACES, "prop-max-fd-hw-faces") \
+    KEY(MAX_FD_SW_FACES, "prop-max-fd-sw-faces") \
+    KEY(AUTO_EXPOSURE_LOCK, "prop-auto-exposure-lock") \
+    KEY(AUTO_EXPOSURE_LOCK_SUPPORTED, "prop-auto-exposure-lock-supported") \
+    KEY(AUTO_WHITEBALANCE_LOCK, "prop-auto-whitebalance-lock") \
+    KEY(AUTO_WHITEBALANCE_LOCK_SUPPORTED, "prop-auto-whitebalance-lock-supported") \
+    KEY(MAX_NUM_METERING_AREAS, "prop-max-num-metering-areas") \
+    KEY(METERING_AREAS, "prop-metering-areas") \
+    KEY(VIDEO_SNAPSHOT_SUPPORTED, "prop-video-snapshot-supported") \
+    KEY(VIDEO_SIZE, "video-size") \
+    KEY(SUPPORTED_VIDEO_SIZES, "video-size-values") \
+    KEY(MECHANICAL_MISALIGNMENT_CORRECTION_SUPPORTED, "prop-mechanical-misalignment-correction-supported") \
+    KEY(MECHANICAL_MISALIGNMENT_CORRECTION, "prop-mechanical-misalignment-correction") \
+    KEY(CAP_MODE_VALUES, "prop-mode-values") \
+    KEY(RAW_WIDTH, "prop-raw-width-values") \
+    KEY(RAW_HEIGHT, "prop-raw-height-values") \
+    KEY(MAX_PICTURE_WIDTH, "prop-max-picture-width") \
+    KEY(MAX_PICTURE_HEIGHT, "prop-max-picture-height")
+
 // Class that handles the Camera Properties
 class CameraProperties
 {
 public:
-    static const char INVALID[];
-    static const char CAMERA_NAME[];
-    static const char CAMERA_SENSOR_INDEX[];
-    static const char CAMERA_SENSOR_ID[];
-    static const char ORIENTATION_INDEX[];
-    static const char FACING_INDEX[];
-    static const char SUPPORTED_PREVIEW_SIZES[];
-    static const char SUPPORTED_PREVIEW_SUBSAMPLED_SIZES[];
-    static const char SUPPORTED_PREVIEW_TOPBOTTOM_SIZES[];
-    static const char SUPPORTED_PREVIEW_SIDEBYSIDE_SIZES[];
-    static const char SUPPORTED_PREVIEW_FORMATS[];
-    static const char SUPPORTED_PREVIEW_FRAME_RATES[];
-    static const char SUPPORTED_PREVIEW_FRAME_RATES_EXT[];
-    static const char SUPPORTED_PICTURE_SIZES[];
-    static const char SUPPORTED_PICTURE_SUBSAMPLED_SIZES[];
-    static const char SUPPORTED_PICTURE_TOPBOTTOM_SIZES[];
-    static const char SUPPORTED_PICTURE_SIDEBYSIDE_SIZES[];
-    static const char SUPPORTED_PICTURE_FORMATS[];
-    static const char SUPPORTED_THUMBNAIL_SIZES[];
-    static const char SUPPORTED_WHITE_BALANCE[];
-    static const char SUPPORTED_EFFECTS[];
-    static const char SUPPORTED_ANTIBANDING[];
-    static const char SUPPORTED_EXPOSURE_MODES[];
-    static const char SUPPORTED_MANUAL_EXPOSURE_MIN[];
-    static const char SUPPORTED_MANUAL_EXPOSURE_MAX[];
-    static const char SUPPORTED_MANUAL_EXPOSURE_STEP[];
-    static const char SUPPORTED_MANUAL_GAIN_ISO_MIN[];
-    static const char SUPPORTED_MANUAL_GAIN_ISO_MAX[];
-    static const char SUPPORTED_MANUAL_GAIN_ISO_STEP[];
-    static const char SUPPORTED_EV_MIN[];
-    static const char SUPPORTED_EV_MAX[];
-    static const char SUPPORTED_EV_STEP[];
-    static const char SUPPORTED_ISO_VALUES[];
-    static const char SUPPORTED_SCENE_MODES[];
-    static const char SUPPORTED_FLASH_MODES[];
-    static const char SUPPORTED_FOCUS_MODES[];
-    static const char REQUIRED_PREVIEW_BUFS[];
-    static const char REQUIRED_IMAGE_BUFS[];
-    static const char SUPPORTED_ZOOM_RATIOS[];
-    static const char SUPPORTED_ZOOM_STAGES[];
-    static const char SUPPORTED_IPP_MODES[];
-    static const char SMOOTH_ZOOM_SUPPORTED[];
-    static const char ZOOM_SUPPORTED[];
-    static const char PREVIEW_SIZE[];
-    static const char PREVIEW_FORMAT[];
-    static const char PREVIEW_FRAME_RATE[];
-    static const char ZOOM[];
-    static const char PICTURE_SIZE[];
-    static const char PICTURE_FORMAT[];
-    static const char JPEG_THUMBNAIL_SIZE[];
-    static const char WHITEBALANCE[];
-    static const char EFFECT[];
-    static const char ANTIBANDING[];
-    static const char EXPOSURE_MODE[];
-    static const char EV_COMPENSATION[];
-    static const char ISO_MODE[];
-    static const char FOCUS_MODE[];
-    static const char SCENE_MODE[];
-    static const char FLASH_MODE[];
-    static const char JPEG_QUALITY[];
-    static const char BRIGHTNESS[];
-    static const char SATURATION[];
-    static const char SHARPNESS[];
-    static const char CONTRAST[];
-    static const char IPP[];
-    static const char GBCE[];
-    static const char SUPPORTED_GBCE[];
-    static const char GLBCE[];
-    static const char SUPPORTED_GLBCE[];
-    static const char AUTOCONVERGENCE_MODE[];
-    static const char AUTOCONVERGENCE_MODE_VALUES[];
-    static const char MANUAL_CONVERGENCE[];
-    static const char SUPPORTED_MANUAL_CONVERGENCE_MIN[];
-    static const char SUPPORTED_MANUAL_CONVERGENCE_MAX[];
-    static const char SUPPORTED_MANUAL_CONVERGENCE_STEP[];
-    static const char SENSOR_ORIENTATION[];
-    static const char SENSOR_ORIENTATION_VALUES[];
-    static const char REVISION[];
-    static const char FOCAL_LENGTH[];
-    static const char HOR_ANGLE[];
-    static const char VER_ANGLE[];
-    static const char EXIF_MAKE[];
-    static const char EXIF_MODEL[];
-    static const char JPEG_THUMBNAIL_QUALITY[];
-    static const char MAX_FOCUS_AREAS[];
-    static const char MAX_FD_HW_FACES[];
-    static const char MAX_FD_SW_FACES[];
-
-    static const char MAX_PICTURE_WIDTH[];
-    static const char MAX_PICTURE_HEIGHT[];
-
-    static const char PARAMS_DELIMITER [];
-
-    static const char S3D_PRV_FRAME_LAYOUT[];
-    static const char S3D_PRV_FRAME_LAYOUT_VALUES[];
-    static const char S3D_CAP_FRAME_LAYOUT[];
-    static const char S3D_CAP_FRAME_LAYOUT_VALUES[];
-    static const char VSTAB[];
-    static const char VSTAB_SUPPORTED[];
-    static const char VNF[];
-    static const char VNF_SUPPORTED[];
-    static const char FRAMERATE_RANGE[];
-    static const char FRAMERATE_RANGE_SUPPORTED[];
-    static const char FRAMERATE_RANGE_EXT_SUPPORTED[];
-
-    static const char DEFAULT_VALUE[];
-
-    static const char AUTO_EXPOSURE_LOCK[];
-    static const char AUTO_EXPOSURE_LOCK_SUPPORTED[];
-    static const char AUTO_WHITEBALANCE_LOCK[];
-    static const char AUTO_WHITEBALANCE_LOCK_SUPPORTED[];
-    static const char MAX_NUM_METERING_AREAS[];
-    static const char METERING_AREAS[];
-    static const char MAX_NUM_FOCUS_AREAS[];
-
-    static const char VIDEO_SNAPSHOT_SUPPORTED[];
+    ///Interned property key. Indexes straight into the value table of
+    ///Properties; converts to its name wherever a string is expected.
+    struct PropertyKey
+    {
+        int index;
+        const char *name;
 
-    static const char VIDEO_SIZE[];
-    static const char SUPPORTED_VIDEO_SIZES[];
+        operator const char*() const { return name; }
+    };
 
-    static const char MECHANICAL_MISALIGNMENT_CORRECTION_SUPPORTED[];
-    static const char MECHANICAL_MISALIGNMENT_CORRECTION[];
+    enum PropertyIndex {
+#define CAMERA_PROPERTY_INDEX(key, name) PROP_##key,
+        CAMERA_PROPERTY_KEYS(CAMERA_PROPERTY_INDEX)
+#undef CAMERA_PROPERTY_INDEX
+        PROPERTY_KEY_MAX
+    };
 
-    static const char RAW_WIDTH[];
-    static const char RAW_HEIGHT[];
+#define CAMERA_PROPERTY_DECLARE(key, name) static const PropertyKey key;
+    CAMERA_PROPERTY_KEYS(CAMERA_PROPERTY_DECLARE)
+#undef CAMERA_PROPERTY_DECLARE
 
-    static const char CAP_MODE_VALUES[];
+    static const char PARAMS_DELIMITER [];
+    static const char DEFAULT_VALUE[];
 
     CameraProperties();
     ~CameraProperties();
@@ -203,6 +216,12 @@ public:
             {
             }
 
+            void set(const PropertyKey &key, const char *value);
+            void set(const PropertyKey &key, int value);
+            const char* get(const PropertyKey &key) const;
+            int getInt(const PropertyKey &key) const;
+
+            ///String-keyed access, kept for keys that are not in CAMERA_PROPERTY_KEYS
             void set(const char *prop, const char *value);
             void set(const char *prop, int value);
             const char* get(const char * prop) const;
@@ -212,13 +231,32 @@ public:
             OperatingMode getMode() const;
             void dump();
 
+            ///Appends every mode's properties to blob, used by the capability cache
+            void flatten(android::String8 &blob) const;
+            ///Restores what flatten() wrote, advancing data. Returns false on malformed input
+            bool unflatten(const char *&data, const char *end);
+
         protected:
             const char* keyAt(const unsigned int) const;
             const char* valueAt(const unsigned int) const;
 
         private:
+            ///Value of one known key, integer form parsed once on set
+            struct Value
+            {
+                Value() : mInt(-1), mPresent(false) { }
+
+                android::String8 mString;
+                int mInt;
+                bool mPresent;
+            };
+
+            void setValue(int mode, int index, const char *value, int intValue);
+            size_t count(int mode) const;
+
             OperatingMode mCurrentMode;
-            android::DefaultKeyedVector<android::String8, android::String8> mProperties[MODE_MAX];
+            Value mValues[MODE_MAX][PROPERTY_KEY_MAX];
+            android::DefaultKeyedVector<android::String8, android::String8> mExtraProperties[MODE_MAX];
 
     };
 
@@ -229,6 +267,8 @@ public:
     int getProperties(int cameraIndex, Properties** properties);
 
 private:
+    bool loadCachedProperties(const char *fingerprint);
+    void saveCachedProperties(const char *fingerprint) const;
 
     int mCamerasSupported;
     int mInitialized;
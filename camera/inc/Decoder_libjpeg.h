@@ -40,14 +40,17 @@ public:
     static int readDHTSize();
     static bool isDhtExist(unsigned char *jpeg_src,  int filled_len);
     static int appendDHT(unsigned char *jpeg_src, int filled_len, unsigned char *jpeg_with_dht_buffer, int buff_size);
-    bool decode(unsigned char *jpeg_src, int filled_len, unsigned char *nv12_buffer, int stride);
+    // When insertDht is set the standard MJPEG Huffman tables are fed to
+    // libjpeg ahead of the frame, no copy of jpeg_src is made.
+    bool decode(unsigned char *jpeg_src, int filled_len, unsigned char *nv12_buffer, int stride,
+                bool insertDht = false);
 
 private:
     void release();
-    unsigned char **Y_Plane;
-    unsigned char **U_Plane;
-    unsigned char **V_Plane;
-    unsigned char *UV_Plane;
+    // Chroma rows of one iMCU row, interleaved into NV12 right after decoding
+    unsigned char *mChromaRows;
+    // Sink for rows libjpeg emits below the image height
+    unsigned char *mDummyRow;
     unsigned int mWidth, mHeight;
 };
 
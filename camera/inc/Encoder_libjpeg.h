@@ -47,6 +47,7 @@ namespace Camera {
  */
 
 #define MAX_EXIF_TAGS_SUPPORTED 30
+#define MAX_EXIF_VALUES_SIZE 2048
 typedef void (*encoder_libjpeg_callback_t) (void* main_jpeg,
                                             void* thumb_jpeg,
                                             CameraFrame::FrameType type,
@@ -97,7 +98,7 @@ class ExifElementsTable {
     public:
         ExifElementsTable() :
            gps_tag_count(0), exif_tag_count(0), position(0),
-           jpeg_opened(false)
+           values_size(0), jpeg_opened(false)
         {
 #ifdef ANDROID_API_JB_OR_LATER
             has_datetime_tag = false;
@@ -106,6 +107,9 @@ class ExifElementsTable {
         ~ExifElementsTable();
 
         status_t insertElement(const char* tag, const char* value);
+        ///Replaces the contents with a copy of tmpl, values included
+        void copyFrom(const ExifElementsTable& tmpl);
+        void clear();
         void insertExifToJpeg(unsigned char* jpeg, size_t jpeg_size);
         status_t insertExifThumbnailImage(const char*, int);
         void saveJpeg(unsigned char* picture, size_t jpeg_size);
@@ -117,6 +121,9 @@ class ExifElementsTable {
         unsigned int gps_tag_count;
         unsigned int exif_tag_count;
         unsigned int position;
+        // element values are packed here so a table copies with two memcpy
+        char values[MAX_EXIF_VALUES_SIZE];
+        unsigned int values_size;
         bool jpeg_opened;
 #ifdef ANDROID_API_JB_OR_LATER
         bool has_datetime_tag;
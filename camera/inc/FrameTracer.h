@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_TRACER_H
+#define FRAME_TRACER_H
+
+#ifdef CAMERAHAL_FRAME_TRACE
+
+#include <stdint.h>
+#include <cutils/atomic.h>
+#include <utils/Timers.h>
+
+namespace Ti {
+namespace Camera {
+
+/**
+ * Records one timestamp per pipeline stage for every preview frame, keyed by
+ * the CameraBuffer the frame travels in. Recording is a single atomic
+ * increment plus a seqlock style write of one slot; all the matching of
+ * stages into per-frame latencies is done by dump().
+ */
+class FrameTracer
+{
+public:
+    enum Stage {
+        STAGE_FILL_BUFFER_DONE = 0,
+        STAGE_DISPATCH,
+        STAGE_APP_CALLBACK,
+        STAGE_DISPLAY_POST,
+        STAGE_DISPLAY_ENQUEUE,
+        STAGE_RETURN,
+        STAGE_MAX
+    };
+
+    ///Number of events kept, must be a power of two
+    static const int32_t RING_SIZE = 1024;
+
+    static FrameTracer& instance() { return sInstance; }
+
+    void record(const void *key, Stage stage)
+    {
+        const int32_t seq = android_atomic_inc(&mNext);
+        Event &event = mEvents[seq & (RING_SIZE - 1)];
+        // Mark the slot as being written so dump() skips a torn event
+        android_atomic_acquire_store(0, &event.mSeq);
+        event.mKey = key;
+        event.mStage = stage;
+        event.mTimestamp = systemTime(SYSTEM_TIME_MONOTONIC);
+        android_atomic_release_store(seq + 1, &event.mSeq);
+    }
+
+    ///Writes p50/p99 latency per stage, measured from FillBufferDone
+    void dump(int fd) const;
+
+private:
+    struct Event {
+        volatile int32_t mSeq;
+        const void *mKey;
+        int mStage;
+        nsecs_t mTimestamp;
+    };
+
+    static FrameTracer sInstance;
+
+    Event mEvents[RING_SIZE];
+    volatile int32_t mNext;
+};
+
+} // namespace Camera
+} // namespace Ti
+
+#define CAMHAL_TRACE_FRAME(key, stage) \
+    Ti::Camera::FrameTracer::instance().record((key), Ti::Camera::FrameTracer::stage)
+
+#else
+
+#define CAMHAL_TRACE_FRAME(key, stage)
+
+#endif //CAMERAHAL_FRAME_TRACE
+
+#endif //FRAME_TRACER_H
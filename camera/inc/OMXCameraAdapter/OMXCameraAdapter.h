@@ -209,6 +209,9 @@ public:
     ///Five second timeout
     static const int CAMERA_ADAPTER_TIMEOUT = 5000*1000;
 
+    ///OMX_ALGOAREASTYPE rounded up to a whole page for the shared buffer
+    static const int ALGO_AREAS_BUFFER_SIZE = ((sizeof(OMX_ALGOAREASTYPE) + 4095) / 4096) * 4096;
+
     enum CaptureMode
         {
         INITIAL_MODE = -1,
@@ -362,6 +365,52 @@ public:
             };
     };
 
+    ///Extradata blocks attached to one filled buffer. The metadata chain is
+    ///walked once, on the first lookup, and blocks are then found by type.
+    class ExtradataIndex
+    {
+        public:
+            explicit ExtradataIndex(const OMX_PTR platformPrivate);
+
+            OMX_OTHER_EXTRADATATYPE *find(OMX_EXTRADATATYPE type) const;
+
+        private:
+            enum { MAX_ENTRIES = 16 };
+
+            void parse() const;
+            OMX_OTHER_EXTRADATATYPE *walk(OMX_OTHER_EXTRADATATYPE *extraData,
+                                          OMX_U32 remainingSize,
+                                          OMX_EXTRADATATYPE type) const;
+
+            const OMX_PTR mPlatformPrivate;
+            mutable bool mParsed;
+            mutable int mCount;
+            mutable OMX_EXTRADATATYPE mTypes[MAX_ENTRIES];
+            mutable OMX_OTHER_EXTRADATATYPE *mEntries[MAX_ENTRIES];
+
+            ///Rest of the chain when it has more than MAX_ENTRIES blocks
+            mutable OMX_OTHER_EXTRADATATYPE *mOverflow;
+            mutable OMX_U32 mOverflowSize;
+    };
+
+    ///Preview metadata results with face arrays for MAX_NUM_FACES_SUPPORTED.
+    ///A slot is reused once the pool holds the only reference to it.
+    class FaceMetadataPool
+    {
+        public:
+            enum { POOL_SIZE = 8 };
+
+            FaceMetadataPool();
+
+            android::sp<CameraMetadataResult> acquire();
+
+        private:
+            android::Mutex mLock;
+            size_t mNext;
+            android::sp<CameraMetadataResult> mResults[POOL_SIZE];
+            camera_face_t mFaces[POOL_SIZE][MAX_NUM_FACES_SUPPORTED];
+    };
+
     ///Context of the OMX Camera component
     class OMXCameraAdapterComponentContext
     {
@@ -401,7 +450,7 @@ public:
 
     //APIs to configure Camera adapter and get the current parameter set
     virtual status_t setParameters(const android::CameraParameters& params);
-    virtual void getParameters(android::CameraParameters& params);
+    virtual void getParameters(CameraHalParameters& params);
 
     // API
     status_t UseBuffersPreview(CameraBuffer *bufArr, int num);
@@ -509,6 +558,7 @@ private:
     status_t setupEXIF();
     status_t setupEXIF_libjpeg(ExifElementsTable*, OMX_TI_ANCILLARYDATATYPE*,
                                OMX_TI_WHITEBALANCERESULTTYPE*);
+    status_t setupEXIFTemplate(const OMXCameraPortParameters *capData);
 
     //Focus functionality
     status_t doAutoFocus();
@@ -525,7 +575,7 @@ private:
     status_t addFocusDistances(OMX_U32 &near,
                                OMX_U32 &optimal,
                                OMX_U32 &far,
-                               android::CameraParameters& params);
+                               CameraHalParameters& params);
     status_t encodeFocusDistance(OMX_U32 dist, char *buffer, size_t length);
     status_t getFocusDistances(OMX_U32 &near,OMX_U32 &optimal, OMX_U32 &far);
 
@@ -541,6 +591,7 @@ private:
 #endif
     status_t doZoom(int index);
     status_t advanceZoom();
+    unsigned int getSmoothZoomIdx(nsecs_t now) const;
 
     //3A related parameters
     status_t setParameters3A(const android::CameraParameters &params,
@@ -576,6 +627,7 @@ private:
     status_t setISO(Gen3A_settings& Gen3A);
     status_t setEffect(Gen3A_settings& Gen3A);
     status_t setMeteringAreas(Gen3A_settings& Gen3A);
+    CameraBuffer *getAlgoAreasBuffer();
 
     //TI extensions for enable/disable algos
     status_t setParameter3ABool(const OMX_INDEXTYPE omx_idx,
@@ -637,18 +689,20 @@ private:
     //Face detection
     status_t setParametersFD(const android::CameraParameters &params,
                              BaseCameraAdapter::AdapterState state);
-    status_t updateFocusDistances(android::CameraParameters &params);
+    status_t updateFocusDistances(CameraHalParameters &params);
     status_t setFaceDetectionOrientation(OMX_U32 orientation);
     status_t setFaceDetection(bool enable, OMX_U32 orientation);
-    status_t createPreviewMetadata(OMX_BUFFERHEADERTYPE* pBuffHeader,
+    status_t createPreviewMetadata(const ExtradataIndex &extradata,
                          android::sp<CameraMetadataResult> &result,
                          size_t previewWidth,
                          size_t previewHeight);
     status_t encodeFaceCoordinates(const OMX_FACEDETECTIONTYPE *faceData,
-                                   camera_frame_metadata_t *metadataResult,
+                                   CameraMetadataResult *result,
                                    size_t previewWidth,
                                    size_t previewHeight);
-    status_t encodePreviewMetadata(camera_frame_metadata_t *meta, const OMX_PTR plat_pvt);
+    static void encodeFaceRect(OMX_S32 left, OMX_S32 top, OMX_S32 width, OMX_S32 height,
+                               size_t previewWidth, size_t previewHeight, int32_t *rect);
+    status_t encodePreviewMetadata(camera_frame_metadata_t *meta, const ExtradataIndex &extradata);
 
     void pauseFaceDetection(bool pause);
 
@@ -772,11 +826,10 @@ private:
     status_t setAutoConvergence(const char *valstr, const char *pValManualstr, const android::CameraParameters &params);
 
     status_t setExtraData(bool enable, OMX_U32, OMX_EXT_EXTRADATATYPE);
-    OMX_OTHER_EXTRADATATYPE *getExtradata(const OMX_PTR ptrPrivate, OMX_EXTRADATATYPE type) const;
 
     // Meta data
 #ifdef OMAP_ENHANCEMENT_CPCAM
-    camera_memory_t * getMetaData(const OMX_PTR plat_pvt,
+    camera_memory_t * getMetaData(const ExtradataIndex &extradata,
                                   camera_request_memory allocator) const;
 #endif
 
@@ -785,7 +838,7 @@ private:
 
     // DCC file data save
     status_t initDccFileDataSave(OMX_HANDLETYPE* omxHandle, int portIndex);
-    status_t sniffDccFileDataSave(OMX_BUFFERHEADERTYPE* pBuffHeader);
+    status_t sniffDccFileDataSave(const ExtradataIndex &extradata);
     status_t saveDccFileDataSave();
     status_t closeDccFileDataSave();
     status_t fseekDCCuseCasePos(FILE *pFile);
@@ -793,7 +846,7 @@ private:
     FILE * parseDCCsubDir(DIR *pDir, char *path);
 
 #ifdef CAMERAHAL_OMX_PROFILING
-    status_t storeProfilingData(OMX_BUFFERHEADERTYPE* pBuffHeader);
+    status_t storeProfilingData(const ExtradataIndex &extradata);
 #endif
 
     // Internal buffers
@@ -1018,17 +1071,21 @@ private:
     char mFocusDistBuffer[FOCUS_DIST_BUFFER_SIZE];
 
     // Current Focus areas
-    android::Vector<android::sp<CameraArea> > mFocusAreas;
+    CameraAreas mFocusAreas;
     mutable android::Mutex mFocusAreasLock;
 
     // Current Touch convergence areas
-    android::Vector<android::sp<CameraArea> > mTouchAreas;
+    CameraAreas mTouchAreas;
     mutable android::Mutex mTouchAreasLock;
 
     // Current Metering areas
-    android::Vector<android::sp<CameraArea> > mMeteringAreas;
+    CameraAreas mMeteringAreas;
     mutable android::Mutex mMeteringAreasLock;
 
+    // Shared buffer for OMX_TI_IndexConfigAlgoAreas, kept for the adapter lifetime
+    CameraBuffer *mAlgoAreasBuffer;
+    android::Mutex mAlgoAreasLock;
+
     OperatingMode mCapabilitiesOpMode;
     CaptureMode mCapMode;
     // TODO(XXX): Do we really need this lock? Let's
@@ -1063,12 +1120,19 @@ private:
 
     camera_face_t  faceDetectionLastOutput[MAX_NUM_FACES_SUPPORTED];
     int faceDetectionNumFacesLastOutput;
+    FaceMetadataPool mFaceMetadataPool;
     int metadataLastAnalogGain;
     int metadataLastExposureTime;
 
     //Geo-tagging
     EXIFData mEXIFData;
 
+    //EXIF tags that only change with parameters or capture resolution
+    ExifElementsTable mEXIFTemplate;
+    bool mEXIFTemplateValid;
+    OMX_U32 mEXIFTemplateWidth;
+    OMX_U32 mEXIFTemplateHeight;
+
     //Image post-processing
     IPPMode mIPP;
 
@@ -1099,6 +1163,10 @@ private:
     bool mZoomUpdating, mZoomUpdate, mPrevZoomModeIsVideo;
     int mZoomInc;
     bool mReturnZoomStatus;
+    //Smooth zoom trajectory, eased over mSmoothZoomStepTime per zoom step
+    unsigned int mSmoothZoomStartIdx;
+    nsecs_t mSmoothZoomStartTime;
+    nsecs_t mSmoothZoomStepTime;
     static const int32_t ZOOM_STEPS [];
 
      //local copy
@@ -1107,6 +1175,11 @@ private:
     unsigned int mPending3Asettings;
     android::Mutex m3ASettingsUpdateLock;
     Gen3A_settings mParameters3A;
+    //Last 3A values applied to the component, valid for the flags set in mApplied3AValid
+    Gen3A_settings mApplied3A;
+    unsigned int mApplied3AValid;
+    //OMX config calls skipped by apply3Asettings() because nothing changed
+    unsigned int m3AConfigsSaved;
     const char *mPictureFormatFromClient;
 
     BrightnessMode mGBCE;
@@ -1130,14 +1203,16 @@ private:
     //Temporal bracketing management data
     bool mBracketingSet;
     mutable android::Mutex mBracketingLock;
-    bool *mBracketingBuffersQueued;
-    int mBracketingBuffersQueuedCount;
-    int mLastBracetingBufferIdx;
+    //Filled bracketing buffers held back from the component, oldest first
+    int mBracketingHeld[MAX_NO_BUFFERS];
+    int mBracketingHeldHead;
+    int mBracketingHeldCount;
+    int mBracketingHeldMax;
     bool mBracketingEnabled;
     bool mZoomBracketingEnabled;
     size_t mBracketingRange;
     int mCurrentZoomBracketing;
-    android::CameraParameters mParameters;
+    CameraHalParameters mParameters;
 
 #ifdef CAMERAHAL_TUNA
     bool mIternalRecordingHint;
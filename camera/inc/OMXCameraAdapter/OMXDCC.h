@@ -28,13 +28,32 @@ public:
 
 private:
 
+    ///One DCC profile as found on the file system
+    struct DCCFile {
+        android::String8 path;
+        uint32_t size;
+        int64_t mtime;
+    };
+
     OMX_ERRORTYPE initDCC(OMX_HANDLETYPE hComponent);
     OMX_ERRORTYPE sendDCCBufPtr(OMX_HANDLETYPE hComponent, CameraBuffer *dccBuffer);
-    size_t readDCCdir(OMX_PTR buffer, const android::Vector<android::String8 *> &dirPaths);
+    size_t listDCCdir(const android::Vector<android::String8 *> &dirPaths,
+                      android::Vector<DCCFile> &files);
+    size_t readDCCFiles(uint8_t *buffer, const android::Vector<DCCFile> &files);
+
+    ///The packed cache holds all profiles of one URI set back to back,
+    ///preceded by the size, mtime and hash of each source file
+    bool loadDCCCache(const android::String8 &cachePath,
+                      const android::Vector<DCCFile> &files,
+                      uint8_t *buffer, size_t size);
+    void saveDCCCache(const android::String8 &cachePath,
+                      const android::Vector<DCCFile> &files,
+                      const uint8_t *buffer, size_t size);
 
 private:
 
     static android::String8 DCCPath;
+    static android::String8 DCCCachePath;
     static bool mDCCLoaded;
 };
 
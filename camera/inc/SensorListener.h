@@ -86,6 +86,13 @@ public:
     void enableSensor(sensor_type_t type);
     void disableSensor(sensor_type_t type);
     void handleOrientation(uint32_t orientation, uint32_t tilt);
+    ///Filters and quantizes a raw accelerometer sample, reports settled changes only
+    void handleAccelerometer(float x, float y, float z);
+/* private - functions */
+private:
+    int quantizeOrientation(int angle) const;
+    void resetOrientation();
+    void setEventRate(int rateMs);
 /* public - member variables */
 public:
     android::sp<android::SensorEventQueue> mSensorEventQueue;
@@ -97,6 +104,14 @@ private:
     android::sp<android::Looper> mLooper;
     android::sp<SensorLooperThread> mSensorLooperThread;
     android::Mutex mLock;
+
+    android::Sensor const* mAccelerometer;
+    float mGravity[3];
+    bool mFilterPrimed;
+    int mOrientation;
+    int mCandidate;
+    int mCandidateCount;
+    int mStableCount;
 };
 
 } // namespace Camera
@@ -28,18 +28,52 @@ public:
     SwFrameDecoder();
     virtual ~SwFrameDecoder();
 
+    ///Upper bound for the number of frame-parallel decode threads
+    static const int MAX_DECODE_THREADS = 4;
+
 protected:
     virtual void doConfigure(const DecoderParameters& config);
     virtual void doProcessInputBuffer();
-    virtual status_t doStart() { return NO_ERROR; }
-    virtual void doStop() { }
-    virtual void doFlush() { }
+    virtual status_t doStart();
+    virtual void doStop();
+    virtual void doFlush();
     virtual void doRelease() { }
 
 private:
-    int mjpegWithHdrSize;
-    Decoder_libjpeg mJpgdecoder;
-    unsigned char* mJpegWithHeaderBuffer;
+    struct DecodeJob {
+        int inIndex;
+        int outIndex;
+        uint32_t sequence;
+    };
+
+    // Each thread owns its own libjpeg decoder and decodes whole frames
+    class DecodeThread : public android::Thread {
+    public:
+        DecodeThread(SwFrameDecoder* decoder) : Thread(false), mDecoder(decoder) { }
+
+        virtual bool threadLoop() {
+            return mDecoder->decodeNextFrame(mJpgdecoder);
+        }
+
+    private:
+        SwFrameDecoder* mDecoder;
+        Decoder_libjpeg mJpgdecoder;
+    };
+
+    bool decodeNextFrame(Decoder_libjpeg& jpgdecoder);
+    void publishFrame(const DecodeJob& job, bool decoded);
+
+    int mThreadCount;
+    android::Vector< android::sp<DecodeThread> > mThreads;
+
+    // Frames are decoded in any order but handed out in mJobSequence order
+    android::Mutex mJobLock;
+    android::Condition mJobCondition;
+    android::Condition mPublishCondition;
+    android::Vector<DecodeJob> mJobs;
+    uint32_t mJobSequence;
+    uint32_t mPublishSequence;
+    bool mExiting;
 };
 
 }  // namespace Camera
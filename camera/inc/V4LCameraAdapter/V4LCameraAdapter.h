@@ -26,6 +26,7 @@
 #include "DebugUtils.h"
 #include "Decoder_libjpeg.h"
 #include "FrameDecoder.h"
+#include "YuvConverter.h"
 
 
 namespace Ti {
@@ -105,6 +106,12 @@ public:
     ///Five second timeout
     static const int CAMERA_ADAPTER_TIMEOUT = 5000*1000;
 
+    ///Upper bound for a single poll() on the capture device, in milliseconds
+    static const int DEQUEUE_POLL_TIMEOUT_MS = 1000;
+
+    ///Line stride of the NV12 preview buffers handed over by the display
+    static const int PREVIEW_STRIDE = 4096;
+
 public:
 
     V4LCameraAdapter(size_t sensor_index, CameraHal* hal);
@@ -116,7 +123,7 @@ public:
 
     //APIs to configure Camera adapter and get the current parameter set
     virtual status_t setParameters(const android::CameraParameters& params);
-    virtual void getParameters(android::CameraParameters& params);
+    virtual void getParameters(CameraHalParameters& params);
 
     // API
     virtual status_t UseBuffersPreview(CameraBuffer *bufArr, int num);
@@ -164,6 +171,10 @@ private:
     status_t recalculateFPS();
 
     char * GetFrame(int &index, int &filledLen);
+    status_t waitForFrame(bool &deviceIdle);
+    void wakeDequeueThread();
+    status_t flushPendingBuffers();
+    void parkPreviewThread();
 
     int previewThread();
 
@@ -204,6 +215,7 @@ private:
     status_t restartPreview();
     status_t applyFpsValue();
     status_t returnBufferToV4L(int id);
+    status_t queueBufferToV4L(int id);
     void returnOutputBuffer(int index);
     bool isNeedToUseDecoder() const;
 
@@ -241,16 +253,30 @@ private:
     int mQueuedOutputBuffers;
 
     FrameDecoder* mDecoder;
+    YuvConverter* mYuvConverter;
     android::Vector< android::sp<MediaBuffer> > mInBuffers;
     android::Vector< android::sp<MediaBuffer> > mOutBuffers;
 
     android::Mutex mV4LLock;
 
+    // Buffers returned while streaming are queued back to the driver only
+    // by the thread sitting in GetFrame(), which is woken through mEventFd
+    int mEventFd;
+    // Guards mPendingQBufs, mDequeueStopped and mVideoInfo->isStreaming
+    android::Mutex mPendingQBufLock;
+    android::Vector<int> mPendingQBufs;
+    // Makes GetFrame() return so the device can be stopped from another thread
+    bool mDequeueStopped;
+    // Buffers lost because the dequeue thread could not queue them back
+    int mFailedQBufs;
+
     int mPixelFormat;
     int mFrameRate;
 
     android::Mutex mStopLock;
     android::Condition mStopCondition;
+    // Set by the preview thread once it has seen mPreviewing cleared
+    bool mPreviewThreadParked;
 
     CameraHal* mCameraHal;
     int mSkipFramesCount;
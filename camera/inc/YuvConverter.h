@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef YUV_CONVERTER_H
+#define YUV_CONVERTER_H
+
+#include <stdint.h>
+#include <utils/threads.h>
+#include <utils/Vector.h>
+
+#include "Common.h"
+
+namespace Ti {
+namespace Camera {
+
+enum Yuv422Layout {
+    YUV422_LAYOUT_YUYV,
+    YUV422_LAYOUT_UYVY
+};
+
+/**
+ * Converts interleaved YUV422 to NV12. Chroma is taken from the even rows.
+ * Strides are in bytes, so both plain and Tiler (4096 stride) buffers work.
+ */
+void convertYUV422ToNV12(const uint8_t *src, int srcStride,
+                         uint8_t *dstY, int dstYStride,
+                         uint8_t *dstUV, int dstUVStride,
+                         int width, int height, Yuv422Layout layout);
+
+/**
+ * Expands one interleaved YUV422 row to packed YUV444, as fed to libjpeg.
+ * Odd widths are not supported and leave dst untouched.
+ */
+void convertYUV422RowToYUV444(uint8_t *dst, const uint8_t *src, int width, Yuv422Layout layout);
+
+/**
+ * YUV422 to NV12 conversion split in row bands over a few helper threads.
+ * Helpers are only started once a frame is large enough to need them.
+ */
+class YuvConverter
+{
+public:
+    ///Bands below this number of rows are not worth a thread hand-off
+    static const int MIN_BAND_ROWS = 64;
+
+    ///Upper bound for the number of threads, caller included
+    static const int MAX_THREADS = 4;
+
+    YuvConverter(int threadCount);
+    ~YuvConverter();
+
+    void convertYUV422ToNV12(const uint8_t *src, int srcStride,
+                             uint8_t *dstY, int dstYStride,
+                             uint8_t *dstUV, int dstUVStride,
+                             int width, int height, Yuv422Layout layout);
+
+private:
+    struct Band {
+        const uint8_t *src;
+        int srcStride;
+        uint8_t *dstY;
+        int dstYStride;
+        uint8_t *dstUV;
+        int dstUVStride;
+        int width;
+        int height;
+        Yuv422Layout layout;
+    };
+
+    class BandThread : public android::Thread {
+    public:
+        BandThread() : Thread(false), mPending(false), mExiting(false) { }
+
+        void post(const Band& band);
+        void waitDone();
+        virtual void requestExit();
+        virtual bool threadLoop();
+
+    private:
+        android::Mutex mLock;
+        android::Condition mCondition;
+        Band mBand;
+        bool mPending;
+        bool mExiting;
+    };
+
+    static void convertBand(const Band& band);
+    status_t startThreads();
+
+    int mThreadCount;
+    android::Vector< android::sp<BandThread> > mThreads;
+    android::Mutex mLock;
+};
+
+} // namespace Camera
+} // namespace Ti
+
+#endif //YUV_CONVERTER_H